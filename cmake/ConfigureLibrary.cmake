@@ -13,3 +13,18 @@ target_link_libraries(${LIBRARY_NAME} PUBLIC ${libint2_LIBRARIES})
 
 # Inlude boost
 target_include_directories(${LIBRARY_NAME} PRIVATE ${Boost_INCLUDE_DIRS})
+
+# Include threads
+target_link_libraries(${LIBRARY_NAME} PUBLIC Threads::Threads)
+
+# Include zlib and zstd, if they were found
+if(ZLIB_FOUND)
+    target_link_libraries(${LIBRARY_NAME} PRIVATE ZLIB::ZLIB)
+    target_compile_definitions(${LIBRARY_NAME} PRIVATE LIBWINT_HAS_ZLIB)
+endif()
+
+if(ZSTD_FOUND)
+    target_include_directories(${LIBRARY_NAME} PRIVATE ${ZSTD_INCLUDE_DIR})
+    target_link_libraries(${LIBRARY_NAME} PRIVATE ${ZSTD_LIBRARY})
+    target_compile_definitions(${LIBRARY_NAME} PRIVATE LIBWINT_HAS_ZSTD)
+endif()
@@ -9,9 +9,23 @@ find_package(Eigen3 3.3 REQUIRED NO_MODULE)
 find_package(Boost REQUIRED)
 
 
+# Find the threads package - the integrals are calculated in parallel using std::thread
+find_package(Threads REQUIRED)
+
+
 # libint2 doesn't include a way to use find_package(libint2). Until then, we will use our custom Findlibint2.cmake-file, so that we can use find_package(libint2)
 find_package(libint2 REQUIRED)
 
 
 # Find the cpputil library
 find_package(cpputil 1.1.1 REQUIRED)
+
+
+# Find zlib and zstd (optional) - compressed integral files are decompressed while they are being parsed
+find_package(ZLIB)
+
+find_path(ZSTD_INCLUDE_DIR NAMES zstd.h)
+find_library(ZSTD_LIBRARY NAMES zstd)
+if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+    set(ZSTD_FOUND TRUE)
+endif()
@@ -2,9 +2,13 @@
 #define LIBWINT_BASIS_HPP
 
 
+#include <memory>
+
 #include <Eigen/Dense>
 #include <unsupported/Eigen/CXX11/Tensor>
 
+#include "LowRankERITensor.hpp"
+#include "MappedERITensor.hpp"
 #include "Molecule.hpp"
 
 
@@ -27,6 +31,16 @@ private:
     Eigen::MatrixXd V;  // The nuclear integrals matrix for the given basis and molecule
     Eigen::MatrixXd T;  // The kinetic integrals matrix for the given basis and molecule
     Eigen::Tensor<double, 4> g;  // The two-electron repulsion integrals tensor for the given basis and molecule
+    std::shared_ptr<const libwint::MappedERITensor> g_mapped;  // The memory-mapped two-electron repulsion integrals, if they are backed by a tensor file instead of g
+
+    size_t number_of_screened_quartets = 0;  // The number of shell quartets that were skipped by the Cauchy-Schwarz screening of g
+
+    std::string aux_basisset_name;  // The name of the auxiliary basis set of the density fitting factors (empty if they haven't been calculated)
+    libwint::LowRankERITensor B;  // The density fitting factors B^P_pq, such that (pq|rs) ~ sum_P B^P_pq B^P_rs
+
+    bool are_calculated_cholesky_vectors = false;
+    double cholesky_threshold = 0.0;  // The threshold with which the Cholesky vectors have been calculated
+    libwint::LowRankERITensor L;  // The Cholesky vectors L^J_pq, such that (pq|rs) ~ sum_J L^J_pq L^J_rs
 
 
 
@@ -39,14 +53,34 @@ public:
 
 
     // Getters
-    Eigen::MatrixXd get_S() const;
-    Eigen::MatrixXd get_T() const;
-    Eigen::MatrixXd get_V() const;
-    Eigen::Tensor<double, 4> get_g() const;
+    /**
+     *  The integrals are returned by reference, so that they aren't copied. Memory-mapped electron repulsion integrals (see mapElectronRepulsionIntegrals()) can only be accessed through get_g_view()
+     */
+    const Eigen::MatrixXd& get_S() const;
+    const Eigen::MatrixXd& get_T() const;
+    const Eigen::MatrixXd& get_V() const;
+    const Eigen::Tensor<double, 4>& get_g() const;
+    Eigen::TensorMap<const Eigen::Tensor<double, 4>> get_g_view() const;
+    bool is_mapped_g() const { return static_cast<bool>(this->g_mapped); }
+    size_t get_number_of_screened_quartets() const { return this->number_of_screened_quartets; }
+    const libwint::LowRankERITensor& get_B() const;
+    const libwint::LowRankERITensor& get_L() const;
+
+
+    // Release
+    /**
+     *  @return the electron repulsion integrals, which are moved out of this basis (so they aren't copied) and have to be calculated again to be accessed through this basis
+     *
+     *  Memory-mapped integrals are copied onto the heap, after which the mapping is released
+     */
+    Eigen::Tensor<double, 4> release_g();
 
 
+    // Methods
     /**
      *  Calculate and return the number of basis functions in the basis
+     *
+     *  If none of the integrals have been calculated yet, the number of basis functions is read off the libint basis set
      */
     size_t calculateNumberOfBasisFunctions() const;
 
@@ -67,8 +101,37 @@ public:
 
     /**
      *  Calculate and set the electron repulsion integrals, if they haven't been calculated already
+     *
+     *  Shell quartets whose Cauchy-Schwarz bound is smaller than @param: screening_threshold are skipped, i.e. their integrals are set to zero
+     *  The integrals are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+     */
+    void calculateElectronRepulsionIntegrals(double screening_threshold = 0.0, size_t number_of_threads = 0);
+
+    /**
+     *  Write the electron repulsion integrals to the tensor file @param: filename (see MappedERITensor), so that they can be mapped by other AOBasis instances
+     */
+    void saveElectronRepulsionIntegrals(const std::string& filename) const;
+
+    /**
+     *  Set the electron repulsion integrals by mapping the tensor file @param: filename (see MappedERITensor), instead of calculating them
+     *
+     *  The mapping is shared and read-only, so all the processes that map the same file share one copy of the integrals in the page cache. get_g_view() accesses the mapped integrals without copying them
+     */
+    void mapElectronRepulsionIntegrals(const std::string& filename);
+
+    /**
+     *  Calculate and set the density fitting factors B^P_pq = sum_Q (pq|Q) [(P|Q)^(-1/2)]_QP in the auxiliary basis with name @param: aux_basisset_name, if they haven't been calculated already in that auxiliary basis
+     *
+     *  The electron repulsion integrals are then approximated as (pq|rs) ~ sum_P B^P_pq B^P_rs, which can be reconstructed element- or blockwise by get_B(). The three-index integrals are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+     */
+    void calculateDensityFittingFactors(std::string aux_basisset_name, size_t number_of_threads = 0);
+
+    /**
+     *  Calculate and set the Cholesky vectors L^J_pq of the electron repulsion integrals, such that every element of (pq|rs) ~ sum_J L^J_pq L^J_rs has an error smaller than @param: threshold, if they haven't been calculated already with that threshold
+     *
+     *  The full tensor of the electron repulsion integrals is never calculated (see LibintCommunicator::calculateCholeskyVectors). The integral columns are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
      */
-    void calculateElectronRepulsionIntegrals();
+    void calculateCholeskyVectors(double threshold, size_t number_of_threads = 0);
 
     /**
      *  Calculate and set all the integrals, if they haven't been calculated already
@@ -0,0 +1,176 @@
+#ifndef LIBWINT_ERIFILE_HPP
+#define LIBWINT_ERIFILE_HPP
+
+
+#include "MappedFile.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unsupported/Eigen/CXX11/Tensor>
+
+
+
+namespace libwint {
+
+
+/*
+ *  A chunked binary file of two-electron integral blocks IN CHEMIST'S NOTATION, which is written and read in bounded memory
+ *
+ *  The file consists of
+ *      - a header: the magic string "LIBWINT\0", the format version, the number of orbitals K and the total number of blocks (all as uint64)
+ *      - a sequence of chunks, each of which starts with its size in bytes and its number of blocks (as uint64)
+ *  in which every block consists of its offsets (p, q, r, s) and dimensions (n_p, n_q, n_r, n_s) (as uint64), followed by its n_p n_q n_r n_s values in row-major order
+ *
+ *  The blocks are the canonical shell quartets of real orbitals, so a whole tensor is reconstructed by applying the 8-fold permutational symmetry. Blocks that aren't in the file (e.g. screened shell quartets) are zero.
+ */
+
+
+/**
+ *  A block (p q|r s) of two-electron integrals, which starts at the indices (p, q, r, s), has dimensions (n_p, n_q, n_r, n_s) and whose values are stored in row-major order
+ */
+struct ERIBlock {
+    size_t p, q, r, s;
+    size_t n_p, n_q, n_r, n_s;
+    const double* data;
+};
+
+
+/**
+ *  A writer for an ERI file, which uses two buffers of half the memory budget: while one is being filled, the other one is written to disk by a background thread
+ *
+ *  The file is written next to its destination, which is only replaced on close(): a calculation that fails (or is killed) partway doesn't leave an incomplete file, in which the missing blocks would read as screened ones
+ */
+class ERIFileWriter {
+private:
+    std::unique_ptr<libwint::ReplacingOutputFile> output_file;  // only created after the memory budget has been checked
+    const size_t K;  // the number of orbitals
+    const size_t chunk_size;  // the maximum number of bytes of the blocks in a chunk (i.e. the size of one buffer)
+
+    size_t number_of_blocks = 0;  // the total number of blocks that have been added
+    bool is_closed = false;
+
+    std::vector<char> active_buffer;  // the buffer that is being filled
+    size_t active_number_of_blocks = 0;
+    std::mutex active_mutex;  // serializes the additions to the active buffer
+
+    std::vector<char> pending_buffer;  // the buffer that is (waiting to be) written by the background thread
+    size_t pending_number_of_blocks = 0;
+    bool is_pending = false;  // if the pending buffer has to be written
+    bool should_stop = false;  // if the background thread should stop after writing the pending buffer
+    std::exception_ptr exception;  // the first exception that occurred in the background thread
+    std::mutex pending_mutex;
+    std::condition_variable pending_condition;
+
+    std::thread writer_thread;
+
+
+    /**
+     *  The loop of the background thread, which writes the pending buffers as a chunk
+     */
+    void writeLoop();
+
+    /**
+     *  Hand the active buffer over to the background thread, waiting for it to finish the previous one
+     */
+    void flushActiveBuffer();
+
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor that creates the file @param: filename for the integrals of @param: K orbitals, which will use at most @param: memory_budget bytes for its buffers
+     */
+    ERIFileWriter(const std::string& filename, size_t K, size_t memory_budget);
+
+    ERIFileWriter(const ERIFileWriter& writer) = delete;
+    ERIFileWriter& operator=(const ERIFileWriter& writer) = delete;
+
+
+    // Destructor
+    /**
+     *  Discard the file if it hasn't been closed, leaving the destination untouched
+     */
+    ~ERIFileWriter();
+
+
+    // Getters
+    size_t get_chunk_size() const { return this->chunk_size; }
+
+
+    // Static methods
+    /**
+     *  @return the number of bytes that a block with dimensions (@param: n_p, @param: n_q, @param: n_r, @param: n_s) takes in a chunk
+     */
+    static size_t blockSize(size_t n_p, size_t n_q, size_t n_r, size_t n_s);
+
+
+    // Methods
+    /**
+     *  Add the block starting at (@param: p, @param: q, @param: r, @param: s) with dimensions (@param: n_p, @param: n_q, @param: n_r, @param: n_s), whose values are given in row-major order by @param: data
+     *
+     *  This method can be called by multiple threads at the same time
+     */
+    void addBlock(size_t p, size_t q, size_t r, size_t s, size_t n_p, size_t n_q, size_t n_r, size_t n_s, const double* data);
+
+    /**
+     *  Write the remaining blocks, wait for the background thread, finish the file and replace the destination by it
+     *
+     *  If an error occurred while writing, it is rethrown
+     */
+    void close();
+};
+
+
+/**
+ *  A reader for an ERI file, which reads one chunk at a time
+ */
+class ERIFileReader {
+private:
+    const std::string filename;
+    size_t K;  // the number of orbitals
+    size_t number_of_blocks;  // the total number of blocks
+
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor that opens and checks the header of the ERI file @param: filename
+     */
+    explicit ERIFileReader(const std::string& filename);
+
+
+    // Getters
+    size_t get_K() const { return this->K; }
+    size_t get_number_of_blocks() const { return this->number_of_blocks; }
+
+
+    // Methods
+    /**
+     *  Call @param: callback for every block in the file, in the order in which they were written
+     *
+     *  Only one chunk is kept in memory at a time, so the block data is only valid during the call
+     */
+    void readBlocks(const std::function<void(const ERIBlock&)>& callback) const;
+
+    /**
+     *  @return the whole rank-four tensor of the two-electron integrals, in which the 8-fold permutational symmetry is applied to every block
+     */
+    Eigen::Tensor<double, 4> readTensor() const;
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_ERIFILE_HPP
@@ -0,0 +1,72 @@
+#ifndef LIBWINT_INCREMENTALJKBUILDER_HPP
+#define LIBWINT_INCREMENTALJKBUILDER_HPP
+
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Molecule.hpp"
+
+
+
+namespace libwint {
+
+
+/**
+ *  A builder for the Coulomb and exchange matrices J[D] and K[D] over the iterations of an SCF procedure, which only calculates the changes in J and K
+ *
+ *  Since J and K are linear in D, J[D] = J[D_previous] + J[D - D_previous] (and likewise for K). In the integral-direct calculation of J[ΔD] and K[ΔD], the shell quartets are screened by their Cauchy-Schwarz bound times the largest |ΔD| they are contracted with, so that most shell quartets are skipped when the density hardly changes.
+ *  The screening errors accumulate over the updates, so J and K are rebuilt from the full density matrices every few updates.
+ */
+class IncrementalJKBuilder {
+private:
+    const std::string basisset_name;
+    const std::vector<libint2::Atom> atoms;
+    const double screening_threshold;  // the threshold for the density-weighted Cauchy-Schwarz screening
+    const size_t rebuild_interval;  // the number of updates after which J and K are rebuilt from the full density matrices (0 meaning never)
+    const size_t number_of_threads;  // 0 means libwint's default (see threading::numberOfThreads)
+
+    size_t number_of_updates = 0;  // the number of updates since the last full build
+    size_t number_of_screened_quartets = 0;  // the number of shell quartets that were skipped in the last update
+
+    std::vector<Eigen::MatrixXd> D;  // the density matrices that J and K belong to
+    std::vector<Eigen::MatrixXd> J;  // the Coulomb matrices for every density matrix
+    std::vector<Eigen::MatrixXd> K;  // the exchange matrices for every density matrix
+
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor from a @param: molecule and a @param: basisset_name, together with the @param: screening_threshold for the density-weighted Cauchy-Schwarz screening, the @param: rebuild_interval (0 meaning never) and the @param: number_of_threads
+     */
+    IncrementalJKBuilder(const libwint::Molecule& molecule, std::string basisset_name, double screening_threshold = 1.0e-12, size_t rebuild_interval = 10, size_t number_of_threads = 0);
+
+
+    // Getters
+    const std::vector<Eigen::MatrixXd>& get_J() const { return this->J; }
+    const std::vector<Eigen::MatrixXd>& get_K() const { return this->K; }
+    size_t get_number_of_screened_quartets() const { return this->number_of_screened_quartets; }
+
+
+    // Methods
+    /**
+     *  Update J and K to the given symmetric AO density matrices @param: D
+     *
+     *  If there is no previous build, if the number of density matrices or their dimensions changed, or if the rebuild interval is reached, J and K are calculated from the full density matrices. Otherwise, only the changes in J and K are calculated from the density differences.
+     */
+    void update(const std::vector<Eigen::MatrixXd>& D);
+
+    /**
+     *  Forget the previous density matrices, so that the next update is a full build
+     */
+    void reset();
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_INCREMENTALJKBUILDER_HPP
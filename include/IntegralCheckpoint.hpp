@@ -0,0 +1,91 @@
+#ifndef LIBWINT_INTEGRALCHECKPOINT_HPP
+#define LIBWINT_INTEGRALCHECKPOINT_HPP
+
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "MappedFile.hpp"
+#include "PackedERITensor.hpp"
+
+
+
+namespace libwint {
+
+
+/**
+ *  A memory-mapped binary checkpoint of the integrals in a basis of K orbitals, which replaces parsing a text (FCIDUMP) file on every reload
+ *
+ *  The file consists of 8-byte words:
+ *      - the magic string "LWCHKPNT", the format version, K, the number of scalars and the number of matrices (uint64)
+ *      - the core energy and the scalars (double)
+ *      - the one-electron integrals (K^2 doubles, column-major)
+ *      - the unique two-electron integrals, as in a PackedERITensor
+ *      - for every matrix: its number of rows and columns (uint64) and its elements (column-major doubles)
+ *      - a checksum of all the preceding words (uint64)
+ *
+ *  The scalars and matrices hold any additional data of a basis (e.g. the Mulliken matrices of SOMullikenBasis). All the getters read the mapping directly, without copying.
+ */
+class IntegralCheckpoint {
+private:
+    std::shared_ptr<const libwint::MappedFile> mapped_file;
+
+    size_t K;  // the number of orbitals
+    double core_energy;
+    std::vector<double> scalars;
+    const double* h_data;  // the first one-electron integral in the mapping
+    const double* g_data;  // the first packed two-electron integral in the mapping
+    std::vector<Eigen::Map<const Eigen::MatrixXd>> matrices;  // the matrices in the mapping
+
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor that maps the checkpoint file @param: filename and verifies its checksum
+     */
+    explicit IntegralCheckpoint(const std::string& filename);
+
+
+    // Getters
+    size_t get_K() const { return this->K; }
+    double get_core_energy() const { return this->core_energy; }
+    const std::vector<double>& get_scalars() const { return this->scalars; }
+    const std::vector<Eigen::Map<const Eigen::MatrixXd>>& get_matrices() const { return this->matrices; }
+
+    /**
+     *  @return a read-only view of the one-electron integrals in the mapping
+     */
+    Eigen::Map<const Eigen::MatrixXd> get_h() const;
+
+    /**
+     *  @return a read-only view of the unique two-electron integrals in the mapping, in the order of PackedERITensor::compoundIndex
+     */
+    Eigen::Map<const Eigen::VectorXd> get_packed_g() const;
+
+
+    // Static methods
+    /**
+     *  Write the checkpoint file @param: filename for the @param: core_energy, the one-electron integrals @param: h, the unique two-electron integrals @param: g and any additional @param: scalars and @param: matrices
+     *
+     *  An existing file is replaced rather than overwritten (see ReplacingOutputFile), so checkpoints that are mapped from it stay valid
+     */
+    static void save(const std::string& filename, double core_energy, const Eigen::MatrixXd& h, const libwint::PackedERITensor& g, const std::vector<double>& scalars = {}, const std::vector<Eigen::MatrixXd>& matrices = {});
+
+    /**
+     *  @return the checksum of @param: number_of_words 8-byte words at @param: words, continuing from the checksum @param: hash of the preceding words
+     *
+     *  The checksum is a word-wise FNV-1a hash, so a file can be hashed in chunks
+     */
+    static uint64_t checksum(const uint64_t* words, size_t number_of_words, uint64_t hash = 14695981039346656037ULL);
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_INTEGRALCHECKPOINT_HPP
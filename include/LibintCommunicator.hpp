@@ -2,15 +2,39 @@
 #define LIBWINT_LIBINTCOMMUNICATOR_HPP
 
 
+#include <functional>
+#include <memory>
+#include <mutex>
+
 #include <libint2.hpp>
 #include <Eigen/Dense>
 #include <unsupported/Eigen/CXX11/Tensor>
 
+#include "LowRankERITensor.hpp"
+#include "TaskScheduler.hpp"
+
 
 
 namespace libwint {
 
 
+/**
+ *  A libint2::BasisSet for a given basis set name and list of atoms, together with the derived quantities that every integral calculation needs
+ */
+struct CachedBasisSet {
+    const libint2::BasisSet basisset;
+    const std::vector<size_t> shell2bf;  // maps shell index to bf index
+    const size_t nbf;  // the number of basis functions
+    const size_t max_nprim;  // the maximum number of primitives in a shell
+    const int max_l;  // the maximum angular momentum of a shell (libint2 requires an int)
+
+    /**
+     *  Constructor from a @param: basisset_name and @param: atoms, which reads the basis set library file and normalizes the shells
+     */
+    CachedBasisSet(const std::string& basisset_name, const std::vector<libint2::Atom>& atoms);
+};
+
+
 /**
  *  A singleton class that takes care of interfacing with the Libint2 (version >2.2.0) C++ API.
  *
@@ -18,6 +42,24 @@ namespace libwint {
  */
 class LibintCommunicator {
 private:
+    mutable std::vector<TaskScheduler::ThreadStatistics> thread_statistics;  // the thread statistics of the last (parallel) calculation of the two-body integrals
+    mutable std::mutex thread_statistics_mutex;  // the singleton can be used from several threads at once
+
+    // The most recently used basis sets, keyed by their name and atoms (atomic number and coordinates), so that the basis set library file isn't read and the shells aren't normalized for every integral calculation
+    struct BasisSetCacheEntry {
+        std::string basisset_name;
+        std::vector<double> atoms_key;
+        size_t last_used;
+        std::shared_ptr<const CachedBasisSet> basisset;
+    };
+    static const size_t basisset_cache_capacity = 32;  // the least recently used basis set is removed when the cache is full
+    mutable std::vector<BasisSetCacheEntry> basisset_cache;
+    mutable size_t basisset_cache_clock = 0;  // the number of cache lookups, which is used as a timestamp
+    mutable std::mutex basisset_cache_mutex;
+
+    static const size_t cholesky_column_cache_size = 256 * 1024 * 1024;  // the maximum number of bytes of the shell-pair columns that are kept during a Cholesky decomposition
+
+
     // Private constructor for the singleton class
     LibintCommunicator();
 
@@ -25,6 +67,29 @@ private:
     ~LibintCommunicator();
 
 
+    /**
+     *  Calculate the Cauchy-Schwarz bounds sqrt((12|12)) for all the shell pairs in a given @param: cached_basisset
+     */
+    Eigen::MatrixXd calculateSchwarzBounds(const CachedBasisSet& cached_basisset) const;
+
+    /**
+     *  Call @param: compute_quartet(thread_id, sh1, sh2, sh3, sh4) for all the canonical shell quartets (sh1 >= sh2, sh3 >= sh4, (sh1 sh2) >= (sh3 sh4)) of a given @param: cached_basisset, balanced over @param: number_of_threads threads by a work-stealing TaskScheduler
+     */
+    void computeCanonicalShellQuartets(const CachedBasisSet& cached_basisset, size_t number_of_threads, const std::function<void(size_t, size_t, size_t, size_t, size_t)>& compute_quartet) const;
+
+    /**
+     *  Calculate the columns (pq|rs) of the two-electron integrals for all the basis functions r in the shell @param: sh3 and s in the shell @param: sh4 of the given @param: cached_basisset, on @param: number_of_threads threads
+     *
+     *  @return the integrals as a (K^2 x n_3 n_4)-matrix, in which (pq|rs) is found at (p + K q, (r - r_0) + n_3 (s - s_0)), with r_0 and s_0 the first basis functions in the shells and n_3 the number of basis functions in sh3
+     */
+    Eigen::MatrixXd calculateTwoBodyIntegralColumns(const CachedBasisSet& cached_basisset, size_t sh3, size_t sh4, size_t number_of_threads) const;
+
+    /**
+     *  @return an estimate of the (relative) cost of a @param: shell in an integral calculation, based on its angular momentum and number of primitives
+     */
+    static double estimateShellCost(const libint2::Shell& shell);
+
+
 
 public:
     /**
@@ -38,16 +103,101 @@ public:
     void operator=(LibintCommunicator const& libint_communicator) = delete;
 
 
+    // Getters
+    /**
+     *  @return a copy of the busy and idle statistics of every thread in the last calculation of the two-body integrals
+     */
+    std::vector<TaskScheduler::ThreadStatistics> get_thread_statistics() const {
+        std::lock_guard<std::mutex> lock (this->thread_statistics_mutex);
+        return this->thread_statistics;
+    }
+
+
     // Methods
+    /**
+     *  @return the (cached) basis set with name @param: basisset_name for the given @param: atoms
+     *
+     *  The basis set is only constructed if it isn't in the cache already, which holds the most recently used basis sets
+     */
+    std::shared_ptr<const CachedBasisSet> getBasisSet(const std::string& basisset_name, const std::vector<libint2::Atom>& atoms) const;
+
+    /**
+     *  Remove all basis sets from the cache
+     */
+    void clearBasisSetCache() const;
+
     /**
      *  Calculate the one-body integrals associated to a given @param: operator_type for the given @param: atoms for the basisset with name @param: basisset_name
      */
     Eigen::MatrixXd calculateOneBodyIntegrals(libint2::Operator operator_type, std::string basisset_name, const std::vector<libint2::Atom>& atoms) const;
 
+    /**
+     *  Calculate the one-body integrals associated to all the given @param: operator_types for the given @param: atoms for the basisset with name @param: basisset_name
+     *
+     *  All the integrals are calculated in one sweep over the (lower triangle of the) shell pairs, and @return the matrices in the same order as the given operator types
+     */
+    std::vector<Eigen::MatrixXd> calculateOneBodyIntegrals(const std::vector<libint2::Operator>& operator_types, std::string basisset_name, const std::vector<libint2::Atom>& atoms) const;
+
     /**
      *  Calculate the two-body integrals IN CHEMIST'S NOTATION (11|22) for the given @param: atoms for the basisset with name @param: basisset_name
      */
     Eigen::Tensor<double, 4> calculateTwoBodyIntegrals(std::string basisset_name, const std::vector<libint2::Atom>& atoms) const;
+
+    /**
+     *  Calculate the two-body integrals IN CHEMIST'S NOTATION (11|22) for the given @param: atoms for the basisset with name @param: basisset_name
+     *
+     *  Shell quartets whose Cauchy-Schwarz bound is smaller than @param: screening_threshold are skipped (i.e. their integrals are zero), and their number is written to @param: number_of_screened_quartets
+     *
+     *  The shell quartets are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+     */
+    Eigen::Tensor<double, 4> calculateTwoBodyIntegrals(std::string basisset_name, const std::vector<libint2::Atom>& atoms, double screening_threshold, size_t& number_of_screened_quartets, size_t number_of_threads = 0) const;
+
+    /**
+     *  Calculate the two-body integrals IN CHEMIST'S NOTATION (11|22) for the given @param: atoms for the basisset with name @param: basisset_name, and write them block by block to the ERI file @param: filename (see ERIFileWriter), using at most @param: memory_budget bytes for the buffers
+     *
+     *  The buffers are written to disk by a background thread while the integrals are being calculated. Shell quartets whose Cauchy-Schwarz bound is smaller than @param: screening_threshold are skipped, and their number is written to @param: number_of_screened_quartets
+     *  The shell quartets are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+     */
+    void writeTwoBodyIntegrals(std::string basisset_name, const std::vector<libint2::Atom>& atoms, const std::string& filename, size_t memory_budget, double screening_threshold, size_t& number_of_screened_quartets, size_t number_of_threads = 0) const;
+
+    /**
+     *  Calculate the Coulomb matrices J[D]_pq = sum_rs (pq|rs) D_rs and the exchange matrices K[D]_pq = sum_rs (pr|qs) D_rs for the given symmetric AO density matrices @param: D, for the given @param: atoms for the basisset with name @param: basisset_name
+     *
+     *  @param: J and @param: K will contain a matrix for every density matrix
+     */
+    void calculateCoulombAndExchangeMatrices(std::string basisset_name, const std::vector<libint2::Atom>& atoms, const std::vector<Eigen::MatrixXd>& D, std::vector<Eigen::MatrixXd>& J, std::vector<Eigen::MatrixXd>& K) const;
+
+    /**
+     *  Calculate the Coulomb matrices J[D]_pq = sum_rs (pq|rs) D_rs and the exchange matrices K[D]_pq = sum_rs (pr|qs) D_rs for the given symmetric AO density matrices @param: D, for the given @param: atoms for the basisset with name @param: basisset_name
+     *
+     *  The two-electron integrals are contracted as soon as they are calculated (i.e. integral-direct), so the rank-4 tensor g is never stored. @param: J and @param: K will contain a matrix for every density matrix
+     *
+     *  Shell quartets whose Cauchy-Schwarz bound, multiplied by the largest density matrix element they are contracted with, is smaller than @param: screening_threshold are skipped, and their number is written to @param: number_of_screened_quartets
+     *  The shell quartets are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+     */
+    void calculateCoulombAndExchangeMatrices(std::string basisset_name, const std::vector<libint2::Atom>& atoms, const std::vector<Eigen::MatrixXd>& D, std::vector<Eigen::MatrixXd>& J, std::vector<Eigen::MatrixXd>& K, double screening_threshold, size_t& number_of_screened_quartets, size_t number_of_threads = 0) const;
+
+    /**
+     *  Calculate the two-index Coulomb integrals (P|Q) for the given @param: atoms for the (auxiliary) basisset with name @param: aux_basisset_name
+     */
+    Eigen::MatrixXd calculateTwoCenterIntegrals(std::string aux_basisset_name, const std::vector<libint2::Atom>& atoms) const;
+
+    /**
+     *  Calculate the three-index Coulomb integrals (P|pq) for the given @param: atoms, in which P runs over the (auxiliary) basisset with name @param: aux_basisset_name and p and q run over the basisset with name @param: basisset_name
+     *
+     *  @return the integrals as a (naux x K^2)-matrix, in which (P|pq) is found at (P, p + K q)
+     *  The auxiliary shells are distributed over @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+     */
+    Eigen::MatrixXd calculateThreeCenterIntegrals(std::string basisset_name, std::string aux_basisset_name, const std::vector<libint2::Atom>& atoms, size_t number_of_threads = 0) const;
+
+    /**
+     *  Calculate the Cholesky vectors of the two-electron integrals IN CHEMIST'S NOTATION for the given @param: atoms for the basisset with name @param: basisset_name, i.e. (pq|rs) ~ sum_J L^J_pq L^J_rs
+     *
+     *  The (pq|rs) supermatrix is decomposed by a pivoted incomplete Cholesky decomposition until the largest remaining diagonal element is smaller than @param: threshold, which bounds the error on every element
+     *  Only the diagonal and the columns of the selected pivots are calculated, on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+     *  The calculated columns are kept per shell pair until none of its pairs can become a pivot anymore, in a cache that is bounded by cholesky_column_cache_size bytes
+     */
+    libwint::LowRankERITensor calculateCholeskyVectors(std::string basisset_name, const std::vector<libint2::Atom>& atoms, double threshold, size_t number_of_threads = 0) const;
 };
 
 
@@ -0,0 +1,83 @@
+#ifndef LIBWINT_LOWRANKERITENSOR_HPP
+#define LIBWINT_LOWRANKERITENSOR_HPP
+
+
+#include <Eigen/Dense>
+#include <unsupported/Eigen/CXX11/Tensor>
+
+
+
+namespace libwint {
+
+
+/**
+ *  The two-electron repulsion integrals (IN CHEMIST'S NOTATION) in a factorized form
+ *
+ *      (pq|rs) = sum_P L^P_pq L^P_rs ,
+ *
+ *  as is given by density fitting (in which P runs over the auxiliary basis functions) or by a Cholesky decomposition (in which P runs over the Cholesky vectors)
+ *
+ *  The factors are stored as a (rank x K^2)-matrix L, in which the column p + K q holds the factors L^P_pq. Storage is O(K^2 rank) instead of O(K^4).
+ */
+class LowRankERITensor {
+private:
+    size_t K;  // the number of orbitals
+    Eigen::MatrixXd L;  // the factors, as a (rank x K^2)-matrix
+
+
+
+public:
+    // Constructors
+    /**
+     *  Default constructor for an empty (K = 0, rank = 0) tensor
+     */
+    LowRankERITensor();
+
+    /**
+     *  Constructor for @param: K orbitals from the factors @param: L, given as a (rank x K^2)-matrix in which the column p + K q holds the factors L^P_pq
+     */
+    LowRankERITensor(size_t K, const Eigen::MatrixXd& L);
+
+    /**
+     *  Constructor from a dense rank-four tensor @param: g (IN CHEMIST'S NOTATION), through a pivoted incomplete Cholesky decomposition of the (pq|rs) supermatrix, which stops when the largest remaining diagonal element is smaller than @param: threshold
+     *
+     *  Every element of the reconstructed tensor then has an error smaller than @param: threshold
+     */
+    LowRankERITensor(const Eigen::Tensor<double, 4>& g, double threshold);
+
+
+    // Getters
+    size_t get_K() const { return this->K; }
+    size_t get_rank() const { return static_cast<size_t>(this->L.rows()); }
+    const Eigen::MatrixXd& get_L() const { return this->L; }
+
+
+    // Operators
+    /**
+     *  @return the reconstructed element (pq|rs)
+     */
+    double operator()(size_t p, size_t q, size_t r, size_t s) const { return this->L.col(p + this->K * q).dot(this->L.col(r + this->K * s)); }
+
+
+    // Methods
+    /**
+     *  @return the reconstructed block (p q|r s) of the two-electron integrals, with dimensions (@param: n_p, @param: n_q, @param: n_r, @param: n_s), starting at the indices @param: p, @param: q, @param: r and @param: s
+     */
+    Eigen::Tensor<double, 4> reconstructBlock(size_t p, size_t q, size_t r, size_t s, size_t n_p, size_t n_q, size_t n_r, size_t n_s) const;
+
+    /**
+     *  @return the reconstructed dense rank-four tensor of the two-electron integrals
+     */
+    Eigen::Tensor<double, 4> toDense() const;
+
+    /**
+     *  Transform the factors according to the basis transformation matrix @param: T (i.e. L^P -> T^T L^P T for every P), which may be rectangular
+     */
+    void transform(const Eigen::MatrixXd& T);
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_LOWRANKERITENSOR_HPP
@@ -0,0 +1,70 @@
+#ifndef LIBWINT_MAPPEDERITENSOR_HPP
+#define LIBWINT_MAPPEDERITENSOR_HPP
+
+
+#include <memory>
+#include <string>
+
+#include <unsupported/Eigen/CXX11/Tensor>
+
+#include "MappedFile.hpp"
+
+
+
+namespace libwint {
+
+
+/**
+ *  A dense rank-four tensor of two-electron integrals that is backed by a memory-mapped file, instead of being allocated on the heap
+ *
+ *  The file consists of a header (the magic string "LWTENSOR", the format version and the dimension K, as uint64) followed by the K^4 elements in Eigen's (column-major) order, so that the mapped elements can be viewed directly through an Eigen::TensorMap.
+ *  Copies of a MappedERITensor share the same mapping.
+ */
+class MappedERITensor {
+private:
+    std::shared_ptr<const libwint::MappedFile> mapped_file;
+    size_t K;  // the dimension of the tensor
+    const double* data;  // the first element of the tensor in the mapping
+
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor that maps the tensor file @param: filename
+     */
+    explicit MappedERITensor(const std::string& filename);
+
+
+    // Getters
+    size_t get_K() const { return this->K; }
+
+
+    // Operators
+    /**
+     *  @return the element (pq|rs)
+     */
+    double operator()(size_t p, size_t q, size_t r, size_t s) const { return this->data[p + this->K * (q + this->K * (r + this->K * s))]; }
+
+
+    // Static methods
+    /**
+     *  Write the rank-four tensor @param: g to the tensor file @param: filename, so that it can be mapped
+     *
+     *  An existing file is replaced rather than overwritten (see ReplacingOutputFile), so its current mappings, possibly including g itself, stay valid
+     */
+    static void save(const std::string& filename, const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g);
+
+
+    // Methods
+    /**
+     *  @return a read-only view of the mapped tensor, which is valid as long as this MappedERITensor (or a copy) exists
+     */
+    Eigen::TensorMap<const Eigen::Tensor<double, 4>> get_view() const;
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_MAPPEDERITENSOR_HPP
@@ -0,0 +1,94 @@
+#ifndef LIBWINT_MAPPEDFILE_HPP
+#define LIBWINT_MAPPEDFILE_HPP
+
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+
+
+namespace libwint {
+
+
+/**
+ *  A read-only, shared memory mapping of a whole file (POSIX mmap), which is unmapped on destruction
+ *
+ *  Since the mapping is shared, all the processes that map the same file use the same pages in the page cache
+ */
+class MappedFile {
+private:
+    void* address;  // the start of the mapping (nullptr for an empty file)
+    size_t size;  // the size of the file in bytes
+
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor that maps the file @param: filename
+     */
+    explicit MappedFile(const std::string& filename);
+
+    MappedFile(const MappedFile& mapped_file) = delete;
+    MappedFile& operator=(const MappedFile& mapped_file) = delete;
+
+
+    // Destructor
+    ~MappedFile();
+
+
+    // Getters
+    const char* get_data() const { return static_cast<const char*>(this->address); }
+    size_t get_size() const { return this->size; }
+};
+
+
+/**
+ *  A binary output file that is written next to its destination and only replaces it on commit()
+ *
+ *  Replacing the destination by a rename, instead of truncating and rewriting it, leaves existing mappings (see MappedFile) of the old file intact: they keep the old inode, also when the new file is written from the mapped data itself
+ */
+class ReplacingOutputFile {
+private:
+    std::string filename;  // the destination
+    std::string temporary_filename;  // the file that is written, in the same directory as the destination so that it can be renamed
+    std::ofstream output_file_stream;
+    bool is_committed;
+
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor that creates a temporary file for the destination @param: filename
+     */
+    explicit ReplacingOutputFile(const std::string& filename);
+
+    ReplacingOutputFile(const ReplacingOutputFile& replacing_output_file) = delete;
+    ReplacingOutputFile& operator=(const ReplacingOutputFile& replacing_output_file) = delete;
+
+
+    // Destructor
+    /**
+     *  Remove the temporary file, if it hasn't been committed
+     */
+    ~ReplacingOutputFile();
+
+
+    // Getters
+    std::ofstream& get_stream() { return this->output_file_stream; }
+
+
+    // Methods
+    /**
+     *  Close the temporary file and rename it to the destination, throwing a std::runtime_error if anything went wrong while writing or renaming
+     */
+    void commit();
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_MAPPEDFILE_HPP
@@ -0,0 +1,116 @@
+#ifndef LIBWINT_PACKEDERITENSOR_HPP
+#define LIBWINT_PACKEDERITENSOR_HPP
+
+
+#include <Eigen/Dense>
+#include <unsupported/Eigen/CXX11/Tensor>
+
+
+
+namespace libwint {
+
+
+/**
+ *  The two-electron repulsion integrals (pq|rs) (IN CHEMIST'S NOTATION) of real orbitals, of which only the unique elements under the 8-fold permutational symmetry are stored
+ *
+ *  (pq|rs) = (qp|rs) = (pq|sr) = (qp|sr) = (rs|pq) = (sr|pq) = (rs|qp) = (sr|qp), so the element (pq|rs) is stored at the compound index [(pq)(rs)], in which
+ *      (pq) = p (p + 1) / 2 + q   for p >= q
+ *  is the triangular pair index, and [(pq)(rs)] is the triangular index of the pair ((pq), (rs)). Only about K^4 / 8 elements are stored for K orbitals.
+ */
+class PackedERITensor {
+private:
+    size_t K;  // the number of orbitals
+
+    Eigen::VectorXd data;  // the unique elements, in the order of their compound index
+
+
+
+public:
+    // Constructors
+    /**
+     *  Default constructor for an empty (K = 0) tensor
+     */
+    PackedERITensor();
+
+    /**
+     *  Constructor for a tensor of zeros for @param: K orbitals
+     */
+    explicit PackedERITensor(size_t K);
+
+    /**
+     *  Constructor from a dense rank-four tensor @param: g
+     *
+     *  Only the canonical elements (p >= q, r >= s, (pq) >= (rs)) are read, so @param: g is assumed to have the 8-fold permutational symmetry
+     */
+    explicit PackedERITensor(const Eigen::Tensor<double, 4>& g);
+
+    /**
+     *  Constructor from a view @param: g on a dense rank-four tensor (e.g. a memory-mapped one), which isn't copied
+     *
+     *  Only the canonical elements (p >= q, r >= s, (pq) >= (rs)) are read, so @param: g is assumed to have the 8-fold permutational symmetry
+     */
+    explicit PackedERITensor(const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g);
+
+
+    // Getters
+    size_t get_K() const { return this->K; }
+    const Eigen::VectorXd& get_data() const { return this->data; }
+    Eigen::VectorXd& get_data() { return this->data; }
+
+
+    // Operators
+    /**
+     *  @return the element (pq|rs) with @param: p, @param: q, @param: r and @param: s in any order of the 8-fold permutational symmetry
+     */
+    double operator()(size_t p, size_t q, size_t r, size_t s) const { return this->data(PackedERITensor::compoundIndex(p, q, r, s)); }
+
+    /**
+     *  @return a reference to the element (pq|rs), which is shared by all the permutationally equivalent elements
+     */
+    double& operator()(size_t p, size_t q, size_t r, size_t s) { return this->data(PackedERITensor::compoundIndex(p, q, r, s)); }
+
+
+    // Static methods
+    /**
+     *  @return the triangular pair index (pq) of the orbitals @param: p and @param: q, in any order
+     */
+    static size_t pairIndex(size_t p, size_t q) { return (p >= q) ? p * (p + 1) / 2 + q : q * (q + 1) / 2 + p; }
+
+    /**
+     *  @return the compound index [(pq)(rs)] of the element (pq|rs), in any order of the 8-fold permutational symmetry
+     */
+    static size_t compoundIndex(size_t p, size_t q, size_t r, size_t s) { return PackedERITensor::pairIndex(PackedERITensor::pairIndex(p, q), PackedERITensor::pairIndex(r, s)); }
+
+    /**
+     *  @return the number of elements that are stored for @param: K orbitals
+     */
+    static size_t numberOfElements(size_t K);
+
+    /**
+     *  @return the dense rank-four tensor for @param: K orbitals, in which every element of the unique elements @param: data (in the order of their compound index) is copied to its 8 permutationally equivalent positions
+     */
+    static Eigen::Tensor<double, 4> unpack(const Eigen::Ref<const Eigen::VectorXd>& data, size_t K);
+
+
+    // Methods
+    /**
+     *  @return the number of stored elements
+     */
+    size_t size() const { return static_cast<size_t>(this->data.size()); }
+
+    /**
+     *  @return the dense rank-four tensor, in which every stored element is copied to its 8 permutationally equivalent positions
+     */
+    Eigen::Tensor<double, 4> toDense() const;
+
+    /**
+     *  @return if this tensor is equal to @param: other, within a given @param: tolerance
+     */
+    bool isApprox(const PackedERITensor& other, double tolerance = 1.0e-12) const;
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_PACKEDERITENSOR_HPP
@@ -2,9 +2,16 @@
 #define LIBWINT_SOBASIS_HPP
 
 
+#include <functional>
+#include <memory>
+
 #include <Eigen/Dense>
 
 #include "AOBasis.hpp"
+#include "IntegralCheckpoint.hpp"
+#include "MappedERITensor.hpp"
+#include "THCERITensor.hpp"
+#include "io.hpp"
 #include "transformations.hpp"
 
 
@@ -17,6 +24,9 @@ protected:
 
     Eigen::MatrixXd h_SO;  // the one-electron integrals (core Hamiltonian) in the spatial orbital basis
     Eigen::Tensor<double, 4> g_SO;  // the two-electron repulsion integrals in the spatial orbital basis
+    std::shared_ptr<const libwint::MappedERITensor> g_SO_mapped;  // the memory-mapped two-electron repulsion integrals, if they are backed by a tensor file instead of g_SO
+    double core_energy = 0.0;  // the core energy (e.g. the internuclear repulsion energy) that is read from an FCIDUMP file, or the energy of the frozen core orbitals of an active space
+    libwint::io::ParseStatistics parse_statistics;  // the amount of text that was parsed for the integrals and the time it took
 
 
     // Methods
@@ -24,8 +34,34 @@ protected:
      *  Parse a given FCIDUMP file for the one- and two-electron integrals
      */
     void parseFCIDUMPFile(std::string fcidump_filename);
-    void parseOne(std::string fcidump_filename);
-    void parseTwo(std::string fcidump_filename);
+
+    /**
+     *  Parse the one- or two-electron integrals from the files fcidump_filename.one and fcidump_filename.two, on @param: number_of_threads threads (0 meaning libwint's default)
+     */
+    void parseOne(std::string fcidump_filename, size_t number_of_threads = 0);
+    void parseTwo(std::string fcidump_filename, size_t number_of_threads = 0);
+
+    /**
+     *  Parse an integral file @param: filename, in which every line holds @param: number_of_indices (1-based) orbital indices followed by the value of an integral, and call @param: set_integral(indices, value) for every integral whose indices are all non-zero, in the order of the file
+     *
+     *  The file is split into chunks of lines, which are parsed on @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads)
+     */
+    void parseIntegralFile(const std::string& filename, size_t number_of_indices, const std::function<void(const size_t*, double)>& set_integral, size_t number_of_threads = 0);
+
+    /**
+     *  If the two-electron integrals are memory-mapped, copy them into g_SO, so that they can be modified
+     */
+    void materializeTwoElectronIntegrals();
+
+    /**
+     *  @return the unique two-electron integrals under the 8-fold permutational symmetry
+     */
+    libwint::PackedERITensor packTwoElectronIntegrals() const;
+
+    /**
+     *  Set the core energy and the one- and two-electron integrals from a given @param: checkpoint
+     */
+    void loadIntegrals(const libwint::IntegralCheckpoint& checkpoint);
 
 
 
@@ -36,6 +72,13 @@ public:
      */
     SOBasis(const libwint::AOBasis& ao_basis, const Eigen::MatrixXd& C);
 
+    /**
+     *  Constructor for the active space that is spanned by the orbitals @param: C_active, in which the doubly occupied orbitals @param: C_core are frozen, based on a given @param: ao_basis (every column of C_core and C_active represents a spatial orbital, e.g. C.leftCols(n_core) and C.middleCols(n_core, n_active))
+     *
+     *  The one-electron integrals are the inactive Fock matrix in the active orbitals (see transformations::calculateInactiveFockMatrix), the core energy is the energy of the core orbitals and the two-electron integrals are only transformed to the active orbitals, which costs O(K^4 n_active) instead of O(K^5)
+     */
+    SOBasis(const libwint::AOBasis& ao_basis, const Eigen::MatrixXd& C_core, const Eigen::MatrixXd& C_active);
+
     explicit SOBasis(size_t K) : K(K){};
 
     /**
@@ -46,17 +89,69 @@ public:
     virtual void copy(SOBasis x) {
         this->h_SO = x.h_SO;
         this->g_SO = x.g_SO;
+        this->g_SO_mapped = x.g_SO_mapped;
+        this->core_energy = x.core_energy;
     };
 
     // Getters
     const size_t get_K() const { return this->K; }
+    double get_core_energy() const { return this->core_energy; }
+    const libwint::io::ParseStatistics& get_parse_statistics() const { return this->parse_statistics; }
     virtual Eigen::MatrixXd get_h_SO() const { return this->h_SO; }
-    Eigen::Tensor<double, 4> get_g_SO() const { return this->g_SO; }
+    const Eigen::Tensor<double, 4>& get_g_SO() const;  // memory-mapped integrals can only be accessed through get_g_SO_view()
+    Eigen::TensorMap<const Eigen::Tensor<double, 4>> get_g_SO_view() const;
+    bool is_mapped_g_SO() const { return static_cast<bool>(this->g_SO_mapped); }
     virtual double get_h_SO(size_t i, size_t j) const { return this->h_SO(i,j); }
-    double get_g_SO(size_t i, size_t j, size_t k, size_t l) const { return this->g_SO(i,j,k,l); }
+    double get_g_SO(size_t i, size_t j, size_t k, size_t l) const { return this->g_SO_mapped ? (*this->g_SO_mapped)(i,j,k,l) : this->g_SO(static_cast<long>(i), static_cast<long>(j), static_cast<long>(k), static_cast<long>(l)); }
+
+
+    // Release
+    /**
+     *  @return the one-electron integrals, which are moved out of this basis (so they aren't copied), leaving it with an empty matrix
+     */
+    Eigen::MatrixXd release_h_SO();
+
+    /**
+     *  @return the two-electron integrals, which are moved out of this basis (so they aren't copied), leaving it with an empty tensor
+     *
+     *  Memory-mapped integrals are copied onto the heap, after which the mapping is released
+     */
+    Eigen::Tensor<double, 4> release_g_SO();
 
 
     // Methods
+    /**
+     *  Write the two-electron integrals to the tensor file @param: filename (see MappedERITensor), so that they can be mapped by other SOBasis instances
+     */
+    void saveTwoElectronIntegrals(const std::string& filename) const;
+
+    /**
+     *  Replace the two-electron integrals by a shared, read-only mapping of the tensor file @param: filename (see MappedERITensor)
+     *
+     *  All the processes that map the same file share one copy of the integrals in the page cache. A transformation of the integrals copies them onto the heap first
+     */
+    void mapTwoElectronIntegrals(const std::string& filename);
+
+    /**
+     *  Write the core energy and the one- and two-electron integrals to the binary checkpoint file @param: filename (see IntegralCheckpoint)
+     *
+     *  Loading a checkpoint is much faster than parsing an FCIDUMP file, so a text file only has to be parsed once
+     */
+    virtual void saveCheckpoint(const std::string& filename) const;
+
+    /**
+     *  Set the core energy and the one- and two-electron integrals from the binary checkpoint file @param: filename (see IntegralCheckpoint), which is memory-mapped and verified against its checksum
+     */
+    virtual void loadCheckpoint(const std::string& filename);
+
+    /**
+     *  Write the integrals to the FCIDUMP file @param: fcidump_filename for a system of @param: number_of_electrons electrons (with MS2=0 and all the orbitals in the totally symmetric irrep)
+     *
+     *  Only the symmetry-unique two-electron integrals (pq|rs) (p >= q, r >= s, (pq) >= (rs)) and one-electron integrals h_pq (p >= q) whose absolute value is larger than @param: threshold are written, followed by the core energy. The file is streamed through an io::BufferedWriter, so an existing file is only replaced once the new one has been written completely
+     *  See saveCheckpoint() for a binary alternative
+     */
+    void writeFCIDUMPFile(const std::string& fcidump_filename, size_t number_of_electrons, double threshold = 0.0) const;
+
     /**
      *  Transform the one- and two-electron integrals according to the basis transformation matrix @param T
      */
@@ -67,6 +162,20 @@ public:
  *  Transform the one- and two-electron integrals according to the Jacobi rotation parameters p, q and a given angle theta in radians.
  */
     virtual void rotateJacobi(size_t p, size_t q, double theta);
+
+    /**
+     *  Transform the one- and two-electron integrals according to the given sequence of Jacobi @param: rotations, which are applied in order
+     *
+     *  The two-electron integrals are updated in one blocked pass per index for the whole sequence (see transformations::rotateTwoElectronIntegralsJacobiInPlace). For long sequences, the rotations are accumulated into one transformation matrix instead
+     */
+    virtual void rotateJacobi(const std::vector<libwint::transformations::JacobiRotationParameters>& rotations);
+
+    /**
+     *  @return the tensor hypercontraction (pq|rs) ~ sum_PQ X_pP X_qP Z_PQ X_rQ X_sQ of the two-electron integrals, fitted from their Cholesky decomposition with @param: threshold, and with at most @param: max_number_of_points points (0 meaning no limit)
+     *
+     *  See THCERITensor for the details of the fit; THCERITensor::validate(this->get_g_SO()) reports its error
+     */
+    libwint::THCERITensor calculateTHCFactorization(double threshold = 1.0e-06, size_t max_number_of_points = 0) const;
 };
 
 
@@ -48,6 +48,8 @@ public:
         }
         this->h_SO = x.h_SO;
         this->g_SO = x.g_SO;
+        this->g_SO_mapped = x.g_SO_mapped;
+        this->core_energy = x.core_energy;
         this->lagrange_multiplier = x.lagrange_multiplier;
         this->C= x.C;
         this->S= x.S;
@@ -60,15 +62,30 @@ public:
      */
     void rotateJacobi(size_t p, size_t q, double theta) override;
 
+    /**
+     *  Transform the one- and two-electron integrals (mulliken "integrals" as well) according to the given sequence of Jacobi @param: rotations, which are applied in order
+     */
+    void rotateJacobi(const std::vector<libwint::transformations::JacobiRotationParameters>& rotations) override;
+
+    /**
+     *  Write the integrals, together with the Lagrange multiplier, C, S and the Mulliken matrix, to the binary checkpoint file @param: filename (see IntegralCheckpoint)
+     */
+    void saveCheckpoint(const std::string& filename) const override;
+
+    /**
+     *  Set the integrals, the Lagrange multiplier, C, S and the Mulliken matrix from the binary checkpoint file @param: filename that was written by an SOMullikenBasis
+     */
+    void loadCheckpoint(const std::string& filename) override;
+
     // Setter
     void set_lagrange_multiplier(double lagrange_multiplier) { this->lagrange_multiplier = lagrange_multiplier; }
     void set_S(Eigen::MatrixXd S) { this->S = S; }
     void set_C(Eigen::MatrixXd C) { this->C = C; }
     // GETTERS
-    Eigen::MatrixXd get_mulliken_matrix() { return mulliken_matrix; }
-    Eigen::MatrixXd get_C() { return C; }
-    Eigen::MatrixXd get_S() { return S; }
-    double get_lagrange_multiplier() { return lagrange_multiplier; }
+    const Eigen::MatrixXd& get_mulliken_matrix() const { return mulliken_matrix; }
+    const Eigen::MatrixXd& get_C() const { return C; }
+    const Eigen::MatrixXd& get_S() const { return S; }
+    double get_lagrange_multiplier() const { return lagrange_multiplier; }
 
 
 
@@ -0,0 +1,100 @@
+#ifndef LIBWINT_THCERITENSOR_HPP
+#define LIBWINT_THCERITENSOR_HPP
+
+
+#include <Eigen/Dense>
+#include <unsupported/Eigen/CXX11/Tensor>
+
+#include "LowRankERITensor.hpp"
+
+
+
+namespace libwint {
+
+
+/**
+ *  The two-electron repulsion integrals (IN CHEMIST'S NOTATION) in a tensor hypercontracted (THC) form
+ *
+ *      (pq|rs) = sum_PQ X_pP X_qP Z_PQ X_rQ X_sQ ,
+ *
+ *  in which P and Q run over N_P 'points'. Storage is O(K N_P + N_P^2).
+ */
+class THCERITensor {
+public:
+    struct ValidationReport {
+        size_t number_of_points = 0;  // the number of THC points N_P
+        double max_error = 0.0;  // the largest absolute error of the reconstructed elements
+        double rms_error = 0.0;  // the root-mean-square error of the reconstructed elements
+    };
+
+
+private:
+    size_t K;  // the number of orbitals
+    Eigen::MatrixXd X;  // the (K x N_P) 'collocation' matrix
+    Eigen::MatrixXd Z;  // the (N_P x N_P) core matrix
+
+
+    /**
+     *  @return the (N_P x n_p n_q)-matrix of the point products X_pP X_qP for the orbital pairs in the block starting at @param: p and @param: q, with dimensions @param: n_p and @param: n_q, in which the pairs are ordered like the (column-major) indices of the block
+     */
+    Eigen::MatrixXd calculatePairProducts(size_t p, size_t q, size_t n_p, size_t n_q) const;
+
+
+
+public:
+    // Constructors
+    /**
+     *  Default constructor for an empty (K = 0, N_P = 0) tensor
+     */
+    THCERITensor();
+
+    /**
+     *  Constructor from the (K x N_P) collocation matrix @param: X and the (N_P x N_P) core matrix @param: Z
+     */
+    THCERITensor(const Eigen::MatrixXd& X, const Eigen::MatrixXd& Z);
+
+    /**
+     *  Constructor from the low-rank (density-fitted or Cholesky-decomposed) two-electron integrals @param: g, through a least-squares THC fit
+     *
+     *  The candidate points are the eigenvectors u of the factors L^J = sum_u lambda_u u u^T. From the candidates with |lambda_u| >= @param: threshold, the points are chosen by a pivoted Cholesky decomposition of their weighted overlaps |lambda_u| |lambda_v| (u^T v)^2, until the largest remaining diagonal element is smaller than @param: threshold^2, or until @param: max_number_of_points points are chosen (0 meaning no limit)
+     *  The core matrix is then the least-squares solution Z = S^(-1) E S^(-1), with S_PQ = (X^T X)_PQ^2 and E_PQ = sum_pqrs X_pP X_qP (pq|rs) X_rQ X_sQ
+     */
+    THCERITensor(const libwint::LowRankERITensor& g, double threshold, size_t max_number_of_points = 0);
+
+
+    // Getters
+    size_t get_K() const { return this->K; }
+    size_t get_number_of_points() const { return static_cast<size_t>(this->X.cols()); }
+    const Eigen::MatrixXd& get_X() const { return this->X; }
+    const Eigen::MatrixXd& get_Z() const { return this->Z; }
+
+
+    // Operators
+    /**
+     *  @return the reconstructed element (pq|rs)
+     */
+    double operator()(size_t p, size_t q, size_t r, size_t s) const;
+
+
+    // Methods
+    /**
+     *  @return the reconstructed block (p q|r s) of the two-electron integrals, with dimensions (@param: n_p, @param: n_q, @param: n_r, @param: n_s), starting at the indices @param: p, @param: q, @param: r and @param: s
+     */
+    Eigen::Tensor<double, 4> reconstructBlock(size_t p, size_t q, size_t r, size_t s, size_t n_p, size_t n_q, size_t n_r, size_t n_s) const;
+
+    /**
+     *  @return the reconstructed dense rank-four tensor of the two-electron integrals
+     */
+    Eigen::Tensor<double, 4> toDense() const;
+
+    /**
+     *  @return the maximum and root-mean-square error of the reconstructed two-electron integrals with respect to the dense two-electron integrals @param: g
+     */
+    ValidationReport validate(const Eigen::Tensor<double, 4>& g) const;
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_THCERITENSOR_HPP
@@ -0,0 +1,68 @@
+#ifndef LIBWINT_TASKSCHEDULER_HPP
+#define LIBWINT_TASKSCHEDULER_HPP
+
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+
+
+namespace libwint {
+
+
+/**
+ *  A scheduler that runs a set of independent tasks on a number of threads and balances the load through work stealing
+ *
+ *  Every task comes with an estimated cost. Before running, the tasks are dealt out over the threads' own queues, most expensive first, each time to the thread with the smallest total cost so far. A thread runs the tasks in its own queue from the front (i.e. the expensive ones first), and when that queue is exhausted, it steals tasks from the back (i.e. the cheap ones) of the other threads' queues.
+ */
+class TaskScheduler {
+public:
+    struct ThreadStatistics {
+        size_t number_of_tasks = 0;  // the number of tasks that were run by this thread
+        size_t number_of_stolen_tasks = 0;  // the number of tasks this thread stole from other threads
+        double busy_time = 0.0;  // the time (in seconds) this thread spent running tasks
+        double idle_time = 0.0;  // the time (in seconds) this thread spent looking for tasks or waiting for the other threads to finish
+    };
+
+
+private:
+    struct Task {
+        double cost;  // the estimated cost of the task, in arbitrary units
+        std::function<void(size_t)> function;  // the task itself, which is called with the id of the thread that runs it
+    };
+
+    std::vector<Task> tasks;  // the tasks that haven't been run yet
+    std::vector<ThreadStatistics> statistics;  // the statistics for every thread of the last run
+
+
+
+public:
+    // Getters
+    const std::vector<ThreadStatistics>& get_statistics() const { return this->statistics; }
+
+
+    // Methods
+    /**
+     *  Add a @param: task (that will be called with the id of the thread that runs it) with an estimated @param: cost
+     */
+    void addTask(double cost, const std::function<void(size_t)>& task);
+
+    /**
+     *  @return the number of tasks that haven't been run yet
+     */
+    size_t numberOfTasks() const { return this->tasks.size(); }
+
+    /**
+     *  Run all the added tasks on @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads), wait for them to finish and update the thread statistics
+     *
+     *  The scheduler is empty afterwards. If any of the tasks throws, the first exception is rethrown after all the threads have finished.
+     */
+    void run(size_t number_of_threads = 0);
+};
+
+
+}  // namespace libwint
+
+
+#endif  // LIBWINT_TASKSCHEDULER_HPP
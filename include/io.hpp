@@ -0,0 +1,332 @@
+#ifndef LIBWINT_IO_HPP
+#define LIBWINT_IO_HPP
+
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+
+
+namespace libwint {
+namespace io {
+
+
+/**
+ *  The amount of text that was parsed and the time it took
+ */
+struct ParseStatistics {
+    size_t number_of_bytes = 0;
+    size_t number_of_lines = 0;
+    double elapsed_seconds = 0.0;
+
+    /**
+     *  @return the parsing throughput in MB/s
+     */
+    double throughput() const { return (this->elapsed_seconds > 0.0) ? static_cast<double>(this->number_of_bytes) / this->elapsed_seconds / 1.0e06 : 0.0; }
+
+    ParseStatistics& operator+=(const ParseStatistics& other);
+};
+
+
+/**
+ *  Parse the floating point number at @param: begin, which can't extend beyond @param: end, into @param: value
+ *
+ *  Both E and D (Fortran double precision) exponents are accepted, in upper or lower case. The result is correctly rounded, like std::strtod.
+ *
+ *  @return a pointer to the first character after the number, or nullptr if there isn't a number at @param: begin
+ */
+const char* parseDouble(const char* begin, const char* end, double& value);
+
+/**
+ *  Parse the unsigned integer at @param: begin, which can't extend beyond @param: end, into @param: value
+ *
+ *  @return a pointer to the first character after the integer, or nullptr if there isn't an integer at @param: begin or if it overflows a size_t
+ */
+const char* parseIndex(const char* begin, const char* end, size_t& value);
+
+
+/**
+ *  Format @param: value in scientific notation with 17 significant digits (like printf's %.16e) into @param: buffer, which should hold at least 32 characters
+ *
+ *  The digits are calculated in extended precision rather than through printf. The (rare) values for which extended precision can't guarantee correctly rounded digits are formatted by printf, so the result is always the same as printf's, and parses back to exactly @param: value
+ *
+ *  @return the number of characters that were written
+ */
+size_t formatDouble(double value, char* buffer);
+
+
+/**
+ *  Split the text [@param: begin, @param: end) into chunks of whole lines of about @param: chunk_size bytes
+ *
+ *  @return the boundaries of the chunks: chunk i is [boundaries[i], boundaries[i+1]), and every boundary except the first is just after a newline (or at the end)
+ */
+std::vector<const char*> splitAtNewlines(const char* begin, const char* end, size_t chunk_size);
+
+
+/**
+ *  A hand-written line-oriented scanner over a text buffer [begin, end), which avoids the locale and stream overhead of std::istringstream
+ */
+class Scanner {
+private:
+    const char* position;  // the next character to be read
+    const char* end;
+    size_t line_number;  // the (1-based) number of the current line
+
+
+public:
+    // Constructors
+    Scanner(const char* begin, const char* end) : position (begin), end (end), line_number (1) {}
+
+
+    // Getters
+    const char* get_position() const { return this->position; }
+    size_t get_line_number() const { return this->line_number; }
+
+
+    // Methods
+    /**
+     *  @return if all the characters have been read
+     */
+    bool atEnd() const { return this->position == this->end; }
+
+    /**
+     *  @return if the scanner is at the end of a line (or at the end of the buffer)
+     */
+    bool atEndOfLine() const { return (this->position == this->end) || (*this->position == '\n'); }
+
+    /**
+     *  Skip spaces, tabs and carriage returns, but not newlines
+     */
+    void skipBlanks() {
+        while ((this->position != this->end) && ((*this->position == ' ') || (*this->position == '\t') || (*this->position == '\r'))) {
+            this->position++;
+        }
+    }
+
+    /**
+     *  Skip the rest of the current line, including its newline
+     */
+    void skipLine();
+
+    /**
+     *  Skip the blanks and parse the next floating point number into @param: value
+     *
+     *  @return if a number was parsed
+     */
+    bool readDouble(double& value);
+
+    /**
+     *  Skip the blanks and parse the next unsigned integer into @param: value
+     *
+     *  @return if an integer was parsed
+     */
+    bool readIndex(size_t& value);
+};
+
+
+/**
+ *  A buffered writer of text to a file, which only writes to disk in large chunks
+ *
+ *  The text is written next to the file, which is only replaced on close(): a writer that is destroyed without being closed (e.g. because writing failed) leaves no truncated file behind
+ */
+class BufferedWriter {
+private:
+    libwint::ReplacingOutputFile output_file;
+    std::ofstream& output_file_stream;
+    std::vector<char> buffer;
+    size_t size;  // the number of characters in the buffer
+
+
+    /**
+     *  Write the buffer to disk
+     */
+    void flush();
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor that creates the file @param: filename, with a buffer of @param: buffer_size characters
+     */
+    explicit BufferedWriter(const std::string& filename, size_t buffer_size = 1 << 20);
+
+    BufferedWriter(const BufferedWriter& writer) = delete;
+    BufferedWriter& operator=(const BufferedWriter& writer) = delete;
+
+
+    // Methods
+    /**
+     *  Append @param: number_of_characters characters at @param: characters
+     */
+    void write(const char* characters, size_t number_of_characters);
+
+    /**
+     *  Append the string @param: text
+     */
+    void write(const std::string& text) { this->write(text.data(), text.size()); }
+
+    /**
+     *  Append a double @param: value with 17 significant digits (see formatDouble), right-aligned in a field of @param: width characters
+     */
+    void writeDouble(double value, size_t width = 0);
+
+    /**
+     *  Append an unsigned integer @param: value, right-aligned in a field of @param: width characters
+     */
+    void writeIndex(size_t value, size_t width = 0);
+
+    /**
+     *  Write the buffer to disk, close the file and replace the destination by it
+     */
+    void close();
+};
+
+
+/**
+ *  The compression formats of integral files
+ */
+enum class Compression {
+    none,
+    gzip,
+    zstd
+};
+
+
+/**
+ *  @return the compression of the file @param: filename, as detected from its first bytes
+ */
+Compression detectCompression(const std::string& filename);
+
+/**
+ *  @return if libwint was built with support for the given @param: compression (i.e. with zlib for gzip and with libzstd for zstd)
+ */
+bool isSupported(Compression compression);
+
+/**
+ *  @return @param: filename if it exists, otherwise the first existing compressed variant (@param: filename.gz or @param: filename.zst), or @param: filename if none of those exist
+ */
+std::string resolveFilename(const std::string& filename);
+
+/**
+ *  @return the whole (decompressed) contents of the file @param: filename
+ */
+std::string readFile(const std::string& filename);
+
+
+/**
+ *  A reader of the (decompressed) text of a file in chunks of whole lines
+ *
+ *  A background thread reads and decompresses the file while the chunks are being parsed, and hands over the chunks through a bounded queue, so that at most a few chunks are held in memory
+ */
+class DecompressingReader {
+private:
+    const std::string filename;
+    const Compression compression;
+    const size_t chunk_size;  // the (approximate) number of characters in a chunk
+    const size_t queue_capacity;  // the maximum number of chunks that are waiting to be read
+
+    std::deque<std::vector<char>> queue;
+    bool is_finished = false;  // if the background thread has queued all the chunks (or failed)
+    bool is_stopped = false;  // if the background thread should stop early
+    std::exception_ptr error;  // the exception thrown by the background thread, if any
+    std::mutex queue_mutex;
+    std::condition_variable queue_condition;
+
+    std::thread decompression_thread;
+
+
+    /**
+     *  The loop of the background thread, which reads and decompresses the file into chunks
+     */
+    void decompress();
+
+    /**
+     *  Queue the whole lines in @param: text, and keep the last (incomplete) line in @param: text. If @param: is_last, all the text is queued
+     *
+     *  @return false if the reader has been stopped
+     */
+    bool queueLines(std::vector<char>& text, bool is_last);
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor that starts reading the file @param: filename, in chunks of about @param: chunk_size characters, of which at most @param: queue_capacity wait to be read
+     */
+    explicit DecompressingReader(const std::string& filename, size_t chunk_size = 1 << 22, size_t queue_capacity = 4);
+
+    DecompressingReader(const DecompressingReader& reader) = delete;
+    DecompressingReader& operator=(const DecompressingReader& reader) = delete;
+
+
+    // Destructor
+    ~DecompressingReader();
+
+
+    // Getters
+    Compression get_compression() const { return this->compression; }
+
+
+    // Methods
+    /**
+     *  Wait for the next chunk of whole lines and move it into @param: chunk. Errors of the background thread are rethrown
+     *
+     *  @return false if all the chunks have been read
+     */
+    bool read(std::vector<char>& chunk);
+};
+
+
+/**
+ *  A reader of the text of a plain or compressed file in chunks of whole lines
+ *
+ *  Plain files are memory-mapped and split without copying, compressed files are decompressed by a DecompressingReader
+ */
+class LineChunkReader {
+private:
+    std::unique_ptr<libwint::MappedFile> mapped_file;  // for plain files
+    std::vector<const char*> boundaries;  // the boundaries of the chunks of the mapped file
+    size_t next_chunk = 0;
+
+    std::unique_ptr<DecompressingReader> reader;  // for compressed files
+
+    size_t number_of_bytes = 0;  // the number of characters that have been read
+
+
+public:
+    // Constructors
+    /**
+     *  Constructor for the file @param: filename, which will be read in chunks of about @param: chunk_size characters
+     */
+    LineChunkReader(const std::string& filename, size_t chunk_size);
+
+
+    // Getters
+    size_t get_number_of_bytes() const { return this->number_of_bytes; }
+
+
+    // Methods
+    /**
+     *  Read the next chunk [@param: begin, @param: end), using @param: storage for decompressed text. The chunk stays valid as long as @param: storage isn't changed
+     *
+     *  @return false if all the chunks have been read
+     */
+    bool read(const char*& begin, const char*& end, std::vector<char>& storage);
+};
+
+
+}  // namespace io
+}  // namespace libwint
+
+
+#endif  // LIBWINT_IO_HPP
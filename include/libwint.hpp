@@ -5,10 +5,21 @@
 
 // This file acts as a collective include header
 #include "AOBasis.hpp"
+#include "ERIFile.hpp"
+#include "IncrementalJKBuilder.hpp"
+#include "IntegralCheckpoint.hpp"
 #include "LibintCommunicator.hpp"
+#include "LowRankERITensor.hpp"
+#include "MappedERITensor.hpp"
+#include "MappedFile.hpp"
 #include "Molecule.hpp"
+#include "PackedERITensor.hpp"
 #include "SOMullikenBasis.hpp"
 #include "SOBasis.hpp"
+#include "TaskScheduler.hpp"
+#include "THCERITensor.hpp"
+#include "io.hpp"
+#include "threading.hpp"
 #include "transformations.hpp"
 #include "version.hpp"
 
@@ -0,0 +1,33 @@
+#ifndef LIBWINT_THREADING_HPP
+#define LIBWINT_THREADING_HPP
+
+
+#include <cstddef>
+#include <functional>
+
+
+
+namespace libwint {
+namespace threading {
+
+
+/**
+ *  @return the number of threads that should be used when @param: number_of_threads threads are requested:
+ *      - a non-zero request is honoured as such
+ *      - a zero request falls back to the environment variable LIBWINT_NUM_THREADS, or to the number of hardware threads if that variable isn't set
+ */
+size_t numberOfThreads(size_t number_of_threads = 0);
+
+/**
+ *  Run @param: worker(thread_id) on @param: number_of_threads threads (thread_id = 0, ..., number_of_threads - 1) and wait for all of them to finish
+ *
+ *  The worker with thread_id 0 runs on the calling thread. If any of the workers throws, the first exception is rethrown after all the threads have been joined.
+ */
+void parallelFor(size_t number_of_threads, const std::function<void(size_t)>& worker);
+
+
+}  // namespace threading
+}  // namespace libwint
+
+
+#endif  // LIBWINT_THREADING_HPP
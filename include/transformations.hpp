@@ -1,9 +1,13 @@
 #ifndef LIBWINT_TRANSFORMATIONS_HPP
 #define LIBWINT_TRANSFORMATIONS_HPP
 
+#include <vector>
+
 #include <Eigen/Dense>
 #include <unsupported/Eigen/CXX11/Tensor>
 
+#include "PackedERITensor.hpp"
+
 
 
 namespace libwint {
@@ -42,8 +46,24 @@ Eigen::MatrixXd transformOneElectronIntegrals(const Eigen::MatrixXd& h, const Ei
  *      B' = B T ,
  *
  *  where the basis vectors are collected as elements of a row vector.
+ *
+ *  T may be rectangular (K x M), in which case the transformed tensor has dimension M. The transformation is done one index (quarter) at a time, and every quarter transformation is one matrix product on a matrix view of the (partially transformed) tensor:
+ *      (a, bcd) -> (bcd, P) -> (cdP, Q) -> (dPQ, R) -> (PQR, S)
+ *  i.e. the first index is contracted with T and the new index is appended at the end, so no shuffles are needed. The intermediates alternate between two scratch buffers
  */
 Eigen::Tensor<double, 4> transformTwoElectronIntegrals(const Eigen::Tensor<double, 4>& g, const Eigen::MatrixXd& T);
+Eigen::Tensor<double, 4> transformTwoElectronIntegrals(const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g, const Eigen::MatrixXd& T);
+
+/**
+ *  Transform the two-electron integrals @param: g, which should have the 8-fold permutational symmetry, with the (K x M) transformation matrix @param: T (as in transformTwoElectronIntegrals), and @return only the unique transformed integrals (pq|rs) with p >= q, r >= s and (pq) >= (rs)
+ *
+ *  The transformation works on pair-packed intermediates, in two halves:
+ *      1) for every AO pair (ab) with a >= b, the K x K matrix (..|ab) is transformed into T^T (..|ab) T, of which only the pairs (pq) with p >= q are kept
+ *      2) for every pair (pq), the symmetric K x K matrix (pq|..) is transformed into T^T (pq|..) T, of which only the pairs (rs) with r >= s and (rs) <= (pq) are kept
+ *  which takes about half the flops and a quarter of the intermediate memory of the full transformation. The pairs are distributed over @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+ */
+libwint::PackedERITensor transformTwoElectronIntegralsPacked(const Eigen::Tensor<double, 4>& g, const Eigen::MatrixXd& T, size_t number_of_threads = 0);
+libwint::PackedERITensor transformTwoElectronIntegralsPacked(const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g, const Eigen::MatrixXd& T, size_t number_of_threads = 0);
 
 
 
@@ -74,12 +94,40 @@ Eigen::MatrixXd transform_SO_to_AO(const Eigen::MatrixXd& f_SO, const Eigen::Mat
  *  transform and return the two-electron integrals in the SO basis
  */
 Eigen::Tensor<double, 4> transform_AO_to_SO(const Eigen::Tensor<double, 4>& g_AO, const Eigen::MatrixXd& C);
+Eigen::Tensor<double, 4> transform_AO_to_SO(const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g_AO, const Eigen::MatrixXd& C);
+
+
+/*
+ *  ACTIVE SPACES
+ */
+
+/**
+ *  @return the inactive Fock matrix F_I = h + J[D] - 1/2 K[D] in the AO basis, for the AO one-electron integrals @param: h_AO, the AO two-electron integrals @param: g_AO and the doubly occupied core orbitals @param: C_core (every column represents a spatial orbital)
+ *
+ *  D = 2 C_core C_core^T is the core density matrix, J[D]_ab = sum_cd (ab|cd) D_cd and K[D]_ab = sum_cd (ac|bd) D_cd
+ */
+Eigen::MatrixXd calculateInactiveFockMatrix(const Eigen::MatrixXd& h_AO, const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g_AO, const Eigen::MatrixXd& C_core);
+
+/**
+ *  @return the energy of the doubly occupied core orbitals @param: C_core, i.e. E_core = 1/2 tr(D (h_AO + F_I)) with D = 2 C_core C_core^T, for the AO one-electron integrals @param: h_AO and the inactive Fock matrix @param: F_I (see calculateInactiveFockMatrix)
+ */
+double calculateCoreEnergy(const Eigen::MatrixXd& h_AO, const Eigen::MatrixXd& F_I, const Eigen::MatrixXd& C_core);
+
 
 
 /*
  *  JACOBI ROTATIONS AND WRAPPERS
  */
 
+/**
+ *  The parameters of a Jacobi rotation with an angle (in radians) of the orbitals p and q (p < q)
+ */
+struct JacobiRotationParameters {
+    size_t p;
+    size_t q;
+    double angle;
+};
+
 /**
  *  Check the given Jacobi rotation parameters for invalid arguments:
  *      p < q
@@ -99,6 +147,11 @@ void checkJacobiParameters(size_t p, size_t q, const Eigen::MatrixXd& h);
  */
 Eigen::MatrixXd jacobiRotationMatrix(size_t p, size_t q, double theta, size_t M);
 
+/**
+ *  Give the M-dimensional product J_1 J_2 ... J_n of the Jacobi rotation matrices for the given sequence of @param: rotations, i.e. the transformation matrix that applies the rotations in the given order
+ */
+Eigen::MatrixXd jacobiRotationMatrix(const std::vector<JacobiRotationParameters>& rotations, size_t M);
+
 /**
  *  Using a Jacobi rotation with angle @param: theta (in radians) of the orbitals p and q, return the transformed one-electron integrals.
  *  This function is implemented using Eigen's Jacobi module.
@@ -107,10 +160,34 @@ Eigen::MatrixXd rotateOneElectronIntegralsJacobi(const Eigen::MatrixXd& h, size_
 
 /**
  *  Using a Jacobi rotation with angle @param: theta (in radians) of the orbitals p and q, return the transformed two-electron integrals.
- *  While waiting for an analogous Eigen::Tensor Jacobi module, this function is just a wrapper around transformTwoElectronIntegrals using a Jacobi rotation matrix.
+ *  This function is a wrapper around rotateTwoElectronIntegralsJacobiInPlace on a copy of @param: g.
  */
 Eigen::Tensor<double, 4> rotateTwoElectronIntegralsJacobi(const Eigen::Tensor<double, 4>& g, size_t p, size_t q, double theta);
 
+/**
+ *  Using a Jacobi rotation with angle @param: theta (in radians) of the orbitals p and q, transform the one-electron integrals @param: h in place
+ */
+void rotateOneElectronIntegralsJacobiInPlace(Eigen::MatrixXd& h, size_t p, size_t q, double theta);
+
+/**
+ *  Using a Jacobi rotation with angle @param: theta (in radians) of the orbitals p and q, transform the two-electron integrals @param: g in place
+ *
+ *  A Jacobi rotation only mixes the slices p and q of every index, so the rotation is applied to one index at a time, updating only the O(K^3) elements that have that index equal to p or q. No Jacobi rotation matrix or intermediate tensor is needed
+ */
+void rotateTwoElectronIntegralsJacobiInPlace(Eigen::Tensor<double, 4>& g, size_t p, size_t q, double theta);
+
+/**
+ *  Apply the given sequence of Jacobi @param: rotations, in order, to the one-electron integrals @param: h in place
+ */
+void rotateOneElectronIntegralsJacobiInPlace(Eigen::MatrixXd& h, const std::vector<JacobiRotationParameters>& rotations);
+
+/**
+ *  Apply the given sequence of Jacobi @param: rotations, in order, to the two-electron integrals @param: g in place
+ *
+ *  For every index, the tensor is walked through once in cache-sized blocks, to which all the rotations are applied before moving on to the next block. The whole sequence therefore costs four passes over g, instead of four passes per rotation
+ */
+void rotateTwoElectronIntegralsJacobiInPlace(Eigen::Tensor<double, 4>& g, const std::vector<JacobiRotationParameters>& rotations);
+
 
 
 }  // namespace transformations
@@ -1,5 +1,7 @@
 #include "AOBasis.hpp"
 
+#include <utility>
+
 #include "LibintCommunicator.hpp"
 
 
@@ -24,7 +26,7 @@ AOBasis::AOBasis(const libwint::Molecule& molecule, std::string basisset_name) :
  *  GETTERS
  */
 
-Eigen::MatrixXd AOBasis::get_S() const {
+const Eigen::MatrixXd& AOBasis::get_S() const {
 
     if (!this->are_calculated_overlap_integrals) {
         throw std::logic_error("You haven't calculated the overlap integrals yet and are trying to access them.");
@@ -33,7 +35,7 @@ Eigen::MatrixXd AOBasis::get_S() const {
     }
 }
 
-Eigen::MatrixXd AOBasis::get_T() const {
+const Eigen::MatrixXd& AOBasis::get_T() const {
 
     if (!this->are_calculated_kinetic_integrals) {
         throw std::logic_error("You haven't calculated the kinetic integrals yet and are trying to access them.");
@@ -42,7 +44,7 @@ Eigen::MatrixXd AOBasis::get_T() const {
     }
 }
 
-Eigen::MatrixXd AOBasis::get_V() const {
+const Eigen::MatrixXd& AOBasis::get_V() const {
 
     if (!this->are_calculated_nuclear_integrals) {
         throw std::logic_error("You haven't calculated the nuclear integrals yet and are trying to access them.");
@@ -51,15 +53,76 @@ Eigen::MatrixXd AOBasis::get_V() const {
     }
 }
 
-Eigen::Tensor<double, 4> AOBasis::get_g() const {
+const Eigen::Tensor<double, 4>& AOBasis::get_g() const {
 
     if (!this->are_calculated_electron_repulsion_integrals) {
         throw std::logic_error("You haven't calculated the electron repulsion integrals yet and are trying to access them.");
+    } else if (this->g_mapped) {
+        throw std::logic_error("The electron repulsion integrals are memory-mapped, and can only be accessed through get_g_view().");
     } else {
         return this->g;
     }
 };
 
+Eigen::TensorMap<const Eigen::Tensor<double, 4>> AOBasis::get_g_view() const {
+
+    if (!this->are_calculated_electron_repulsion_integrals) {
+        throw std::logic_error("You haven't calculated the electron repulsion integrals yet and are trying to access them.");
+    } else if (this->g_mapped) {
+        return this->g_mapped->get_view();
+    } else {
+        return Eigen::TensorMap<const Eigen::Tensor<double, 4>> (this->g.data(), this->g.dimensions());
+    }
+}
+
+const libwint::LowRankERITensor& AOBasis::get_B() const {
+
+    if (this->aux_basisset_name.empty()) {
+        throw std::logic_error("You haven't calculated the density fitting factors yet and are trying to access them.");
+    } else {
+        return this->B;
+    }
+}
+
+const libwint::LowRankERITensor& AOBasis::get_L() const {
+
+    if (!this->are_calculated_cholesky_vectors) {
+        throw std::logic_error("You haven't calculated the Cholesky vectors yet and are trying to access them.");
+    } else {
+        return this->L;
+    }
+}
+
+
+
+/*
+ *  RELEASE
+ */
+
+/**
+ *  @return the electron repulsion integrals, which are moved out of this basis (so they aren't copied) and have to be calculated again to be accessed through this basis
+ *
+ *  Memory-mapped integrals are copied onto the heap, after which the mapping is released
+ */
+Eigen::Tensor<double, 4> AOBasis::release_g() {
+
+    if (!this->are_calculated_electron_repulsion_integrals) {
+        throw std::logic_error("You haven't calculated the electron repulsion integrals yet and are trying to access them.");
+    }
+
+    Eigen::Tensor<double, 4> g;
+    if (this->g_mapped) {
+        g = this->g_mapped->get_view();
+        this->g_mapped.reset();
+    } else {
+        g = std::move(this->g);
+        this->g = Eigen::Tensor<double, 4>();  // a moved-from tensor is empty, but make sure
+    }
+
+    this->are_calculated_electron_repulsion_integrals = false;
+    this->number_of_screened_quartets = 0;
+    return g;
+}
 
 
 /*
@@ -68,6 +131,8 @@ Eigen::Tensor<double, 4> AOBasis::get_g() const {
 
 /**
  * Calculate and return the number of basis functions in the basis
+ *
+ * If none of the integrals have been calculated yet, the number of basis functions is read off the (cached) libint basis set
  */
 size_t AOBasis::calculateNumberOfBasisFunctions() const {
 
@@ -82,10 +147,10 @@ size_t AOBasis::calculateNumberOfBasisFunctions() const {
         return static_cast<size_t>(this->V.cols());
     }
     else if (this->are_calculated_electron_repulsion_integrals) {
-        return static_cast<size_t>(this->g.dimension(0));
+        return static_cast<size_t>(this->get_g_view().dimension(0));
     }
     else {
-        throw std::runtime_error("None of the integrals have been calculated yet, so I can't figure out how many basis functions there are.");
+        return libwint::LibintCommunicator::get().getBasisSet(this->basisset_name, this->atoms)->nbf;
     }
 }
 
@@ -133,12 +198,15 @@ void AOBasis::calculateNuclearIntegrals() {
 
 
 /**
- *  Calculate and set the kinetic integrals, if they haven't been calculated already
+ *  Calculate and set the electron repulsion integrals, if they haven't been calculated already
+ *
+ *  Shell quartets whose Cauchy-Schwarz bound is smaller than @param: screening_threshold are skipped, i.e. their integrals are set to zero
+ *  The integrals are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
  */
-void AOBasis::calculateElectronRepulsionIntegrals() {
+void AOBasis::calculateElectronRepulsionIntegrals(double screening_threshold, size_t number_of_threads) {
 
     if (!this->are_calculated_electron_repulsion_integrals) {
-        this -> g = libwint::LibintCommunicator::get().calculateTwoBodyIntegrals(this->basisset_name, this->atoms);
+        this -> g = libwint::LibintCommunicator::get().calculateTwoBodyIntegrals(this->basisset_name, this->atoms, screening_threshold, this->number_of_screened_quartets, number_of_threads);
         this->are_calculated_electron_repulsion_integrals = true;
     } else {
         std::cout << "The two-electron repulsion integrals have already been calculated in this basis ..." << std::endl;
@@ -146,13 +214,139 @@ void AOBasis::calculateElectronRepulsionIntegrals() {
 };
 
 
+/**
+ *  Write the electron repulsion integrals to the tensor file @param: filename (see MappedERITensor), so that they can be mapped by other AOBasis instances
+ */
+void AOBasis::saveElectronRepulsionIntegrals(const std::string& filename) const {
+
+    libwint::MappedERITensor::save(filename, this->get_g_view());
+}
+
+
+/**
+ *  Set the electron repulsion integrals by mapping the tensor file @param: filename (see MappedERITensor), instead of calculating them
+ *
+ *  The mapping is shared and read-only, so all the processes that map the same file share one copy of the integrals in the page cache. get_g_view() accesses the mapped integrals without copying them
+ */
+void AOBasis::mapElectronRepulsionIntegrals(const std::string& filename) {
+
+    if (this->are_calculated_electron_repulsion_integrals) {
+        std::cout << "The two-electron repulsion integrals have already been calculated in this basis ..." << std::endl;
+        return;
+    }
+
+    auto g_mapped = std::make_shared<const libwint::MappedERITensor>(filename);
+
+    // A mapped tensor should belong to this basis
+    const size_t K = g_mapped->get_K();
+    if (K != this->calculateNumberOfBasisFunctions()) {
+        throw std::invalid_argument("The dimension of the given tensor file is inconsistent with the number of basis functions.");
+    }
+
+    this->g_mapped = g_mapped;
+    this->g = Eigen::Tensor<double, 4>();  // release any heap storage
+    this->are_calculated_electron_repulsion_integrals = true;
+}
+
+
+/**
+ *  Calculate and set the density fitting factors B^P_pq = sum_Q (pq|Q) [(P|Q)^(-1/2)]_QP in the auxiliary basis with name @param: aux_basisset_name, if they haven't been calculated already in that auxiliary basis
+ *
+ *  The electron repulsion integrals are then approximated as (pq|rs) ~ sum_P B^P_pq B^P_rs, which can be reconstructed element- or blockwise by get_B(). The three-index integrals are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+ */
+void AOBasis::calculateDensityFittingFactors(std::string aux_basisset_name, size_t number_of_threads) {
+
+    if (this->aux_basisset_name == aux_basisset_name) {
+        std::cout << "The density fitting factors have already been calculated in this auxiliary basis ..." << std::endl;
+        return;
+    }
+
+    const auto& communicator = libwint::LibintCommunicator::get();
+    Eigen::MatrixXd V = communicator.calculateTwoCenterIntegrals(aux_basisset_name, this->atoms);  // (P|Q)
+    Eigen::MatrixXd three_index_integrals = communicator.calculateThreeCenterIntegrals(this->basisset_name, aux_basisset_name, this->atoms, number_of_threads);  // (P|pq)
+
+    // Auxiliary basis sets can be nearly linearly dependent, so we calculate (P|Q)^(-1/2) through its eigenvalue decomposition, dropping the (nearly) zero eigenvalues
+    const double linear_dependency_threshold = 1.0e-10;
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigensolver (V);
+    const Eigen::VectorXd& eigenvalues = eigensolver.eigenvalues();  // in increasing order
+
+    long number_of_dropped = 0;
+    while ((number_of_dropped < eigenvalues.size()) && (eigenvalues(number_of_dropped) < linear_dependency_threshold)) {
+        number_of_dropped++;
+    }
+    const long rank = eigenvalues.size() - number_of_dropped;
+
+    //  B = (P|Q)^(-1/2) (Q|pq), with (P|Q)^(-1/2) = U Lambda^(-1/2) U^T for the retained eigenpairs (Lambda, U), such that the rows of B are indexed by the auxiliary functions P and B^T B = (pq|P) (P|Q)^(-1) (Q|rs)
+    const auto& retained_eigenvectors = eigensolver.eigenvectors().rightCols(rank);
+    Eigen::VectorXd inverse_sqrt_eigenvalues = eigenvalues.tail(rank).cwiseSqrt().cwiseInverse();
+    Eigen::MatrixXd fitted_factors = retained_eigenvectors * (inverse_sqrt_eigenvalues.asDiagonal() * (retained_eigenvectors.transpose() * three_index_integrals));
+
+    this->B = libwint::LowRankERITensor(communicator.getBasisSet(this->basisset_name, this->atoms)->nbf, fitted_factors);
+    this->aux_basisset_name = aux_basisset_name;
+}
+
+
+/**
+ *  Calculate and set the Cholesky vectors L^J_pq of the electron repulsion integrals, such that every element of (pq|rs) ~ sum_J L^J_pq L^J_rs has an error smaller than @param: threshold, if they haven't been calculated already with that threshold
+ *
+ *  The full tensor of the electron repulsion integrals is never calculated (see LibintCommunicator::calculateCholeskyVectors). The integral columns are calculated on @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+ */
+void AOBasis::calculateCholeskyVectors(double threshold, size_t number_of_threads) {
+
+    if (!this->are_calculated_cholesky_vectors || (this->cholesky_threshold != threshold)) {
+        this->L = libwint::LibintCommunicator::get().calculateCholeskyVectors(this->basisset_name, this->atoms, threshold, number_of_threads);
+        this->cholesky_threshold = threshold;
+        this->are_calculated_cholesky_vectors = true;
+    } else {
+        std::cout << "The Cholesky vectors have already been calculated with this threshold ..." << std::endl;
+    }
+}
+
+
 /**
  *  Calculate and set all the integrals, if they haven't been calculated already
  */
 void AOBasis::calculateIntegrals() {
-    calculateOverlapIntegrals();
-    calculateKineticIntegrals();
-    calculateNuclearIntegrals();
+
+    // The one-electron integrals that haven't been calculated yet are calculated together, in one sweep over the shell pairs
+    std::vector<libint2::Operator> operator_types;
+    if (!this->are_calculated_overlap_integrals) {
+        operator_types.push_back(libint2::Operator::overlap);
+    }
+    if (!this->are_calculated_kinetic_integrals) {
+        operator_types.push_back(libint2::Operator::kinetic);
+    }
+    if (!this->are_calculated_nuclear_integrals) {
+        operator_types.push_back(libint2::Operator::nuclear);
+    }
+
+    if (!operator_types.empty()) {
+        auto matrices = libwint::LibintCommunicator::get().calculateOneBodyIntegrals(operator_types, this->basisset_name, this->atoms);
+
+        for (size_t i = 0; i < operator_types.size(); i++) {
+            switch (operator_types[i]) {
+                case libint2::Operator::overlap: {
+                    this->S = std::move(matrices[i]);
+                    this->are_calculated_overlap_integrals = true;
+                    break;
+                }
+                case libint2::Operator::kinetic: {
+                    this->T = std::move(matrices[i]);
+                    this->are_calculated_kinetic_integrals = true;
+                    break;
+                }
+                case libint2::Operator::nuclear: {
+                    this->V = std::move(matrices[i]);
+                    this->are_calculated_nuclear_integrals = true;
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+        }
+    }
+
     calculateElectronRepulsionIntegrals();
 }
 
@@ -0,0 +1,394 @@
+#include "ERIFile.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+
+
+namespace libwint {
+
+
+namespace {
+
+const char eri_file_magic[8] = {'L', 'I', 'B', 'W', 'I', 'N', 'T', '\0'};
+const uint64_t eri_file_version = 1;
+const size_t eri_file_header_size = 4 * sizeof(uint64_t);  // the magic, the version, K and the number of blocks
+const size_t eri_chunk_header_size = 2 * sizeof(uint64_t);  // the size in bytes and the number of blocks
+const size_t eri_block_header_size = 8 * sizeof(uint64_t);  // the offsets and the dimensions
+
+}  // anonymous namespace
+
+
+
+/*
+ *  ERIFILEWRITER
+ */
+
+/*
+ *  PRIVATE METHODS
+ */
+
+/**
+ *  The loop of the background thread, which writes the pending buffers as a chunk
+ */
+void ERIFileWriter::writeLoop() {
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock (this->pending_mutex);
+            this->pending_condition.wait(lock, [this] { return this->is_pending || this->should_stop; });
+
+            if (!this->is_pending) {  // should_stop and nothing left to write
+                return;
+            }
+        }
+
+        // The pending buffer isn't touched by the other threads while is_pending is set, so we can write it without holding the lock
+        try {
+            if (!this->exception) {
+                uint64_t chunk_header[2] = {static_cast<uint64_t>(this->pending_buffer.size()), static_cast<uint64_t>(this->pending_number_of_blocks)};
+                this->output_file->get_stream().write(reinterpret_cast<const char*>(chunk_header), eri_chunk_header_size);
+                this->output_file->get_stream().write(this->pending_buffer.data(), static_cast<std::streamsize>(this->pending_buffer.size()));
+
+                if (!this->output_file->get_stream().good()) {
+                    throw std::runtime_error("Something went wrong while writing the ERI file. Maybe the disk is full?");
+                }
+            }
+        } catch (...) {
+            this->exception = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock (this->pending_mutex);
+            this->pending_buffer.clear();
+            this->is_pending = false;
+        }
+        this->pending_condition.notify_all();
+    }
+}
+
+
+/**
+ *  Hand the active buffer over to the background thread, waiting for it to finish the previous one
+ */
+void ERIFileWriter::flushActiveBuffer() {
+
+    if (this->active_number_of_blocks == 0) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock (this->pending_mutex);
+        this->pending_condition.wait(lock, [this] { return !this->is_pending; });
+
+        if (this->exception) {
+            std::rethrow_exception(this->exception);
+        }
+
+        this->active_buffer.swap(this->pending_buffer);
+        this->pending_number_of_blocks = this->active_number_of_blocks;
+        this->is_pending = true;
+    }
+    this->pending_condition.notify_all();
+
+    this->active_buffer.clear();
+    this->active_number_of_blocks = 0;
+}
+
+
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Constructor that creates the file @param: filename for the integrals of @param: K orbitals, which will use at most @param: memory_budget bytes for its buffers
+ */
+ERIFileWriter::ERIFileWriter(const std::string& filename, size_t K, size_t memory_budget) :
+    K (K),
+    chunk_size (memory_budget / 2)
+{
+    // Check the memory budget before creating the (temporary) file
+    if (this->chunk_size < ERIFileWriter::blockSize(1, 1, 1, 1)) {
+        throw std::invalid_argument("The memory budget is too small to hold even a single integral.");
+    }
+
+    this->output_file.reset(new libwint::ReplacingOutputFile(filename));
+    if (!this->output_file->get_stream().good()) {
+        throw std::runtime_error("The ERI file could not be created. Maybe you specified a wrong path?");
+    }
+
+    // Write the header, in which the number of blocks will be filled in when closing
+    uint64_t header[3] = {eri_file_version, static_cast<uint64_t>(K), 0};
+    this->output_file->get_stream().write(eri_file_magic, sizeof(eri_file_magic));
+    this->output_file->get_stream().write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    this->active_buffer.reserve(this->chunk_size);
+    this->pending_buffer.reserve(this->chunk_size);
+
+    this->writer_thread = std::thread(&ERIFileWriter::writeLoop, this);
+}
+
+
+
+/*
+ *  DESTRUCTOR
+ */
+
+/**
+ *  Discard the file if it hasn't been closed, leaving the destination untouched
+ */
+ERIFileWriter::~ERIFileWriter() {
+
+    // The background thread is stopped (if close() hasn't done so or threw before joining it), after which the uncommitted temporary file is removed by the destructor of output_file
+    if (this->writer_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock (this->pending_mutex);
+            this->should_stop = true;
+        }
+        this->pending_condition.notify_all();
+        this->writer_thread.join();
+    }
+}
+
+
+
+/*
+ *  STATIC PUBLIC METHODS
+ */
+
+/**
+ *  @return the number of bytes that a block with dimensions (@param: n_p, @param: n_q, @param: n_r, @param: n_s) takes in a chunk
+ */
+size_t ERIFileWriter::blockSize(size_t n_p, size_t n_q, size_t n_r, size_t n_s) {
+    return eri_block_header_size + n_p * n_q * n_r * n_s * sizeof(double);
+}
+
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  Add the block starting at (@param: p, @param: q, @param: r, @param: s) with dimensions (@param: n_p, @param: n_q, @param: n_r, @param: n_s), whose values are given in row-major order by @param: data
+ *
+ *  This method can be called by multiple threads at the same time
+ */
+void ERIFileWriter::addBlock(size_t p, size_t q, size_t r, size_t s, size_t n_p, size_t n_q, size_t n_r, size_t n_s, const double* data) {
+
+    const size_t block_size = ERIFileWriter::blockSize(n_p, n_q, n_r, n_s);
+    if (block_size > this->chunk_size) {
+        throw std::invalid_argument("The memory budget is too small to hold this block of integrals.");
+    }
+
+    std::lock_guard<std::mutex> lock (this->active_mutex);
+    if (this->is_closed) {
+        throw std::logic_error("You can't add blocks to an ERI file that has been closed.");
+    }
+
+    // If the block doesn't fit anymore, the active buffer is handed over to the background thread
+    if (this->active_buffer.size() + block_size > this->chunk_size) {
+        this->flushActiveBuffer();
+    }
+
+    uint64_t block_header[8] = {p, q, r, s, n_p, n_q, n_r, n_s};
+    const auto* block_header_bytes = reinterpret_cast<const char*>(block_header);
+    const auto* data_bytes = reinterpret_cast<const char*>(data);
+    this->active_buffer.insert(this->active_buffer.end(), block_header_bytes, block_header_bytes + eri_block_header_size);
+    this->active_buffer.insert(this->active_buffer.end(), data_bytes, data_bytes + (block_size - eri_block_header_size));
+
+    this->active_number_of_blocks++;
+    this->number_of_blocks++;
+}
+
+
+/**
+ *  Write the remaining blocks, wait for the background thread and finish the file
+ *
+ *  If an error occurred while writing, it is rethrown
+ */
+void ERIFileWriter::close() {
+
+    std::lock_guard<std::mutex> lock (this->active_mutex);
+    if (this->is_closed) {
+        return;
+    }
+    this->is_closed = true;
+
+    this->flushActiveBuffer();
+
+    {
+        std::lock_guard<std::mutex> pending_lock (this->pending_mutex);
+        this->should_stop = true;
+    }
+    this->pending_condition.notify_all();
+    this->writer_thread.join();
+
+    if (this->exception) {
+        std::rethrow_exception(this->exception);
+    }
+
+    // Fill in the number of blocks in the header, and only then replace the destination
+    auto number_of_blocks = static_cast<uint64_t>(this->number_of_blocks);
+    this->output_file->get_stream().seekp(eri_file_header_size - sizeof(uint64_t));
+    this->output_file->get_stream().write(reinterpret_cast<const char*>(&number_of_blocks), sizeof(uint64_t));
+    this->output_file->commit();
+}
+
+
+
+/*
+ *  ERIFILEREADER
+ */
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Constructor that opens and checks the header of the ERI file @param: filename
+ */
+ERIFileReader::ERIFileReader(const std::string& filename) :
+    filename (filename)
+{
+    std::ifstream input_file_stream (filename, std::ios::binary);
+    if (!input_file_stream.good()) {
+        throw std::runtime_error("The provided ERI file is illegible. Maybe you specified a wrong path?");
+    }
+
+    char magic[8];
+    uint64_t header[3];
+    input_file_stream.read(magic, sizeof(magic));
+    input_file_stream.read(reinterpret_cast<char*>(header), sizeof(header));
+
+    if (!input_file_stream.good() || (std::memcmp(magic, eri_file_magic, sizeof(magic)) != 0)) {
+        throw std::runtime_error("The provided file is not an ERI file.");
+    }
+    if (header[0] != eri_file_version) {
+        throw std::runtime_error("The provided ERI file has an unsupported version.");
+    }
+
+    this->K = static_cast<size_t>(header[1]);
+    this->number_of_blocks = static_cast<size_t>(header[2]);
+}
+
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  Call @param: callback for every block in the file, in the order in which they were written
+ *
+ *  Only one chunk is kept in memory at a time, so the block data is only valid during the call
+ */
+void ERIFileReader::readBlocks(const std::function<void(const ERIBlock&)>& callback) const {
+
+    std::ifstream input_file_stream (this->filename, std::ios::binary | std::ios::ate);
+    const auto file_size = static_cast<size_t>(input_file_stream.tellg());
+    input_file_stream.seekg(eri_file_header_size);
+    size_t remaining_file_size = (file_size > eri_file_header_size) ? (file_size - eri_file_header_size) : 0;
+
+    // The chunk is read into a buffer of doubles, so that the (8-byte aligned) block data can be used in place
+    std::vector<double> chunk;
+
+    size_t number_of_read_blocks = 0;
+    while (number_of_read_blocks < this->number_of_blocks) {
+        uint64_t chunk_header[2];
+        if (remaining_file_size < eri_chunk_header_size) {
+            throw std::runtime_error("The provided ERI file is truncated.");
+        }
+        input_file_stream.read(reinterpret_cast<char*>(chunk_header), eri_chunk_header_size);
+        remaining_file_size -= eri_chunk_header_size;
+
+        // Don't trust the chunk header before checking that the chunk fits in the file and that its blocks fit in the file's block count
+        const auto chunk_size = static_cast<size_t>(chunk_header[0]);
+        const auto number_of_chunk_blocks = static_cast<size_t>(chunk_header[1]);
+        if ((chunk_size > remaining_file_size) || (chunk_size % sizeof(double) != 0) || (number_of_chunk_blocks > this->number_of_blocks - number_of_read_blocks) || (number_of_chunk_blocks > chunk_size / eri_block_header_size)) {
+            throw std::runtime_error("The provided ERI file is truncated.");
+        }
+        chunk.resize(chunk_size / sizeof(double));
+        input_file_stream.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk_size));
+        remaining_file_size -= chunk_size;
+
+        if (!input_file_stream.good()) {
+            throw std::runtime_error("The provided ERI file is truncated.");
+        }
+
+        const double* position = chunk.data();
+        const double* chunk_end = chunk.data() + chunk.size();
+        for (size_t i = 0; i < number_of_chunk_blocks; i++) {
+            if (static_cast<size_t>(chunk_end - position) < 8) {
+                throw std::runtime_error("The provided ERI file is truncated.");
+            }
+            uint64_t block_header[8];
+            std::memcpy(block_header, position, eri_block_header_size);
+
+            ERIBlock block {block_header[0], block_header[1], block_header[2], block_header[3], block_header[4], block_header[5], block_header[6], block_header[7], position + 8};
+
+            // Every block should lie inside the K^4 tensor and its data inside the chunk
+            const auto remaining_chunk_size = static_cast<size_t>(chunk_end - position) - 8;  // in doubles
+            size_t block_size = 1;
+            for (const auto& offset_and_dimension : {std::make_pair(block.p, block.n_p), std::make_pair(block.q, block.n_q), std::make_pair(block.r, block.n_r), std::make_pair(block.s, block.n_s)}) {
+                const auto offset = offset_and_dimension.first;
+                const auto dimension = offset_and_dimension.second;
+                if ((offset > this->K) || (dimension > this->K - offset) || ((dimension != 0) && (block_size > remaining_chunk_size / dimension))) {  // the last check also prevents overflow
+                    throw std::runtime_error("The provided ERI file is truncated.");
+                }
+                block_size *= dimension;
+            }
+            callback(block);
+
+            position += 8 + block_size;
+        }
+
+        number_of_read_blocks += number_of_chunk_blocks;
+    }
+}
+
+
+/**
+ *  @return the whole rank-four tensor of the two-electron integrals, in which the 8-fold permutational symmetry is applied to every block
+ */
+Eigen::Tensor<double, 4> ERIFileReader::readTensor() const {
+
+    const auto K = static_cast<long>(this->K);
+    Eigen::Tensor<double, 4> g (K, K, K, K);
+    g.setZero();
+
+    this->readBlocks([&g] (const ERIBlock& block) {
+        for (size_t f1 = 0; f1 != block.n_p; ++f1) {
+            for (size_t f2 = 0; f2 != block.n_q; ++f2) {
+                for (size_t f3 = 0; f3 != block.n_r; ++f3) {
+                    for (size_t f4 = 0; f4 != block.n_s; ++f4) {
+                        auto value = block.data[f4 + block.n_s * (f3 + block.n_r * (f2 + block.n_q * (f1)))];  // row-major storage accessing
+
+                        auto p = static_cast<long>(block.p + f1);
+                        auto q = static_cast<long>(block.q + f2);
+                        auto r = static_cast<long>(block.r + f3);
+                        auto s = static_cast<long>(block.s + f4);
+                        g(p,q,r,s) = value;
+
+                        // Apply the permutational symmetries for real orbitals
+                        g(p,q,s,r) = value;
+                        g(q,p,r,s) = value;
+                        g(q,p,s,r) = value;
+
+                        g(r,s,p,q) = value;
+                        g(s,r,p,q) = value;
+                        g(r,s,q,p) = value;
+                        g(s,r,q,p) = value;
+                    }
+                }
+            }
+        }
+    });
+
+    return g;
+}
+
+
+}  // namespace libwint
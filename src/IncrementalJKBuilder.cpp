@@ -0,0 +1,91 @@
+#include "IncrementalJKBuilder.hpp"
+
+#include "LibintCommunicator.hpp"
+
+
+
+namespace libwint {
+
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Constructor from a @param: molecule and a @param: basisset_name, together with the @param: screening_threshold for the density-weighted Cauchy-Schwarz screening, the @param: rebuild_interval (0 meaning never) and the @param: number_of_threads
+ */
+IncrementalJKBuilder::IncrementalJKBuilder(const libwint::Molecule& molecule, std::string basisset_name, double screening_threshold, size_t rebuild_interval, size_t number_of_threads) :
+    basisset_name (basisset_name),
+    atoms (molecule.get_atoms()),
+    screening_threshold (screening_threshold),
+    rebuild_interval (rebuild_interval),
+    number_of_threads (number_of_threads)
+{}
+
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  Update J and K to the given symmetric AO density matrices @param: D
+ *
+ *  If there is no previous build, if the number of density matrices or their dimensions changed, or if the rebuild interval is reached, J and K are calculated from the full density matrices. Otherwise, only the changes in J and K are calculated from the density differences.
+ */
+void IncrementalJKBuilder::update(const std::vector<Eigen::MatrixXd>& D) {
+
+    const auto& communicator = libwint::LibintCommunicator::get();
+
+    // Check if we can build on the previous density matrices
+    bool is_full_build = (this->D.size() != D.size()) || (this->D.empty());
+    for (size_t i = 0; (i < D.size()) && !is_full_build; i++) {
+        if ((this->D[i].rows() != D[i].rows()) || (this->D[i].cols() != D[i].cols())) {
+            is_full_build = true;
+        }
+    }
+    if ((this->rebuild_interval > 0) && (this->number_of_updates >= this->rebuild_interval)) {
+        is_full_build = true;
+    }
+
+
+    if (is_full_build) {
+        communicator.calculateCoulombAndExchangeMatrices(this->basisset_name, this->atoms, D, this->J, this->K, this->screening_threshold, this->number_of_screened_quartets, this->number_of_threads);
+        this->number_of_updates = 0;
+    }
+
+    else {
+        std::vector<Eigen::MatrixXd> delta_D (D.size());
+        for (size_t i = 0; i < D.size(); i++) {
+            delta_D[i] = D[i] - this->D[i];
+        }
+
+        std::vector<Eigen::MatrixXd> delta_J;
+        std::vector<Eigen::MatrixXd> delta_K;
+        communicator.calculateCoulombAndExchangeMatrices(this->basisset_name, this->atoms, delta_D, delta_J, delta_K, this->screening_threshold, this->number_of_screened_quartets, this->number_of_threads);
+
+        for (size_t i = 0; i < D.size(); i++) {
+            this->J[i] += delta_J[i];
+            this->K[i] += delta_K[i];
+        }
+        this->number_of_updates++;
+    }
+
+    this->D = D;
+}
+
+
+/**
+ *  Forget the previous density matrices, so that the next update is a full build
+ */
+void IncrementalJKBuilder::reset() {
+
+    this->D.clear();
+    this->J.clear();
+    this->K.clear();
+    this->number_of_updates = 0;
+    this->number_of_screened_quartets = 0;
+}
+
+
+}  // namespace libwint
@@ -0,0 +1,241 @@
+#include "IntegralCheckpoint.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+
+
+namespace libwint {
+
+
+namespace {
+
+const char checkpoint_file_magic[8] = {'L', 'W', 'C', 'H', 'K', 'P', 'N', 'T'};
+const uint64_t checkpoint_file_version = 1;
+const size_t checkpoint_file_header_words = 5;  // the magic, the version, K, the number of scalars and the number of matrices
+
+
+/**
+ *  A writer of 8-byte words that keeps the running checksum of everything that has been written
+ */
+class CheckpointWriter {
+private:
+    libwint::ReplacingOutputFile output_file;  // jobs that are loading the checkpoint may still map the old file, so it is replaced instead of rewritten
+    std::ofstream& output_file_stream;
+    uint64_t hash;
+    std::vector<uint64_t> buffer;
+
+
+    void flush() {
+        this->hash = IntegralCheckpoint::checksum(this->buffer.data(), this->buffer.size(), this->hash);
+        this->output_file_stream.write(reinterpret_cast<const char*>(this->buffer.data()), static_cast<std::streamsize>(this->buffer.size() * sizeof(uint64_t)));
+        this->buffer.clear();
+    }
+
+
+public:
+    explicit CheckpointWriter(const std::string& filename) :
+        output_file (filename),
+        output_file_stream (output_file.get_stream()),
+        hash (IntegralCheckpoint::checksum(nullptr, 0))
+    {
+        if (!this->output_file_stream.good()) {
+            throw std::runtime_error("The checkpoint file could not be created. Maybe you specified a wrong path?");
+        }
+        this->buffer.reserve(1 << 16);
+    }
+
+    void write(uint64_t word) {
+        this->buffer.push_back(word);
+        if (this->buffer.size() == this->buffer.capacity()) {
+            this->flush();
+        }
+    }
+
+    void write(double value) {
+        uint64_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        this->write(word);
+    }
+
+    void write(const double* values, size_t number_of_values) {
+        for (size_t i = 0; i < number_of_values; i++) {
+            this->write(values[i]);
+        }
+    }
+
+    /**
+     *  Write the checksum and replace the checkpoint file by the written one
+     */
+    void close() {
+        this->flush();
+        this->output_file_stream.write(reinterpret_cast<const char*>(&this->hash), sizeof(this->hash));
+
+        if (!this->output_file_stream.good()) {
+            throw std::runtime_error("Something went wrong while writing the checkpoint file. Maybe the disk is full?");
+        }
+        this->output_file.commit();
+    }
+};
+
+}  // anonymous namespace
+
+
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Constructor that maps the checkpoint file @param: filename and verifies its checksum
+ */
+IntegralCheckpoint::IntegralCheckpoint(const std::string& filename) :
+    mapped_file (std::make_shared<const libwint::MappedFile>(filename))
+{
+    // The mapping is page-aligned, so it can be read as 8-byte words
+    const auto words = reinterpret_cast<const uint64_t*>(this->mapped_file->get_data());
+    const size_t file_size = this->mapped_file->get_size();
+
+    if ((file_size < (checkpoint_file_header_words + 2) * sizeof(uint64_t)) || (file_size % sizeof(uint64_t) != 0) || (std::memcmp(words, checkpoint_file_magic, sizeof(checkpoint_file_magic)) != 0)) {
+        throw std::runtime_error("The provided file is not a checkpoint file.");
+    }
+    if (words[1] != checkpoint_file_version) {
+        throw std::runtime_error("The provided checkpoint file has an unsupported version.");
+    }
+
+    const size_t number_of_words = file_size / sizeof(uint64_t) - 1;  // without the checksum
+    if (IntegralCheckpoint::checksum(words, number_of_words) != words[number_of_words]) {
+        throw std::runtime_error("The checksum of the provided checkpoint file doesn't match. The file is corrupted.");
+    }
+
+
+    // Find all the sections, checking that they don't run past the end of the file
+    this->K = static_cast<size_t>(words[2]);
+    const size_t number_of_scalars = static_cast<size_t>(words[3]);
+    const size_t number_of_matrices = static_cast<size_t>(words[4]);
+
+    size_t position = checkpoint_file_header_words;
+    auto advance = [&position, number_of_words] (size_t number_of_words_in_section) {
+        if (number_of_words_in_section > number_of_words - position) {
+            throw std::runtime_error("The provided checkpoint file is truncated.");
+        }
+        size_t start = position;
+        position += number_of_words_in_section;
+        return start;
+    };
+    //  The sizes of the sections are products of numbers in the file, so every product is checked before it can overflow: a section can't be larger than the file anyway
+    auto multiply = [number_of_words] (size_t a, size_t b) {
+        if ((a != 0) && (b > number_of_words / a)) {
+            throw std::runtime_error("The provided checkpoint file is truncated.");
+        }
+        return a * b;
+    };
+    const auto values = reinterpret_cast<const double*>(words);
+
+    this->core_energy = values[advance(1)];
+    const size_t scalars_start = advance(number_of_scalars);
+    this->scalars.assign(values + scalars_start, values + scalars_start + number_of_scalars);
+    this->h_data = values + advance(multiply(this->K, this->K));
+
+    const size_t number_of_pairs = this->K * (this->K + 1) / 2;  // K^2 fits in the file, so this can't overflow
+    const size_t number_of_unique_integrals = (number_of_pairs % 2 == 0) ? multiply(number_of_pairs / 2, number_of_pairs + 1) : multiply(number_of_pairs, (number_of_pairs + 1) / 2);
+    this->g_data = values + advance(number_of_unique_integrals);
+
+    for (size_t i = 0; i < number_of_matrices; i++) {
+        const size_t dimensions_start = advance(2);
+        const auto rows = static_cast<size_t>(words[dimensions_start]);
+        const auto cols = static_cast<size_t>(words[dimensions_start + 1]);
+        if ((rows > number_of_words) || (cols > number_of_words)) {  // e.g. an empty matrix with a dimension that doesn't fit in a long
+            throw std::runtime_error("The provided checkpoint file is truncated.");
+        }
+        this->matrices.emplace_back(values + advance(multiply(rows, cols)), static_cast<long>(rows), static_cast<long>(cols));
+    }
+
+    if (position != number_of_words) {
+        throw std::runtime_error("The provided checkpoint file has trailing data.");
+    }
+}
+
+
+
+/*
+ *  GETTERS
+ */
+
+/**
+ *  @return a read-only view of the one-electron integrals in the mapping
+ */
+Eigen::Map<const Eigen::MatrixXd> IntegralCheckpoint::get_h() const {
+
+    const auto K = static_cast<long>(this->K);
+    return Eigen::Map<const Eigen::MatrixXd> (this->h_data, K, K);
+}
+
+
+/**
+ *  @return a read-only view of the unique two-electron integrals in the mapping, in the order of PackedERITensor::compoundIndex
+ */
+Eigen::Map<const Eigen::VectorXd> IntegralCheckpoint::get_packed_g() const {
+
+    return Eigen::Map<const Eigen::VectorXd> (this->g_data, static_cast<long>(libwint::PackedERITensor::numberOfElements(this->K)));
+}
+
+
+
+/*
+ *  STATIC PUBLIC METHODS
+ */
+
+/**
+ *  Write the checkpoint file @param: filename for the @param: core_energy, the one-electron integrals @param: h, the unique two-electron integrals @param: g and any additional @param: scalars and @param: matrices
+ */
+void IntegralCheckpoint::save(const std::string& filename, double core_energy, const Eigen::MatrixXd& h, const libwint::PackedERITensor& g, const std::vector<double>& scalars, const std::vector<Eigen::MatrixXd>& matrices) {
+
+    const size_t K = g.get_K();
+    if ((static_cast<size_t>(h.rows()) != K) || (static_cast<size_t>(h.cols()) != K)) {
+        throw std::invalid_argument("The dimensions of the given one- and two-electron integrals are incompatible.");
+    }
+
+    CheckpointWriter writer (filename);
+
+    uint64_t magic;
+    std::memcpy(&magic, checkpoint_file_magic, sizeof(magic));
+    writer.write(magic);
+    writer.write(checkpoint_file_version);
+    writer.write(static_cast<uint64_t>(K));
+    writer.write(static_cast<uint64_t>(scalars.size()));
+    writer.write(static_cast<uint64_t>(matrices.size()));
+
+    writer.write(core_energy);
+    writer.write(scalars.data(), scalars.size());
+    writer.write(h.data(), static_cast<size_t>(h.size()));
+    writer.write(g.get_data().data(), g.size());
+
+    for (const auto& matrix : matrices) {
+        writer.write(static_cast<uint64_t>(matrix.rows()));
+        writer.write(static_cast<uint64_t>(matrix.cols()));
+        writer.write(matrix.data(), static_cast<size_t>(matrix.size()));
+    }
+
+    writer.close();
+}
+
+
+/**
+ *  @return the checksum of @param: number_of_words 8-byte words at @param: words, continuing from the checksum @param: hash of the preceding words
+ *
+ *  The checksum is a word-wise FNV-1a hash, so a file can be hashed in chunks
+ */
+uint64_t IntegralCheckpoint::checksum(const uint64_t* words, size_t number_of_words, uint64_t hash) {
+
+    for (size_t i = 0; i < number_of_words; i++) {
+        hash = (hash ^ words[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+
+}  // namespace libwint
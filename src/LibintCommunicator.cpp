@@ -1,10 +1,37 @@
 #include "LibintCommunicator.hpp"
 
+#include "ERIFile.hpp"
+#include "TaskScheduler.hpp"
+#include "threading.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
 
 
 namespace libwint {
 
 
+/*
+ *  CACHEDBASISSET
+ */
+
+/**
+ *  Constructor from a @param: basisset_name and @param: atoms, which reads the basis set library file and normalizes the shells
+ */
+CachedBasisSet::CachedBasisSet(const std::string& basisset_name, const std::vector<libint2::Atom>& atoms) :
+        basisset (basisset_name, atoms),
+        shell2bf (basisset.shell2bf()),
+        nbf (static_cast<size_t>(basisset.nbf())),
+        max_nprim (static_cast<size_t>(basisset.max_nprim())),
+        max_l (static_cast<int>(basisset.max_l()))
+{}
+
+
+
 /*
  *  PRIVATE METHODS
  */
@@ -26,61 +53,85 @@ LibintCommunicator::~LibintCommunicator() {
  */
 Eigen::MatrixXd LibintCommunicator::calculateOneBodyIntegrals(libint2::Operator operator_type, std::string basisset_name, const std::vector<libint2::Atom>& atoms) const {
 
-    libint2::BasisSet basisset (basisset_name, atoms);
+    return this->calculateOneBodyIntegrals(std::vector<libint2::Operator> {operator_type}, basisset_name, atoms)[0];
+}
+
+
+/**
+ *  Calculate the one-body integrals associated to all the given @param: operator_types for the given @param: atoms for the basisset with name @param: basisset_name
+ *
+ *  All the integrals are calculated in one sweep over the shell pairs, and @return the matrices in the same order as the given operator types
+ */
+std::vector<Eigen::MatrixXd> LibintCommunicator::calculateOneBodyIntegrals(const std::vector<libint2::Operator>& operator_types, std::string basisset_name, const std::vector<libint2::Atom>& atoms) const {
+
+    const auto cached_basisset = this->getBasisSet(basisset_name, atoms);
+    const auto& basisset = cached_basisset->basisset;
 
     const auto nsh = static_cast<size_t>(basisset.size());    // number of shells in the basis_set
-    const auto nbf = static_cast<size_t>(basisset.nbf());     // nbf: number of basis functions in the basisset
+    const auto nbf = cached_basisset->nbf;     // nbf: number of basis functions in the basisset
+    const auto number_of_operators = operator_types.size();
 
-    // Initialize the eigen matrix:
+    // Initialize the eigen matrices:
     //  Since the matrices we will encounter (S, T, V) are symmetric, the issue of row major vs column major doesn't matter.
-    Eigen::MatrixXd M_result (nbf, nbf);
+    std::vector<Eigen::MatrixXd> M_results (number_of_operators, Eigen::MatrixXd::Zero(nbf, nbf));
 
-    // Construct the libint2 engine
-    libint2::Engine engine (operator_type, basisset.max_nprim(), static_cast<int>(basisset.max_l()));  // libint2 requires an int
-    //  Something extra for the nuclear attraction integrals
-    if (operator_type == libint2::Operator::nuclear) {
-        engine.set_params(make_point_charges(atoms));
+    // Construct one libint2 engine for every operator
+    std::vector<libint2::Engine> engines;
+    engines.reserve(number_of_operators);
+    for (const auto& operator_type : operator_types) {
+        engines.emplace_back(operator_type, cached_basisset->max_nprim, cached_basisset->max_l);
+
+        //  Something extra for the nuclear attraction integrals
+        if (operator_type == libint2::Operator::nuclear) {
+            engines.back().set_params(make_point_charges(atoms));
+        }
     }
 
-    const auto shell2bf = basisset.shell2bf();  // maps shell index to bf index
+    const auto& shell2bf = cached_basisset->shell2bf;  // maps shell index to bf index
 
-    const auto& buffer = engine.results();  // vector that holds pointers to computed shell sets
-    // actually, buffer.size() is always 1, so buffer[0] is a pointer to
-    //      the first calculated integral of these specific shells
-    // the values that buffer[0] points to will change after every compute() call
 
     // One-body integrals are between two basis functions, so we'll need two loops.
     // However, LibInt calculates integrals between libint2::Shells, we will loop over the shells (sh) in the basis_set
-    for (auto sh1 = 0; sh1 != nsh; ++sh1) {  // sh1: shell 1
-        for (auto sh2 = 0; sh2 != nsh; ++sh2) {  // sh2: shell 2
-            // Calculate integrals between the two shells (basis_set is a decorated std::vector<libint2::Shell>)
-            engine.compute(basisset[sh1], basisset[sh2]);
+    //  Since the one-body operators are symmetric, we only calculate the lower triangle (sh2 <= sh1) and mirror the results
+    //  All the operators are handled for a shell pair before moving on to the next shell pair, so the shell data are reused while they're still in cache
+    for (size_t sh1 = 0; sh1 != nsh; ++sh1) {  // sh1: shell 1
+        for (size_t sh2 = 0; sh2 <= sh1; ++sh2) {  // sh2: shell 2
 
-            auto calculated_integrals = buffer[0];  // is actually a pointer: const double *
+            auto bf1 = static_cast<long>(shell2bf[sh1]);  // (index of) first bf in sh1
+            auto bf2 = static_cast<long>(shell2bf[sh2]);  // (index of) first bf in sh2
 
-            if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
-                continue;
+            auto nbf_sh1 = static_cast<long>(basisset[sh1].size());  // number of basis functions in first shell
+            auto nbf_sh2 = static_cast<long>(basisset[sh2].size());  // number of basis functions in second shell
 
+            for (size_t i = 0; i < number_of_operators; i++) {
+                // Calculate integrals between the two shells (basis_set is a decorated std::vector<libint2::Shell>)
+                const auto& buffer = engines[i].compute(basisset[sh1], basisset[sh2]);  // vector that holds pointers to computed shell sets
+                // actually, buffer.size() is always 1, so buffer[0] is a pointer to
+                //      the first calculated integral of these specific shells
+                // the values that buffer[0] points to will change after every compute() call
 
-            // Extract the calculated integrals from calculated_integrals.
-            // In calculated_integrals, the integrals are stored in row major form.
-            auto bf1 = shell2bf[sh1];  // (index of) first bf in sh1
-            auto bf2 = shell2bf[sh2];  // (index of) first bf in sh2
+                auto calculated_integrals = buffer[0];  // is actually a pointer: const double *
 
-            auto nbf_sh1 = basisset[sh1].size();  // number of basis functions in first shell
-            auto nbf_sh2 = basisset[sh2].size();  // number of basis functions in second shell
+                if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
+                    continue;
 
-            for (auto f1 = 0; f1 != nbf_sh1; ++f1) {     // f1: index of basis function within shell 1
-                for (auto f2 = 0; f2 != nbf_sh2; ++f2) { // f2: index of basis function within shell 2
-                    double computed_integral = calculated_integrals[f2 + f1 * nbf_sh2];  // integrals are packed in row-major form
-                    M_result(bf1 + f1, bf2 + f2) = computed_integral;
+
+                // Extract the calculated integrals from calculated_integrals.
+                // In calculated_integrals, the integrals are stored in row major form.
+                auto& M_result = M_results[i];
+                for (auto f1 = 0L; f1 != nbf_sh1; ++f1) {     // f1: index of basis function within shell 1
+                    for (auto f2 = 0L; f2 != nbf_sh2; ++f2) { // f2: index of basis function within shell 2
+                        double computed_integral = calculated_integrals[f2 + f1 * nbf_sh2];  // integrals are packed in row-major form
+                        M_result(bf1 + f1, bf2 + f2) = computed_integral;
+                        M_result(bf2 + f2, bf1 + f1) = computed_integral;
+                    }
                 }
             }
 
         }
     }
 
-    return M_result;
+    return M_results;
 }
 
 
@@ -89,76 +140,858 @@ Eigen::MatrixXd LibintCommunicator::calculateOneBodyIntegrals(libint2::Operator
  */
 Eigen::Tensor<double, 4> LibintCommunicator::calculateTwoBodyIntegrals(std::string basisset_name, const std::vector<libint2::Atom>& atoms) const {
 
-    libint2::BasisSet basisset (basisset_name, atoms);
+    size_t number_of_screened_quartets = 0;
+    return this->calculateTwoBodyIntegrals(basisset_name, atoms, 0.0, number_of_screened_quartets);
+}
 
-    // We have to static_cast to LONG, as clang++ else gives the following errors:
-    //  error: non-constant-expression cannot be narrowed from type 'unsigned long' to 'value_type' (aka 'long') in initializer list
-    //  note: insert an explicit cast to silence this issue
 
-    const auto nsh = static_cast<size_t>(basisset.size());
-    const auto nbf = static_cast<size_t>(basisset.nbf());
+/**
+ *  Calculate the two-body integrals IN CHEMIST'S NOTATION (11|22) for the given @param: atoms for the basisset with name @param: basisset_name
+ *
+ *  Shell quartets whose Cauchy-Schwarz bound sqrt((12|12)) * sqrt((34|34)) is smaller than @param: screening_threshold are not calculated (their integrals are set to zero), and their number is written to @param: number_of_screened_quartets
+ *
+ *  The shell quartets are distributed over @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads), each with their own copy of the libint2 engine. The load is balanced by a work-stealing TaskScheduler, based on the estimated cost of the shell quartets
+ */
+Eigen::Tensor<double, 4> LibintCommunicator::calculateTwoBodyIntegrals(std::string basisset_name, const std::vector<libint2::Atom>& atoms, double screening_threshold, size_t& number_of_screened_quartets, size_t number_of_threads) const {
+
+    const auto cached_basisset = this->getBasisSet(basisset_name, atoms);
+    const auto& basisset = cached_basisset->basisset;
+    const auto nbf = cached_basisset->nbf;
 
-    // Initialize the rank-4 two-electron integrals Tensor
+    // Initialize the rank-4 two-electron integrals Tensor: screened integrals will not be written, so they should be zero
     Eigen::Tensor<double, 4> g (nbf, nbf, nbf, nbf);
+    g.setZero();
+
+
+    // The shell-pair Cauchy-Schwarz bounds tell us which shell quartets are negligible
+    const Eigen::MatrixXd Q = this->calculateSchwarzBounds(*cached_basisset);
 
 
     // Construct the libint2 engine
-    libint2::Engine engine(libint2::Operator::coulomb, basisset.max_nprim(), static_cast<int>(basisset.max_l()));  // libint2 requires an int
+    libint2::Engine engine(libint2::Operator::coulomb, cached_basisset->max_nprim, cached_basisset->max_l);
+
+    //  There's no need for libint2 to calculate the primitive integrals more precisely than the screening threshold
+    if (screening_threshold > std::numeric_limits<double>::epsilon()) {
+        engine.set_precision(screening_threshold);
+    }
+
+    //  A libint2 engine isn't thread-safe, so every thread gets its own copy
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+    std::vector<libint2::Engine> engines (number_of_threads, engine);
+    std::vector<size_t> screened_quartets_per_thread (number_of_threads, 0);
 
-    const auto shell2bf = basisset.shell2bf();  // maps shell index to bf index
+    const auto& shell2bf = cached_basisset->shell2bf;  // maps shell index to bf index
 
-    const auto &buffer = engine.results();  // vector that holds pointers to computed shell sets
-    // actually, buffer.size() is always 1, so buffer[0] is a pointer to
-    //      the first calculated integral of these specific shells
-    // the values that buffer[0] points to will change after every compute() call
 
     // Two-electron integrals are between four basis functions, so we'll need four loops.
     // However, LibInt calculates integrals between libint2::Shells, we will loop over the shells (sh) in the obs
-    for (auto sh1 = 0; sh1 != nsh; ++sh1) {  // sh1: shell 1
-        for (auto sh2 = 0; sh2 != nsh; ++sh2) {  // sh2: shell 2
-            for (auto sh3 = 0; sh3 != nsh; ++sh3) {  // sh3: shell 3
-                for (auto sh4 = 0; sh4 != nsh; ++sh4) {  //sh4: shell 4
-                    // Calculate integrals between the two shells (obs is a decorated std::vector<libint2::Shell>)
-                    engine.compute(basisset[sh1], basisset[sh2], basisset[sh3], basisset[sh4]);
+    //  For real orbitals, the integrals have an 8-fold permutational symmetry: (12|34) = (21|34) = (12|43) = (21|43) = (34|12) = (43|12) = (34|21) = (43|21)
+    //  We will therefore only calculate the canonical shell quartets (sh1 >= sh2, sh3 >= sh4, (sh1 sh2) >= (sh3 sh4)) and copy the results to the equivalent positions
+    //  Since every element of g belongs to exactly one canonical shell quartet, the threads never write to the same elements
+    auto compute_quartet = [&] (size_t thread_id, size_t sh1, size_t sh2, size_t sh3, size_t sh4) {
+
+        // Skip the shell quartets that are negligible according to the Cauchy-Schwarz inequality |(12|34)| <= sqrt((12|12)) * sqrt((34|34))
+        if (Q(sh1, sh2) * Q(sh3, sh4) < screening_threshold) {
+            screened_quartets_per_thread[thread_id]++;
+            return;
+        }
+
+        // Calculate integrals between the two shells (obs is a decorated std::vector<libint2::Shell>)
+        const auto& buffer = engines[thread_id].compute(basisset[sh1], basisset[sh2], basisset[sh3], basisset[sh4]);  // vector that holds pointers to computed shell sets
+        // actually, buffer.size() is always 1, so buffer[0] is a pointer to
+        //      the first calculated integral of these specific shells
+        // the values that buffer[0] points to will change after every compute() call
+
+        auto calculated_integrals = buffer[0];
+
+        if (calculated_integrals == nullptr) {  // if the zeroth element is nullptr, then the whole shell has been exhausted
+            return;
+        }
+
+        // Extract the calculated integrals from calculated_integrals.
+        // In calculated_integrals, the integrals are stored in row major form.
+        auto bf1 = static_cast<long>(shell2bf[sh1]);  // (index of) first bf in sh1
+        auto bf2 = static_cast<long>(shell2bf[sh2]);  // (index of) first bf in sh2
+        auto bf3 = static_cast<long>(shell2bf[sh3]);  // (index of) first bf in sh3
+        auto bf4 = static_cast<long>(shell2bf[sh4]);  // (index of) first bf in sh4
+
+
+        auto nbf_sh1 = static_cast<long>(basisset[sh1].size());  // number of basis functions in first shell
+        auto nbf_sh2 = static_cast<long>(basisset[sh2].size());  // number of basis functions in second shell
+        auto nbf_sh3 = static_cast<long>(basisset[sh3].size());  // number of basis functions in third shell
+        auto nbf_sh4 = static_cast<long>(basisset[sh4].size());  // number of basis functions in fourth shell
+
+        for (auto f1 = 0L; f1 != nbf_sh1; ++f1) {
+            for (auto f2 = 0L; f2 != nbf_sh2; ++f2) {
+                for (auto f3 = 0L; f3 != nbf_sh3; ++f3) {
+                    for (auto f4 = 0L; f4 != nbf_sh4; ++f4) {
+                        auto computed_integral = calculated_integrals[f4 + nbf_sh4 * (f3 + nbf_sh3 * (f2 + nbf_sh2 * (f1)))];  // row-major storage accessing
+
+                        // The two-electron integrals are given in CHEMIST'S: (11|22)
+                        auto p = f1 + bf1;
+                        auto q = f2 + bf2;
+                        auto r = f3 + bf3;
+                        auto s = f4 + bf4;
+                        g(p,q,r,s) = computed_integral;
+
+                        // Apply the permutational symmetries for real orbitals
+                        g(p,q,s,r) = computed_integral;
+                        g(q,p,r,s) = computed_integral;
+                        g(q,p,s,r) = computed_integral;
+
+                        g(r,s,p,q) = computed_integral;
+                        g(s,r,p,q) = computed_integral;
+                        g(r,s,q,p) = computed_integral;
+                        g(s,r,q,p) = computed_integral;
+                    }
+                }
+            }
+        } // data access loop
+    };
+
+
+    this->computeCanonicalShellQuartets(*cached_basisset, number_of_threads, compute_quartet);
+
+
+    number_of_screened_quartets = 0;
+    for (const auto& screened_quartets : screened_quartets_per_thread) {
+        number_of_screened_quartets += screened_quartets;
+    }
+
+    return g;
+};
+
+
+/**
+ *  Calculate the two-body integrals IN CHEMIST'S NOTATION (11|22) for the given @param: atoms for the basisset with name @param: basisset_name, and write them to the ERI file @param: filename (see ERIFileWriter) instead of keeping them in memory
+ *
+ *  Every canonical shell quartet is written as a block, and the writer uses at most @param: memory_budget bytes for its two buffers: the integrals are calculated in one buffer while the other one is written to disk
+ *  Shell quartets whose Cauchy-Schwarz bound is smaller than @param: screening_threshold are not written, and their number is written to @param: number_of_screened_quartets. The shell quartets are calculated on @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads)
+ */
+void LibintCommunicator::writeTwoBodyIntegrals(std::string basisset_name, const std::vector<libint2::Atom>& atoms, const std::string& filename, size_t memory_budget, double screening_threshold, size_t& number_of_screened_quartets, size_t number_of_threads) const {
+
+    const auto cached_basisset = this->getBasisSet(basisset_name, atoms);
+    const auto& basisset = cached_basisset->basisset;
+
+    // Check if the largest shell quartet fits in one of the writer's buffers before creating the writer, so that a too small memory budget doesn't touch the file
+    size_t max_shell_size = 0;
+    for (const auto& shell : basisset) {
+        max_shell_size = std::max(max_shell_size, static_cast<size_t>(shell.size()));
+    }
+    if (ERIFileWriter::blockSize(max_shell_size, max_shell_size, max_shell_size, max_shell_size) > memory_budget / 2) {
+        throw std::invalid_argument("The memory budget is too small to hold the largest shell quartet.");
+    }
+
+    libwint::ERIFileWriter writer (filename, cached_basisset->nbf, memory_budget);
+
+
+    // The shell-pair Cauchy-Schwarz bounds tell us which shell quartets are negligible
+    const Eigen::MatrixXd Q = this->calculateSchwarzBounds(*cached_basisset);
+
+    // Construct the libint2 engine
+    libint2::Engine engine(libint2::Operator::coulomb, cached_basisset->max_nprim, cached_basisset->max_l);
+
+    //  There's no need for libint2 to calculate the primitive integrals more precisely than the screening threshold
+    if (screening_threshold > std::numeric_limits<double>::epsilon()) {
+        engine.set_precision(screening_threshold);
+    }
+
+    //  A libint2 engine isn't thread-safe, so every thread gets its own copy
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+    std::vector<libint2::Engine> engines (number_of_threads, engine);
+    std::vector<size_t> screened_quartets_per_thread (number_of_threads, 0);
+
+    const auto& shell2bf = cached_basisset->shell2bf;  // maps shell index to bf index
+
+
+    // The calculated shell quartets are copied (in libint2's row-major order) into the writer's buffer as they are
+    auto compute_quartet = [&] (size_t thread_id, size_t sh1, size_t sh2, size_t sh3, size_t sh4) {
+
+        // Skip the shell quartets that are negligible according to the Cauchy-Schwarz inequality |(12|34)| <= sqrt((12|12)) * sqrt((34|34))
+        if (Q(sh1, sh2) * Q(sh3, sh4) < screening_threshold) {
+            screened_quartets_per_thread[thread_id]++;
+            return;
+        }
+
+        const auto& buffer = engines[thread_id].compute(basisset[sh1], basisset[sh2], basisset[sh3], basisset[sh4]);
+        auto calculated_integrals = buffer[0];
+
+        if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
+            return;
+
+        writer.addBlock(shell2bf[sh1], shell2bf[sh2], shell2bf[sh3], shell2bf[sh4], basisset[sh1].size(), basisset[sh2].size(), basisset[sh3].size(), basisset[sh4].size(), calculated_integrals);
+    };
+
+    this->computeCanonicalShellQuartets(*cached_basisset, number_of_threads, compute_quartet);
+    writer.close();
+
+
+    number_of_screened_quartets = 0;
+    for (const auto& screened_quartets : screened_quartets_per_thread) {
+        number_of_screened_quartets += screened_quartets;
+    }
+}
+
+
+/**
+ *  Calculate the Coulomb matrices J[D]_pq = sum_rs (pq|rs) D_rs and the exchange matrices K[D]_pq = sum_rs (pr|qs) D_rs for the given symmetric AO density matrices @param: D, for the given @param: atoms for the basisset with name @param: basisset_name
+ *
+ *  The results are written to @param: J and @param: K, which will contain a matrix for every density matrix
+ */
+void LibintCommunicator::calculateCoulombAndExchangeMatrices(std::string basisset_name, const std::vector<libint2::Atom>& atoms, const std::vector<Eigen::MatrixXd>& D, std::vector<Eigen::MatrixXd>& J, std::vector<Eigen::MatrixXd>& K) const {
+
+    size_t number_of_screened_quartets = 0;
+    this->calculateCoulombAndExchangeMatrices(basisset_name, atoms, D, J, K, 0.0, number_of_screened_quartets);
+}
+
+
+/**
+ *  Calculate the Coulomb matrices J[D]_pq = sum_rs (pq|rs) D_rs and the exchange matrices K[D]_pq = sum_rs (pr|qs) D_rs for the given symmetric AO density matrices @param: D, for the given @param: atoms for the basisset with name @param: basisset_name
+ *
+ *  The two-electron integrals are contracted with the density matrices as soon as a shell quartet is calculated, so the rank-4 tensor g is never stored. The results are written to @param: J and @param: K, which will contain a matrix for every density matrix
+ *
+ *  Shell quartets whose density-weighted Cauchy-Schwarz bound sqrt((12|12)) * sqrt((34|34)) * max|D| is smaller than @param: screening_threshold are skipped, and their number is written to @param: number_of_screened_quartets. Here, max|D| is the largest density matrix element in the shell blocks that the shell quartet is contracted with
+ *      Since small density matrices lead to small contributions, this screening is most effective when D is a density difference (see IncrementalJKBuilder)
+ *
+ *  The shell quartets are distributed over @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads)
+ */
+void LibintCommunicator::calculateCoulombAndExchangeMatrices(std::string basisset_name, const std::vector<libint2::Atom>& atoms, const std::vector<Eigen::MatrixXd>& D, std::vector<Eigen::MatrixXd>& J, std::vector<Eigen::MatrixXd>& K, double screening_threshold, size_t& number_of_screened_quartets, size_t number_of_threads) const {
+
+    const auto cached_basisset = this->getBasisSet(basisset_name, atoms);
+    const auto& basisset = cached_basisset->basisset;
+    const auto nbf = cached_basisset->nbf;
+    const auto number_of_densities = D.size();
+
+    for (const auto& density : D) {
+        if ((static_cast<size_t>(density.rows()) != nbf) || (static_cast<size_t>(density.cols()) != nbf)) {
+            throw std::invalid_argument("The dimensions of the density matrices are not compatible with the basis set.");
+        }
+    }
+
+
+    // The shell-pair Cauchy-Schwarz bounds tell us which shell quartets are negligible
+    const Eigen::MatrixXd Q = this->calculateSchwarzBounds(*cached_basisset);
+
+    //  ... and so do the shell blocks of the density matrices: D_max(sh1, sh2) is the largest |D_pq| (over all density matrices) with p in sh1 and q in sh2
+    const auto nsh = static_cast<size_t>(basisset.size());
+    const auto& shell2bf = cached_basisset->shell2bf;  // maps shell index to bf index
+
+    Eigen::MatrixXd D_max = Eigen::MatrixXd::Zero(nsh, nsh);
+    for (size_t sh1 = 0; sh1 != nsh; ++sh1) {
+        for (size_t sh2 = 0; sh2 != nsh; ++sh2) {
+            auto bf1 = static_cast<long>(shell2bf[sh1]);
+            auto bf2 = static_cast<long>(shell2bf[sh2]);
+            auto nbf_sh1 = static_cast<long>(basisset[sh1].size());
+            auto nbf_sh2 = static_cast<long>(basisset[sh2].size());
+
+            for (const auto& density : D) {
+                D_max(sh1, sh2) = std::max(D_max(sh1, sh2), density.block(bf1, bf2, nbf_sh1, nbf_sh2).cwiseAbs().maxCoeff());
+            }
+        }
+    }
+
+
+    // Construct the libint2 engine
+    libint2::Engine engine(libint2::Operator::coulomb, cached_basisset->max_nprim, cached_basisset->max_l);
+
+    //  There's no need for libint2 to calculate the primitive integrals more precisely than the screening threshold
+    if (screening_threshold > std::numeric_limits<double>::epsilon()) {
+        engine.set_precision(screening_threshold);
+    }
+
+    //  A libint2 engine isn't thread-safe, so every thread gets its own copy, as well as its own J and K accumulators
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+    std::vector<libint2::Engine> engines (number_of_threads, engine);
+    std::vector<std::vector<Eigen::MatrixXd>> J_per_thread (number_of_threads, std::vector<Eigen::MatrixXd> (number_of_densities, Eigen::MatrixXd::Zero(nbf, nbf)));
+    std::vector<std::vector<Eigen::MatrixXd>> K_per_thread (number_of_threads, std::vector<Eigen::MatrixXd> (number_of_densities, Eigen::MatrixXd::Zero(nbf, nbf)));
+    std::vector<size_t> screened_quartets_per_thread (number_of_threads, 0);
+
+
+    // Every canonical shell quartet stands for all its (up to 8) permutationally equivalent shell quartets, so its integrals are scaled by its degeneracy
+    //  Every permutation of (pq|rs) contributes to J_pq, J_rs and to K_pr, K_qs, K_ps, K_qr (or their transposes), so we accumulate these contributions and symmetrize at the end
+    auto compute_quartet = [&] (size_t thread_id, size_t sh1, size_t sh2, size_t sh3, size_t sh4) {
+
+        // Skip the shell quartets whose contributions are negligible according to the Cauchy-Schwarz inequality |(12|34)| <= sqrt((12|12)) * sqrt((34|34))
+        //  J_12 and J_34 are contracted with D_34 and D_12, while K_13, K_24, K_14 and K_23 are contracted with D_24, D_13, D_23 and D_14
+        const double max_density = std::max({D_max(sh1, sh2), D_max(sh3, sh4), D_max(sh1, sh3), D_max(sh2, sh4), D_max(sh1, sh4), D_max(sh2, sh3)});
+        if (Q(sh1, sh2) * Q(sh3, sh4) * max_density < screening_threshold) {
+            screened_quartets_per_thread[thread_id]++;
+            return;
+        }
+
+        const auto& buffer = engines[thread_id].compute(basisset[sh1], basisset[sh2], basisset[sh3], basisset[sh4]);
+        auto calculated_integrals = buffer[0];
+
+        if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
+            return;
+
+        const double degeneracy = ((sh1 == sh2) ? 1.0 : 2.0) * ((sh3 == sh4) ? 1.0 : 2.0) * (((sh1 == sh3) && (sh2 == sh4)) ? 1.0 : 2.0);
+
+        auto bf1 = static_cast<long>(shell2bf[sh1]);  // (index of) first bf in sh1
+        auto bf2 = static_cast<long>(shell2bf[sh2]);  // (index of) first bf in sh2
+        auto bf3 = static_cast<long>(shell2bf[sh3]);  // (index of) first bf in sh3
+        auto bf4 = static_cast<long>(shell2bf[sh4]);  // (index of) first bf in sh4
+
+        auto nbf_sh1 = static_cast<long>(basisset[sh1].size());  // number of basis functions in first shell
+        auto nbf_sh2 = static_cast<long>(basisset[sh2].size());  // number of basis functions in second shell
+        auto nbf_sh3 = static_cast<long>(basisset[sh3].size());  // number of basis functions in third shell
+        auto nbf_sh4 = static_cast<long>(basisset[sh4].size());  // number of basis functions in fourth shell
+
+        auto& J_thread = J_per_thread[thread_id];
+        auto& K_thread = K_per_thread[thread_id];
+
+        for (auto f1 = 0L; f1 != nbf_sh1; ++f1) {
+            for (auto f2 = 0L; f2 != nbf_sh2; ++f2) {
+                for (auto f3 = 0L; f3 != nbf_sh3; ++f3) {
+                    for (auto f4 = 0L; f4 != nbf_sh4; ++f4) {
+                        auto computed_integral = degeneracy * calculated_integrals[f4 + nbf_sh4 * (f3 + nbf_sh3 * (f2 + nbf_sh2 * (f1)))];  // row-major storage accessing
+
+                        auto p = f1 + bf1;
+                        auto q = f2 + bf2;
+                        auto r = f3 + bf3;
+                        auto s = f4 + bf4;
+
+                        for (size_t i = 0; i < number_of_densities; i++) {
+                            const auto& D_i = D[i];
+
+                            J_thread[i](p,q) += D_i(r,s) * computed_integral;
+                            J_thread[i](r,s) += D_i(p,q) * computed_integral;
+
+                            K_thread[i](p,r) += D_i(q,s) * computed_integral;
+                            K_thread[i](q,s) += D_i(p,r) * computed_integral;
+                            K_thread[i](p,s) += D_i(q,r) * computed_integral;
+                            K_thread[i](q,r) += D_i(p,s) * computed_integral;
+                        }
+                    }
+                }
+            }
+        } // data access loop
+    };
+
+    this->computeCanonicalShellQuartets(*cached_basisset, number_of_threads, compute_quartet);
 
+
+    number_of_screened_quartets = 0;
+    for (const auto& screened_quartets : screened_quartets_per_thread) {
+        number_of_screened_quartets += screened_quartets;
+    }
+
+    // Reduce the thread contributions and symmetrize: every integral has been counted 4 times in J (twice in the lower and twice in the upper half) and 8 times in K
+    J.assign(number_of_densities, Eigen::MatrixXd::Zero(nbf, nbf));
+    K.assign(number_of_densities, Eigen::MatrixXd::Zero(nbf, nbf));
+    for (size_t t = 0; t < number_of_threads; t++) {
+        for (size_t i = 0; i < number_of_densities; i++) {
+            J[i] += J_per_thread[t][i];
+            K[i] += K_per_thread[t][i];
+        }
+    }
+
+    for (size_t i = 0; i < number_of_densities; i++) {
+        J[i] = (J[i] + J[i].transpose()).eval() / 4;
+        K[i] = (K[i] + K[i].transpose()).eval() / 8;
+    }
+}
+
+
+/**
+ *  Calculate the two-index Coulomb integrals (P|Q) for the given @param: atoms for the (auxiliary) basisset with name @param: aux_basisset_name
+ */
+Eigen::MatrixXd LibintCommunicator::calculateTwoCenterIntegrals(std::string aux_basisset_name, const std::vector<libint2::Atom>& atoms) const {
+
+    const auto cached_aux_basisset = this->getBasisSet(aux_basisset_name, atoms);
+    const auto& aux_basisset = cached_aux_basisset->basisset;
+
+    const auto nsh = static_cast<size_t>(aux_basisset.size());
+    const auto naux = cached_aux_basisset->nbf;
+    const auto& shell2bf = cached_aux_basisset->shell2bf;  // maps shell index to bf index
+
+    Eigen::MatrixXd V = Eigen::MatrixXd::Zero(naux, naux);
+
+    // Construct the libint2 engine for two-index integrals (P|Q), in which the missing functions are unit shells
+    libint2::Engine engine (libint2::Operator::coulomb, cached_aux_basisset->max_nprim, cached_aux_basisset->max_l);
+    engine.set(libint2::BraKet::xs_xs);
+    const auto& unit_shell = libint2::Shell::unit();
+
+    for (size_t sh1 = 0; sh1 != nsh; ++sh1) {
+        for (size_t sh2 = 0; sh2 <= sh1; ++sh2) {
+            const auto& buffer = engine.compute2<libint2::Operator::coulomb, libint2::BraKet::xs_xs, 0>(aux_basisset[sh1], unit_shell, aux_basisset[sh2], unit_shell);
+            auto calculated_integrals = buffer[0];
+
+            if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
+                continue;
+
+            auto bf1 = static_cast<long>(shell2bf[sh1]);  // (index of) first bf in sh1
+            auto bf2 = static_cast<long>(shell2bf[sh2]);  // (index of) first bf in sh2
+            auto nbf_sh1 = static_cast<long>(aux_basisset[sh1].size());  // number of basis functions in first shell
+            auto nbf_sh2 = static_cast<long>(aux_basisset[sh2].size());  // number of basis functions in second shell
+
+            for (auto f1 = 0L; f1 != nbf_sh1; ++f1) {
+                for (auto f2 = 0L; f2 != nbf_sh2; ++f2) {
+                    double computed_integral = calculated_integrals[f2 + f1 * nbf_sh2];  // integrals are packed in row-major form
+                    V(bf1 + f1, bf2 + f2) = computed_integral;
+                    V(bf2 + f2, bf1 + f1) = computed_integral;
+                }
+            }
+        }
+    }
+
+    return V;
+}
+
+
+/**
+ *  Calculate the three-index Coulomb integrals (P|pq) for the given @param: atoms, in which P runs over the (auxiliary) basisset with name @param: aux_basisset_name and p and q run over the basisset with name @param: basisset_name
+ *
+ *  @return the integrals as a (naux x K^2)-matrix, in which (P|pq) is found at (P, p + K q)
+ *
+ *  The auxiliary shells are distributed over @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads)
+ */
+Eigen::MatrixXd LibintCommunicator::calculateThreeCenterIntegrals(std::string basisset_name, std::string aux_basisset_name, const std::vector<libint2::Atom>& atoms, size_t number_of_threads) const {
+
+    const auto cached_basisset = this->getBasisSet(basisset_name, atoms);
+    const auto cached_aux_basisset = this->getBasisSet(aux_basisset_name, atoms);
+    const auto& basisset = cached_basisset->basisset;
+    const auto& aux_basisset = cached_aux_basisset->basisset;
+
+    const auto nsh = static_cast<size_t>(basisset.size());
+    const auto nsh_aux = static_cast<size_t>(aux_basisset.size());
+    const auto nbf = static_cast<long>(cached_basisset->nbf);
+    const auto naux = static_cast<long>(cached_aux_basisset->nbf);
+    const auto& shell2bf = cached_basisset->shell2bf;  // maps shell index to bf index
+    const auto& aux_shell2bf = cached_aux_basisset->shell2bf;
+
+    Eigen::MatrixXd three_index_integrals = Eigen::MatrixXd::Zero(naux, nbf * nbf);
+
+
+    // Construct the libint2 engine for three-index integrals (P|pq): it should be able to handle the shells of both basis sets
+    libint2::Engine engine (libint2::Operator::coulomb, std::max(cached_basisset->max_nprim, cached_aux_basisset->max_nprim), std::max(cached_basisset->max_l, cached_aux_basisset->max_l));
+    engine.set(libint2::BraKet::xs_xx);
+    const auto& unit_shell = libint2::Shell::unit();
+
+    //  Every thread gets its own copy of the engine, and writes the rows of its own auxiliary shells
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+    std::vector<libint2::Engine> engines (number_of_threads, engine);
+
+    libwint::threading::parallelFor(number_of_threads, [&] (size_t thread_id) {
+        for (size_t sh_aux = thread_id; sh_aux < nsh_aux; sh_aux += number_of_threads) {
+            auto bf_aux = static_cast<long>(aux_shell2bf[sh_aux]);
+            auto nbf_sh_aux = static_cast<long>(aux_basisset[sh_aux].size());
+
+            // (P|pq) = (P|qp), so we only calculate the shell pairs sh2 <= sh1 and mirror the results
+            for (size_t sh1 = 0; sh1 != nsh; ++sh1) {
+                for (size_t sh2 = 0; sh2 <= sh1; ++sh2) {
+                    const auto& buffer = engines[thread_id].compute2<libint2::Operator::coulomb, libint2::BraKet::xs_xx, 0>(aux_basisset[sh_aux], unit_shell, basisset[sh1], basisset[sh2]);
                     auto calculated_integrals = buffer[0];
 
                     if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
                         continue;
 
-                    // Extract the calculated integrals from calculated_integrals.
-                    // In calculated_integrals, the integrals are stored in row major form.
                     auto bf1 = static_cast<long>(shell2bf[sh1]);  // (index of) first bf in sh1
                     auto bf2 = static_cast<long>(shell2bf[sh2]);  // (index of) first bf in sh2
-                    auto bf3 = static_cast<long>(shell2bf[sh3]);  // (index of) first bf in sh3
-                    auto bf4 = static_cast<long>(shell2bf[sh4]);  // (index of) first bf in sh4
-
-
                     auto nbf_sh1 = static_cast<long>(basisset[sh1].size());  // number of basis functions in first shell
                     auto nbf_sh2 = static_cast<long>(basisset[sh2].size());  // number of basis functions in second shell
-                    auto nbf_sh3 = static_cast<long>(basisset[sh3].size());  // number of basis functions in third shell
-                    auto nbf_sh4 = static_cast<long>(basisset[sh4].size());  // number of basis functions in fourth shell
-
-                    for (auto f1 = 0L; f1 != nbf_sh1; ++f1) {
-                        for (auto f2 = 0L; f2 != nbf_sh2; ++f2) {
-                            for (auto f3 = 0L; f3 != nbf_sh3; ++f3) {
-                                for (auto f4 = 0L; f4 != nbf_sh4; ++f4) {
-                                    auto computed_integral = calculated_integrals[f4 + nbf_sh4 * (f3 + nbf_sh3 * (f2 + nbf_sh2 * (f1)))];  // row-major storage accessing
-
-                                    // The two-electron integrals are given in CHEMIST'S: (11|22)
-                                    g(f1 + bf1, f2 + bf2, f3 + bf3, f4 + bf4) = computed_integral;
-                                }
+
+                    for (auto f_aux = 0L; f_aux != nbf_sh_aux; ++f_aux) {
+                        for (auto f1 = 0L; f1 != nbf_sh1; ++f1) {
+                            for (auto f2 = 0L; f2 != nbf_sh2; ++f2) {
+                                double computed_integral = calculated_integrals[f2 + nbf_sh2 * (f1 + nbf_sh1 * f_aux)];  // row-major storage accessing
+
+                                auto P = bf_aux + f_aux;
+                                auto p = bf1 + f1;
+                                auto q = bf2 + f2;
+                                three_index_integrals(P, p + nbf * q) = computed_integral;
+                                three_index_integrals(P, q + nbf * p) = computed_integral;
                             }
                         }
-                    } // data access loop
+                    }
+                }
+            }
+        }
+    });
+
+    return three_index_integrals;
+}
+
+
+/**
+ *  Calculate the Cholesky vectors of the two-electron integrals IN CHEMIST'S NOTATION for the given @param: atoms for the basisset with name @param: basisset_name, i.e. (pq|rs) ~ sum_J L^J_pq L^J_rs
+ *
+ *  The (pq|rs) supermatrix is decomposed by a pivoted incomplete Cholesky decomposition, which stops when the largest remaining diagonal element is smaller than @param: threshold. Since the remaining (residual) supermatrix is positive semi-definite, every element of the reconstructed tensor then has an error smaller than @param: threshold.
+ *  Only the diagonal (pq|pq) and the columns (pq|rs) of the selected pivots rs are calculated, each column together with the other columns of its shell pair, on @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads)
+ *  The columns of a shell pair are kept until none of its pairs can become a pivot anymore, but the kept columns take at most cholesky_column_cache_size bytes (apart from the shell pair in use): beyond that, the least recently used shell pair is dropped and recalculated if it's needed again
+ */
+libwint::LowRankERITensor LibintCommunicator::calculateCholeskyVectors(std::string basisset_name, const std::vector<libint2::Atom>& atoms, double threshold, size_t number_of_threads) const {
+
+    if (threshold <= 0.0) {
+        throw std::invalid_argument("The threshold for the Cholesky decomposition should be positive.");
+    }
+
+    const auto cached_basisset = this->getBasisSet(basisset_name, atoms);
+    const auto& basisset = cached_basisset->basisset;
+
+    const auto nsh = static_cast<size_t>(basisset.size());
+    const auto nbf = cached_basisset->nbf;
+    const auto& shell2bf = cached_basisset->shell2bf;  // maps shell index to bf index
+
+    // Map every basis function to its shell, so that we can find the shell pair of a pivot
+    std::vector<size_t> bf2shell (nbf);
+    for (size_t sh = 0; sh != nsh; ++sh) {
+        for (size_t f = 0; f < basisset[sh].size(); f++) {
+            bf2shell[shell2bf[sh] + f] = sh;
+        }
+    }
+
+
+    // Calculate the diagonal (pq|pq) from the shell quartets (12|12)
+    Eigen::VectorXd diagonal = Eigen::VectorXd::Zero(nbf * nbf);  // (pq|pq) is found at p + K q
+
+    libint2::Engine engine (libint2::Operator::coulomb, cached_basisset->max_nprim, cached_basisset->max_l);
+    const auto& buffer = engine.results();
+
+    for (size_t sh1 = 0; sh1 != nsh; ++sh1) {
+        for (size_t sh2 = 0; sh2 <= sh1; ++sh2) {
+            engine.compute(basisset[sh1], basisset[sh2], basisset[sh1], basisset[sh2]);
 
+            auto calculated_integrals = buffer[0];
 
+            if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
+                continue;
+
+            auto nbf_sh1 = static_cast<size_t>(basisset[sh1].size());
+            auto nbf_sh2 = static_cast<size_t>(basisset[sh2].size());
+
+            for (size_t f1 = 0; f1 != nbf_sh1; ++f1) {
+                for (size_t f2 = 0; f2 != nbf_sh2; ++f2) {
+                    auto f12 = f2 + nbf_sh2 * f1;
+                    auto p = shell2bf[sh1] + f1;
+                    auto q = shell2bf[sh2] + f2;
+
+                    diagonal(p + nbf * q) = calculated_integrals[f12 + nbf_sh1 * nbf_sh2 * f12];
+                    diagonal(q + nbf * p) = diagonal(p + nbf * q);
                 }
             }
         }
-    } // shell loop
-    return g;
-};
+    }
+
+
+    // The pivots are only chosen among the pairs p >= q, since the columns (pq) and (qp) are equal
+    std::vector<size_t> candidates;
+    for (size_t p = 0; p < nbf; p++) {
+        for (size_t q = 0; q <= p; q++) {
+            candidates.push_back(p + nbf * q);
+        }
+    }
+
+    // The columns of the shell pairs that have been calculated, keyed by their shell pair (sh3, sh4) with sh3 >= sh4
+    //  A shell pair is dropped as soon as none of its pairs can become a pivot anymore, and the least recently used one is dropped when the cache would exceed cholesky_column_cache_size bytes
+    struct CachedColumns {
+        Eigen::MatrixXd columns;
+        size_t last_used;
+    };
+    std::map<std::pair<size_t, size_t>, CachedColumns> calculated_columns;
+    size_t cached_bytes = 0;
+
+    // Since the diagonal only decreases, a pair rs can only become a pivot if (rs|rs) is at least the threshold
+    const auto can_become_pivot = [&] (const std::pair<size_t, size_t>& shell_pair) {
+        for (size_t r = shell2bf[shell_pair.first]; r < shell2bf[shell_pair.first] + basisset[shell_pair.first].size(); r++) {
+            for (size_t s = shell2bf[shell_pair.second]; (s < shell2bf[shell_pair.second] + basisset[shell_pair.second].size()) && (s <= r); s++) {
+                if (diagonal(r + nbf * s) >= threshold) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    std::vector<Eigen::VectorXd> cholesky_vectors;
+
+    while (cholesky_vectors.size() < candidates.size()) {
+
+        // Find the pivot: the largest remaining diagonal element
+        size_t pivot = candidates[0];
+        for (const auto& candidate : candidates) {
+            if (diagonal(candidate) > diagonal(pivot)) {
+                pivot = candidate;
+            }
+        }
+
+        const double max_diagonal = diagonal(pivot);
+        if (max_diagonal < threshold) {
+            break;
+        }
+
+
+        // Calculate the column (pq|rs) of the pivot rs, together with the other columns in its shell pair
+        const size_t r = pivot % nbf;
+        const size_t s = pivot / nbf;
+        const size_t sh3 = bf2shell[r];
+        const size_t sh4 = bf2shell[s];
+
+        auto columns_it = calculated_columns.find(std::make_pair(sh3, sh4));
+        if (columns_it == calculated_columns.end()) {
+            Eigen::MatrixXd columns = this->calculateTwoBodyIntegralColumns(*cached_basisset, sh3, sh4, number_of_threads);
+            const size_t bytes = columns.size() * sizeof(double);
+
+            // Make room by dropping the least recently used shell pairs
+            while (!calculated_columns.empty() && (cached_bytes + bytes > LibintCommunicator::cholesky_column_cache_size)) {
+                auto lru_it = calculated_columns.begin();
+                for (auto it = calculated_columns.begin(); it != calculated_columns.end(); ++it) {
+                    if (it->second.last_used < lru_it->second.last_used) {
+                        lru_it = it;
+                    }
+                }
+                cached_bytes -= lru_it->second.columns.size() * sizeof(double);
+                calculated_columns.erase(lru_it);
+            }
+
+            columns_it = calculated_columns.emplace(std::make_pair(sh3, sh4), CachedColumns {std::move(columns), 0}).first;
+            cached_bytes += bytes;
+        }
+        columns_it->second.last_used = cholesky_vectors.size();
+        Eigen::VectorXd column = columns_it->second.columns.col((r - shell2bf[sh3]) + basisset[sh3].size() * (s - shell2bf[sh4]));
+
+
+        // Subtract the contributions of the previous Cholesky vectors and normalize
+        for (const auto& cholesky_vector : cholesky_vectors) {
+            column -= cholesky_vector(pivot) * cholesky_vector;
+        }
+        column /= std::sqrt(max_diagonal);
+
+        diagonal -= column.cwiseAbs2();
+        diagonal(pivot) = 0.0;  // the pivot has been treated exactly, so guard against round-off
+        diagonal(s + nbf * r) = 0.0;
+
+        cholesky_vectors.push_back(column);
+
+
+        // Drop the shell pairs whose columns won't be needed anymore
+        for (auto it = calculated_columns.begin(); it != calculated_columns.end(); ) {
+            if (can_become_pivot(it->first)) {
+                ++it;
+            } else {
+                cached_bytes -= it->second.columns.size() * sizeof(double);
+                it = calculated_columns.erase(it);
+            }
+        }
+    }
+
+
+    Eigen::MatrixXd L (cholesky_vectors.size(), nbf * nbf);
+    for (size_t J = 0; J < cholesky_vectors.size(); J++) {
+        L.row(J) = cholesky_vectors[J].transpose();
+    }
+
+    return libwint::LowRankERITensor(nbf, L);
+}
+
+
+/**
+ *  Call @param: compute_quartet(thread_id, sh1, sh2, sh3, sh4) for all the canonical shell quartets (sh1 >= sh2, sh3 >= sh4, (sh1 sh2) >= (sh3 sh4)) of a given @param: cached_basisset
+ *
+ *  The shell quartets are distributed over @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads), in which the load is balanced by a work-stealing TaskScheduler, based on the estimated cost of the shell quartets
+ */
+void LibintCommunicator::computeCanonicalShellQuartets(const CachedBasisSet& cached_basisset, size_t number_of_threads, const std::function<void(size_t, size_t, size_t, size_t, size_t)>& compute_quartet) const {
+
+    const auto& basisset = cached_basisset.basisset;
+    const auto nsh = static_cast<size_t>(basisset.size());
+
+
+    // Shell quartets differ wildly in cost, so we'll let a work-stealing scheduler balance them over the threads
+    //  We enumerate the canonical shell pairs as sh12 = sh1 (sh1 + 1) / 2 + sh2, such that the canonical shell quartets are all the pairs of shell pairs (bra ket) with ket <= bra
+    std::vector<std::pair<size_t, size_t>> shell_pairs;
+    std::vector<double> cumulative_pair_costs {0.0};  // cumulative_pair_costs[k] is the total estimated cost of the shell pairs 0, ..., k-1
+    for (size_t sh1 = 0; sh1 != nsh; ++sh1) {
+        for (size_t sh2 = 0; sh2 <= sh1; ++sh2) {
+            shell_pairs.emplace_back(sh1, sh2);
+            cumulative_pair_costs.push_back(cumulative_pair_costs.back() + LibintCommunicator::estimateShellCost(basisset[sh1]) * LibintCommunicator::estimateShellCost(basisset[sh2]));
+        }
+    }
+    const auto npairs = shell_pairs.size();
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+
+    //  A task is a contiguous range [(bra_begin, ket_begin), (bra_end, ket_end)) of shell quartets, ordered first by bra and then by ket
+    //  We group cheap shell quartets and split expensive bras into tasks of roughly the same estimated cost, so that there are enough tasks to balance
+    const size_t tasks_per_thread = 16;
+    double total_cost = 0.0;
+    for (size_t bra = 0; bra < npairs; bra++) {
+        total_cost += (cumulative_pair_costs[bra+1] - cumulative_pair_costs[bra]) * cumulative_pair_costs[bra+1];
+    }
+    const double target_cost = total_cost / static_cast<double>(number_of_threads * tasks_per_thread);
+
+    libwint::TaskScheduler scheduler;
+    auto add_task = [&] (size_t bra_begin, size_t ket_begin, size_t bra_end, size_t ket_end, double cost) {
+        scheduler.addTask(cost, [&, bra_begin, ket_begin, bra_end, ket_end] (size_t thread_id) {
+            for (size_t bra = bra_begin; (bra < bra_end) || ((bra == bra_end) && (bra < npairs)); bra++) {
+                const auto ket_first = (bra == bra_begin) ? ket_begin : 0;
+                const auto ket_last = (bra == bra_end) ? ket_end : bra + 1;  // exclusive
+                for (size_t ket = ket_first; ket < ket_last; ket++) {
+                    compute_quartet(thread_id, shell_pairs[bra].first, shell_pairs[bra].second, shell_pairs[ket].first, shell_pairs[ket].second);
+                }
+            }
+        });
+    };
+
+    size_t bra_begin = 0, ket_begin = 0;  // the start of the current task
+    size_t ket = 0;  // the current position is (bra, ket)
+    double cost = 0.0;  // the estimated cost of the current task
+    for (size_t bra = 0; bra < npairs; ) {
+        const double bra_cost = cumulative_pair_costs[bra+1] - cumulative_pair_costs[bra];
+        const double remaining_bra_cost = bra_cost * (cumulative_pair_costs[bra+1] - cumulative_pair_costs[ket]);
+
+        if (cost + remaining_bra_cost < target_cost) {  // the rest of this bra fits in the current task
+            cost += remaining_bra_cost;
+            bra++;
+            ket = 0;
+            continue;
+        }
+
+        // Find the first ket_end for which the current task reaches the target cost
+        const double needed_ket_cost = (target_cost - cost) / bra_cost;
+        auto ket_end = static_cast<size_t>(std::lower_bound(cumulative_pair_costs.begin() + ket + 1, cumulative_pair_costs.begin() + bra + 2, cumulative_pair_costs[ket] + needed_ket_cost) - cumulative_pair_costs.begin());
+        ket_end = std::min(ket_end, bra + 1);
+
+        add_task(bra_begin, ket_begin, bra, ket_end, cost + bra_cost * (cumulative_pair_costs[ket_end] - cumulative_pair_costs[ket]));
+        cost = 0.0;
+        ket = ket_end;
+        if (ket == bra + 1) {  // this bra is finished
+            bra++;
+            ket = 0;
+        }
+        bra_begin = bra;
+        ket_begin = ket;
+    }
+    if (cost > 0.0) {
+        add_task(bra_begin, ket_begin, npairs, 0, cost);
+    }
+
+    scheduler.run(number_of_threads);
+
+    std::lock_guard<std::mutex> lock (this->thread_statistics_mutex);
+    this->thread_statistics = scheduler.get_statistics();
+}
+
+
+/**
+ *  Calculate the columns (pq|rs) of the two-electron integrals IN CHEMIST'S NOTATION, for all the basis functions r in the shell @param: sh3 and s in the shell @param: sh4 of the given @param: cached_basisset
+ *
+ *  @return the integrals as a (K^2 x n_3 n_4)-matrix, in which (pq|rs) is found at (p + K q, (r - r_0) + n_3 (s - s_0)), with r_0 and s_0 the first basis functions in the shells and n_3 and n_4 their number of basis functions
+ *  The bra shells are distributed over @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads)
+ */
+Eigen::MatrixXd LibintCommunicator::calculateTwoBodyIntegralColumns(const CachedBasisSet& cached_basisset, size_t sh3, size_t sh4, size_t number_of_threads) const {
+
+    const auto& basisset = cached_basisset.basisset;
+    const auto nsh = static_cast<size_t>(basisset.size());
+    const auto nbf = static_cast<long>(cached_basisset.nbf);
+    const auto& shell2bf = cached_basisset.shell2bf;  // maps shell index to bf index
+
+    auto nbf_sh3 = static_cast<long>(basisset[sh3].size());  // number of basis functions in third shell
+    auto nbf_sh4 = static_cast<long>(basisset[sh4].size());  // number of basis functions in fourth shell
+
+    Eigen::MatrixXd columns = Eigen::MatrixXd::Zero(nbf * nbf, nbf_sh3 * nbf_sh4);
+
+    // Construct the libint2 engine: every thread gets its own copy, and writes the rows of its own bra shells
+    libint2::Engine engine (libint2::Operator::coulomb, cached_basisset.max_nprim, cached_basisset.max_l);
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+    std::vector<libint2::Engine> engines (number_of_threads, engine);
+
+    libwint::threading::parallelFor(number_of_threads, [&] (size_t thread_id) {
+        for (size_t sh1 = thread_id; sh1 < nsh; sh1 += number_of_threads) {
+
+            // (pq|rs) = (qp|rs), so we only calculate the bra shell pairs sh2 <= sh1 and mirror the results
+            for (size_t sh2 = 0; sh2 <= sh1; ++sh2) {
+                const auto& buffer = engines[thread_id].compute(basisset[sh1], basisset[sh2], basisset[sh3], basisset[sh4]);
+                auto calculated_integrals = buffer[0];
+
+                if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
+                    continue;
+
+                auto bf1 = static_cast<long>(shell2bf[sh1]);  // (index of) first bf in sh1
+                auto bf2 = static_cast<long>(shell2bf[sh2]);  // (index of) first bf in sh2
+                auto nbf_sh1 = static_cast<long>(basisset[sh1].size());  // number of basis functions in first shell
+                auto nbf_sh2 = static_cast<long>(basisset[sh2].size());  // number of basis functions in second shell
+
+                for (auto f1 = 0L; f1 != nbf_sh1; ++f1) {
+                    for (auto f2 = 0L; f2 != nbf_sh2; ++f2) {
+                        for (auto f3 = 0L; f3 != nbf_sh3; ++f3) {
+                            for (auto f4 = 0L; f4 != nbf_sh4; ++f4) {
+                                auto computed_integral = calculated_integrals[f4 + nbf_sh4 * (f3 + nbf_sh3 * (f2 + nbf_sh2 * (f1)))];  // row-major storage accessing
+
+                                auto p = f1 + bf1;
+                                auto q = f2 + bf2;
+                                columns(p + nbf * q, f3 + nbf_sh3 * f4) = computed_integral;
+                                columns(q + nbf * p, f3 + nbf_sh3 * f4) = computed_integral;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    return columns;
+}
+
+
+/**
+ *  Calculate the Cauchy-Schwarz bounds for all the shell pairs in a given @param: cached_basisset
+ *
+ *  @return a symmetric matrix Q, in which Q(sh1, sh2) = sqrt(max |(12|12)|), the maximum being taken over all the basis functions in the shells sh1 and sh2
+ */
+Eigen::MatrixXd LibintCommunicator::calculateSchwarzBounds(const CachedBasisSet& cached_basisset) const {
+
+    const auto& basisset = cached_basisset.basisset;
+    const auto nsh = static_cast<size_t>(basisset.size());
+
+    Eigen::MatrixXd Q = Eigen::MatrixXd::Zero(nsh, nsh);
+
+    // Construct the libint2 engine: the bounds themselves should be calculated with the default (i.e. full) precision
+    libint2::Engine engine (libint2::Operator::coulomb, cached_basisset.max_nprim, cached_basisset.max_l);
+
+    const auto& buffer = engine.results();
+
+    for (size_t sh1 = 0; sh1 != nsh; ++sh1) {
+        for (size_t sh2 = 0; sh2 <= sh1; ++sh2) {
+            engine.compute(basisset[sh1], basisset[sh2], basisset[sh1], basisset[sh2]);
+
+            auto calculated_integrals = buffer[0];
+
+            if (calculated_integrals == nullptr)    // if the zeroth element is nullptr, then the whole shell has been exhausted
+                continue;
+
+            auto nbf_sh1 = static_cast<size_t>(basisset[sh1].size());
+            auto nbf_sh2 = static_cast<size_t>(basisset[sh2].size());
+
+            // Find the largest diagonal integral (f1 f2|f1 f2) in the row-major stored shell set
+            double max_integral = 0.0;
+            for (size_t f1 = 0; f1 != nbf_sh1; ++f1) {
+                for (size_t f2 = 0; f2 != nbf_sh2; ++f2) {
+                    auto f12 = f2 + nbf_sh2 * f1;
+                    max_integral = std::max(max_integral, std::abs(calculated_integrals[f12 + nbf_sh1 * nbf_sh2 * f12]));
+                }
+            }
+
+            Q(sh1, sh2) = std::sqrt(max_integral);
+            Q(sh2, sh1) = Q(sh1, sh2);
+        }
+    }
+
+    return Q;
+}
+
+
+
+/**
+ *  @return an estimate of the (relative) cost of a @param: shell in an integral calculation, which grows with its number of primitives and its angular momentum
+ */
+double LibintCommunicator::estimateShellCost(const libint2::Shell& shell) {
+
+    // The number of primitive integrals grows with the number of primitives, and the work per primitive integral grows with the number of cartesian components (l+1)(l+2)/2
+    const auto l = static_cast<double>(shell.contr[0].l);
+    const auto nprim = static_cast<double>(shell.nprim());
+
+    return nprim * (l + 1) * (l + 2) / 2;
+}
+
 
 
 /*
@@ -174,4 +1007,73 @@ LibintCommunicator& LibintCommunicator::get() {  // need to return by reference
 }
 
 
+/**
+ *  @return the (cached) basis set with name @param: basisset_name for the given @param: atoms
+ *
+ *  The basis set is only constructed if it isn't in the cache already, which holds the most recently used basis sets
+ */
+std::shared_ptr<const CachedBasisSet> LibintCommunicator::getBasisSet(const std::string& basisset_name, const std::vector<libint2::Atom>& atoms) const {
+
+    // The atoms are identified by their atomic number and their (exact) coordinates
+    std::vector<double> atoms_key;
+    atoms_key.reserve(4 * atoms.size());
+    for (const auto& atom : atoms) {
+        atoms_key.push_back(static_cast<double>(atom.atomic_number));
+        atoms_key.push_back(atom.x);
+        atoms_key.push_back(atom.y);
+        atoms_key.push_back(atom.z);
+    }
+
+    // Look up the basis set in the cache, marking it as used. The cache mutex should be held
+    auto find_in_cache = [this, &basisset_name, &atoms_key] () -> std::shared_ptr<const CachedBasisSet> {
+        this->basisset_cache_clock++;
+
+        for (auto& entry : this->basisset_cache) {
+            if ((entry.basisset_name == basisset_name) && (entry.atoms_key == atoms_key)) {
+                entry.last_used = this->basisset_cache_clock;
+                return entry.basisset;
+            }
+        }
+        return nullptr;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock (this->basisset_cache_mutex);
+        auto cached_basisset = find_in_cache();
+        if (cached_basisset) {
+            return cached_basisset;
+        }
+    }
+
+
+    // Constructing the basis set is the expensive part, so we don't hold the lock while doing so
+    auto basisset = std::make_shared<const CachedBasisSet>(basisset_name, atoms);
+
+    // Another thread may have constructed (and cached) the same basis set in the meantime, in which case we use that one instead of caching a duplicate
+    std::lock_guard<std::mutex> lock (this->basisset_cache_mutex);
+    auto cached_basisset = find_in_cache();
+    if (cached_basisset) {
+        return cached_basisset;
+    }
+
+    if (this->basisset_cache.size() >= LibintCommunicator::basisset_cache_capacity) {
+        auto least_recently_used = std::min_element(this->basisset_cache.begin(), this->basisset_cache.end(), [] (const BasisSetCacheEntry& entry1, const BasisSetCacheEntry& entry2) { return entry1.last_used < entry2.last_used; });
+        this->basisset_cache.erase(least_recently_used);
+    }
+    this->basisset_cache.push_back(BasisSetCacheEntry {basisset_name, atoms_key, this->basisset_cache_clock, basisset});
+
+    return basisset;
+}
+
+
+/**
+ *  Remove all basis sets from the cache
+ */
+void LibintCommunicator::clearBasisSetCache() const {
+
+    std::lock_guard<std::mutex> lock (this->basisset_cache_mutex);
+    this->basisset_cache.clear();
+}
+
+
 }  // namespace libwint
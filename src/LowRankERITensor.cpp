@@ -0,0 +1,161 @@
+#include "LowRankERITensor.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+
+
+namespace libwint {
+
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Default constructor for an empty (K = 0, rank = 0) tensor
+ */
+LowRankERITensor::LowRankERITensor() :
+    K (0)
+{}
+
+
+/**
+ *  Constructor for @param: K orbitals from the factors @param: L, given as a (rank x K^2)-matrix in which the column p + K q holds the factors L^P_pq
+ */
+LowRankERITensor::LowRankERITensor(size_t K, const Eigen::MatrixXd& L) :
+    K (K),
+    L (L)
+{
+    if (static_cast<size_t>(L.cols()) != K * K) {
+        throw std::invalid_argument("The number of columns of the given factors should be the square of the number of orbitals.");
+    }
+}
+
+
+
+/**
+ *  Constructor from a dense rank-four tensor @param: g (IN CHEMIST'S NOTATION), through a pivoted incomplete Cholesky decomposition of the (pq|rs) supermatrix, which stops when the largest remaining diagonal element is smaller than @param: threshold
+ *
+ *  Every element of the reconstructed tensor then has an error smaller than @param: threshold
+ */
+LowRankERITensor::LowRankERITensor(const Eigen::Tensor<double, 4>& g, double threshold) :
+    K (static_cast<size_t>(g.dimension(0)))
+{
+    if ((g.dimension(1) != g.dimension(0)) || (g.dimension(2) != g.dimension(0)) || (g.dimension(3) != g.dimension(0))) {
+        throw std::invalid_argument("The given tensor is not a rank-four tensor of equal dimensions.");
+    }
+    if (threshold <= 0.0) {
+        throw std::invalid_argument("The threshold for the Cholesky decomposition should be positive.");
+    }
+
+    // The (column-major) tensor is the (pq|rs) supermatrix, in which (pq|rs) is found at (p + K q, r + K s)
+    const auto dim = static_cast<long>(this->K * this->K);
+    Eigen::Map<const Eigen::MatrixXd> supermatrix (g.data(), dim, dim);
+    Eigen::VectorXd diagonal = supermatrix.diagonal();
+
+    std::vector<Eigen::VectorXd> cholesky_vectors;
+    while (cholesky_vectors.size() < static_cast<size_t>(dim)) {
+
+        // Find the pivot: the largest remaining diagonal element
+        long pivot;
+        const double max_diagonal = diagonal.maxCoeff(&pivot);
+        if (max_diagonal < threshold) {
+            break;
+        }
+
+        // Subtract the contributions of the previous Cholesky vectors from the pivot column and normalize
+        Eigen::VectorXd column = supermatrix.col(pivot);
+        for (const auto& cholesky_vector : cholesky_vectors) {
+            column -= cholesky_vector(pivot) * cholesky_vector;
+        }
+        column /= std::sqrt(max_diagonal);
+
+        diagonal -= column.cwiseAbs2();
+        diagonal(pivot) = 0.0;  // the pivot has been treated exactly, so guard against round-off
+        cholesky_vectors.push_back(column);
+    }
+
+    this->L = Eigen::MatrixXd (cholesky_vectors.size(), dim);
+    for (size_t J = 0; J < cholesky_vectors.size(); J++) {
+        this->L.row(J) = cholesky_vectors[J].transpose();
+    }
+}
+
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  @return the reconstructed block (p q|r s) of the two-electron integrals, with dimensions (@param: n_p, @param: n_q, @param: n_r, @param: n_s), starting at the indices @param: p, @param: q, @param: r and @param: s
+ */
+Eigen::Tensor<double, 4> LowRankERITensor::reconstructBlock(size_t p, size_t q, size_t r, size_t s, size_t n_p, size_t n_q, size_t n_r, size_t n_s) const {
+
+    if ((p + n_p > this->K) || (q + n_q > this->K) || (r + n_r > this->K) || (s + n_s > this->K)) {
+        throw std::invalid_argument("The requested block is out of range.");
+    }
+
+    // Gather the factors of the bra and ket pairs, such that the pairs are ordered like the (column-major) indices of the block
+    const auto rank = static_cast<long>(this->get_rank());
+    Eigen::MatrixXd L_bra (rank, static_cast<long>(n_p * n_q));
+    for (size_t j = 0; j < n_q; j++) {
+        for (size_t i = 0; i < n_p; i++) {
+            L_bra.col(i + n_p * j) = this->L.col((p + i) + this->K * (q + j));
+        }
+    }
+
+    Eigen::MatrixXd L_ket (rank, static_cast<long>(n_r * n_s));
+    for (size_t l = 0; l < n_s; l++) {
+        for (size_t k = 0; k < n_r; k++) {
+            L_ket.col(k + n_r * l) = this->L.col((r + k) + this->K * (s + l));
+        }
+    }
+
+
+    // The block, as a (n_p n_q x n_r n_s)-matrix, has the same (column-major) memory layout as the rank-four tensor
+    Eigen::Tensor<double, 4> block (static_cast<long>(n_p), static_cast<long>(n_q), static_cast<long>(n_r), static_cast<long>(n_s));
+    Eigen::Map<Eigen::MatrixXd> block_matrix (block.data(), static_cast<long>(n_p * n_q), static_cast<long>(n_r * n_s));
+    block_matrix.noalias() = L_bra.transpose() * L_ket;
+
+    return block;
+}
+
+
+/**
+ *  @return the reconstructed dense rank-four tensor of the two-electron integrals
+ */
+Eigen::Tensor<double, 4> LowRankERITensor::toDense() const {
+    return this->reconstructBlock(0, 0, 0, 0, this->K, this->K, this->K, this->K);
+}
+
+
+
+/**
+ *  Transform the factors according to the basis transformation matrix @param: T (i.e. L^P -> T^T L^P T for every P), which may be rectangular
+ */
+void LowRankERITensor::transform(const Eigen::MatrixXd& T) {
+
+    if (static_cast<size_t>(T.rows()) != this->K) {
+        throw std::invalid_argument("The number of rows of the transformation matrix should be the number of orbitals.");
+    }
+
+    const auto K = static_cast<long>(this->K);
+    const auto K_new = T.cols();
+    Eigen::MatrixXd L_transformed (this->L.rows(), K_new * K_new);
+
+    for (long P = 0; P < this->L.rows(); P++) {
+        Eigen::RowVectorXd L_P_row = this->L.row(P);
+        Eigen::Map<const Eigen::MatrixXd> L_P (L_P_row.data(), K, K);  // L^P_pq is found at (p, q)
+        Eigen::MatrixXd L_P_transformed = T.transpose() * L_P * T;
+        L_transformed.row(P) = Eigen::Map<const Eigen::RowVectorXd> (L_P_transformed.data(), K_new * K_new);
+    }
+
+    this->L = L_transformed;
+    this->K = static_cast<size_t>(K_new);
+}
+
+
+}  // namespace libwint
@@ -0,0 +1,114 @@
+#include "MappedERITensor.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+
+
+namespace libwint {
+
+
+namespace {
+
+const char tensor_file_magic[8] = {'L', 'W', 'T', 'E', 'N', 'S', 'O', 'R'};
+const uint64_t tensor_file_version = 1;
+const size_t tensor_file_header_size = 3 * sizeof(uint64_t);  // the magic, the version and K
+
+}  // anonymous namespace
+
+
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Constructor that maps the tensor file @param: filename
+ */
+MappedERITensor::MappedERITensor(const std::string& filename) :
+    mapped_file (std::make_shared<const libwint::MappedFile>(filename))
+{
+    const char* file_data = this->mapped_file->get_data();
+    const size_t file_size = this->mapped_file->get_size();
+
+    if ((file_size < tensor_file_header_size) || (std::memcmp(file_data, tensor_file_magic, sizeof(tensor_file_magic)) != 0)) {
+        throw std::runtime_error("The provided file is not a tensor file.");
+    }
+
+    uint64_t header[2];
+    std::memcpy(header, file_data + sizeof(tensor_file_magic), sizeof(header));
+    if (header[0] != tensor_file_version) {
+        throw std::runtime_error("The provided tensor file has an unsupported version.");
+    }
+
+    // K comes from the file, so K^4 is built up factor by factor, making sure it never exceeds the number of elements that the file holds
+    this->K = static_cast<size_t>(header[1]);
+    const size_t number_of_bytes = file_size - tensor_file_header_size;
+    const size_t number_of_elements = number_of_bytes / sizeof(double);
+    size_t expected_number_of_elements = 1;
+    for (size_t factor = 0; factor < 4; factor++) {
+        if ((this->K != 0) && (expected_number_of_elements > number_of_elements / this->K)) {
+            throw std::runtime_error("The size of the provided tensor file doesn't match its dimension.");
+        }
+        expected_number_of_elements *= this->K;
+    }
+    if ((number_of_bytes % sizeof(double) != 0) || (expected_number_of_elements != number_of_elements)) {
+        throw std::runtime_error("The size of the provided tensor file doesn't match its dimension.");
+    }
+
+    // The mapping is page-aligned and the header is a multiple of 8 bytes, so the elements are properly aligned
+    this->data = reinterpret_cast<const double*>(file_data + tensor_file_header_size);
+}
+
+
+
+/*
+ *  STATIC PUBLIC METHODS
+ */
+
+/**
+ *  Write the rank-four tensor @param: g to the tensor file @param: filename, so that it can be mapped
+ */
+void MappedERITensor::save(const std::string& filename, const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g) {
+
+    const auto K = g.dimension(0);
+    if ((g.dimension(1) != K) || (g.dimension(2) != K) || (g.dimension(3) != K)) {
+        throw std::invalid_argument("The given tensor is not a rank-four tensor of equal dimensions.");
+    }
+
+    // The file is replaced instead of rewritten, since other processes (or g itself) may still map it
+    libwint::ReplacingOutputFile output_file (filename);
+    auto& output_file_stream = output_file.get_stream();
+    if (!output_file_stream.good()) {
+        throw std::runtime_error("The tensor file could not be created. Maybe you specified a wrong path?");
+    }
+
+    uint64_t header[2] = {tensor_file_version, static_cast<uint64_t>(K)};
+    output_file_stream.write(tensor_file_magic, sizeof(tensor_file_magic));
+    output_file_stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    output_file_stream.write(reinterpret_cast<const char*>(g.data()), static_cast<std::streamsize>(g.size() * sizeof(double)));
+
+    if (!output_file_stream.good()) {
+        throw std::runtime_error("Something went wrong while writing the tensor file. Maybe the disk is full?");
+    }
+    output_file.commit();
+}
+
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  @return a read-only view of the mapped tensor, which is valid as long as this MappedERITensor (or a copy) exists
+ */
+Eigen::TensorMap<const Eigen::Tensor<double, 4>> MappedERITensor::get_view() const {
+
+    const auto K = static_cast<long>(this->K);
+    return Eigen::TensorMap<const Eigen::Tensor<double, 4>> (this->data, K, K, K, K);
+}
+
+
+}  // namespace libwint
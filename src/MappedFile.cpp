@@ -0,0 +1,129 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+
+namespace libwint {
+
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Constructor that maps the file @param: filename
+ */
+MappedFile::MappedFile(const std::string& filename) :
+    address (nullptr),
+    size (0)
+{
+    int file_descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (file_descriptor == -1) {
+        throw std::runtime_error("The file " + filename + " could not be opened for mapping: " + std::strerror(errno));
+    }
+
+    struct stat file_status;
+    if (::fstat(file_descriptor, &file_status) == -1) {
+        ::close(file_descriptor);
+        throw std::runtime_error("The size of the file " + filename + " could not be determined: " + std::strerror(errno));
+    }
+    this->size = static_cast<size_t>(file_status.st_size);
+
+    // An empty file can't be mapped, but there's nothing to read anyway
+    if (this->size > 0) {
+        void* address = ::mmap(nullptr, this->size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+        if (address == MAP_FAILED) {
+            ::close(file_descriptor);
+            throw std::runtime_error("The file " + filename + " could not be mapped: " + std::strerror(errno));
+        }
+        this->address = address;
+    }
+
+    // The mapping stays valid after closing the file descriptor
+    ::close(file_descriptor);
+}
+
+
+
+/*
+ *  DESTRUCTOR
+ */
+
+MappedFile::~MappedFile() {
+
+    if (this->address != nullptr) {
+        ::munmap(this->address, this->size);
+    }
+}
+
+
+
+
+/*
+ *  REPLACINGOUTPUTFILE
+ */
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Constructor that creates a temporary file for the destination @param: filename
+ */
+ReplacingOutputFile::ReplacingOutputFile(const std::string& filename) :
+    filename (filename),
+    temporary_filename (filename + ".tmp." + std::to_string(::getpid())),
+    output_file_stream (this->temporary_filename, std::ios::binary | std::ios::trunc),
+    is_committed (false)
+{}
+
+
+
+/*
+ *  DESTRUCTOR
+ */
+
+/**
+ *  Remove the temporary file, if it hasn't been committed
+ */
+ReplacingOutputFile::~ReplacingOutputFile() {
+
+    if (!this->is_committed) {
+        this->output_file_stream.close();
+        std::remove(this->temporary_filename.c_str());
+    }
+}
+
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  Close the temporary file and rename it to the destination, throwing a std::runtime_error if anything went wrong while writing or renaming
+ */
+void ReplacingOutputFile::commit() {
+
+    this->output_file_stream.close();
+    if (this->output_file_stream.fail()) {
+        throw std::runtime_error("Something went wrong while writing the file " + this->filename + ". Maybe the disk is full?");
+    }
+
+    if (std::rename(this->temporary_filename.c_str(), this->filename.c_str()) != 0) {
+        throw std::runtime_error("The file " + this->filename + " could not be replaced: " + std::strerror(errno));
+    }
+    this->is_committed = true;
+}
+
+
+}  // namespace libwint
@@ -0,0 +1,148 @@
+#include "PackedERITensor.hpp"
+
+#include <stdexcept>
+
+
+
+namespace libwint {
+
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Default constructor for an empty (K = 0) tensor
+ */
+PackedERITensor::PackedERITensor() :
+    PackedERITensor(0)
+{}
+
+
+/**
+ *  Constructor for a tensor of zeros for @param: K orbitals
+ */
+PackedERITensor::PackedERITensor(size_t K) :
+    K (K),
+    data (Eigen::VectorXd::Zero(PackedERITensor::numberOfElements(K)))
+{}
+
+
+/**
+ *  Constructor from a dense rank-four tensor @param: g
+ *
+ *  Only the canonical elements (p >= q, r >= s, (pq) >= (rs)) are read, so @param: g is assumed to have the 8-fold permutational symmetry
+ */
+PackedERITensor::PackedERITensor(const Eigen::Tensor<double, 4>& g) :
+    PackedERITensor(Eigen::TensorMap<const Eigen::Tensor<double, 4>>(g.data(), g.dimensions()))
+{}
+
+
+/**
+ *  Constructor from a view @param: g on a dense rank-four tensor (e.g. a memory-mapped one), which isn't copied
+ *
+ *  Only the canonical elements (p >= q, r >= s, (pq) >= (rs)) are read, so @param: g is assumed to have the 8-fold permutational symmetry
+ */
+PackedERITensor::PackedERITensor(const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g) :
+    PackedERITensor(static_cast<size_t>(g.dimension(0)))
+{
+    if ((g.dimension(1) != g.dimension(0)) || (g.dimension(2) != g.dimension(0)) || (g.dimension(3) != g.dimension(0))) {
+        throw std::invalid_argument("The given tensor is not a rank-four tensor of equal dimensions.");
+    }
+
+    // Walk through the canonical elements
+    const auto dim = static_cast<long>(this->K);
+    for (long p = 0; p < dim; p++) {
+        for (long q = 0; q <= p; q++) {
+            for (long r = 0; r <= p; r++) {
+                const long s_max = (r == p) ? q : r;
+                for (long s = 0; s <= s_max; s++) {
+                    this->data(PackedERITensor::compoundIndex(p, q, r, s)) = g(p, q, r, s);
+                }
+            }
+        }
+    }
+}
+
+
+
+/*
+ *  STATIC PUBLIC METHODS
+ */
+
+/**
+ *  @return the number of elements that are stored for @param: K orbitals
+ */
+size_t PackedERITensor::numberOfElements(size_t K) {
+
+    const size_t number_of_pairs = K * (K + 1) / 2;
+    return number_of_pairs * (number_of_pairs + 1) / 2;
+}
+
+
+
+/**
+ *  @return the dense rank-four tensor for @param: K orbitals, in which every element of the unique elements @param: data (in the order of their compound index) is copied to its 8 permutationally equivalent positions
+ */
+Eigen::Tensor<double, 4> PackedERITensor::unpack(const Eigen::Ref<const Eigen::VectorXd>& data, size_t K) {
+
+    if (static_cast<size_t>(data.size()) != PackedERITensor::numberOfElements(K)) {
+        throw std::invalid_argument("The given number of unique elements doesn't match the given number of orbitals.");
+    }
+
+    const auto dim = static_cast<long>(K);
+    Eigen::Tensor<double, 4> g (dim, dim, dim, dim);
+
+    for (long p = 0; p < dim; p++) {
+        for (long q = 0; q <= p; q++) {
+            for (long r = 0; r <= p; r++) {
+                const long s_max = (r == p) ? q : r;
+                for (long s = 0; s <= s_max; s++) {
+                    double value = data(PackedERITensor::compoundIndex(p, q, r, s));
+
+                    g(p,q,r,s) = value;
+                    g(p,q,s,r) = value;
+                    g(q,p,r,s) = value;
+                    g(q,p,s,r) = value;
+
+                    g(r,s,p,q) = value;
+                    g(s,r,p,q) = value;
+                    g(r,s,q,p) = value;
+                    g(s,r,q,p) = value;
+                }
+            }
+        }
+    }
+
+    return g;
+}
+
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  @return the dense rank-four tensor, in which every stored element is copied to its 8 permutationally equivalent positions
+ */
+Eigen::Tensor<double, 4> PackedERITensor::toDense() const {
+
+    return PackedERITensor::unpack(this->data, this->K);
+}
+
+
+/**
+ *  @return if this tensor is equal to @param: other, within a given @param: tolerance
+ */
+bool PackedERITensor::isApprox(const PackedERITensor& other, double tolerance) const {
+
+    if (this->K != other.K) {
+        return false;
+    }
+
+    return (this->K == 0) || ((this->data - other.data).cwiseAbs().maxCoeff() < tolerance);
+}
+
+
+}  // namespace libwint
@@ -1,5 +1,19 @@
 #include "SOBasis.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <utility>
+
+#include "io.hpp"
+#include "threading.hpp"
+
 
 
 
@@ -11,15 +25,24 @@ namespace libwint {
 
 /**
  *  Parse a given FCIDUMP file for the one- and two-electron integrals
+ *
+ *  The file can be compressed (gzip or zstd, see io::DecompressingReader), and fcidump_filename.gz or fcidump_filename.zst is read if fcidump_filename doesn't exist. The text is tokenized by an io::Scanner, and the parsing throughput is added to the parse statistics
  */
 void SOBasis::parseFCIDUMPFile(std::string fcidump_filename) {
 
-    // Find the extension of the given path (https://stackoverflow.com/a/51992)
+    // Find the extension of the given path (https://stackoverflow.com/a/51992), disregarding a compression extension
     std::string extension;
-    std::string::size_type idx = fcidump_filename.rfind('.');
+    std::string uncompressed_filename = fcidump_filename;
+    for (const char* compression_extension : {".gz", ".zst"}) {
+        const size_t extension_size = std::strlen(compression_extension);
+        if ((uncompressed_filename.size() > extension_size) && (uncompressed_filename.compare(uncompressed_filename.size() - extension_size, extension_size, compression_extension) == 0)) {
+            uncompressed_filename.erase(uncompressed_filename.size() - extension_size);
+        }
+    }
+    std::string::size_type idx = uncompressed_filename.rfind('.');
 
     if (idx != std::string::npos) {
-        extension = fcidump_filename.substr(idx+1);
+        extension = uncompressed_filename.substr(idx+1);
     } else {
         throw std::runtime_error("I did not find an extension in your given path.");
     }
@@ -28,97 +51,185 @@ void SOBasis::parseFCIDUMPFile(std::string fcidump_filename) {
         throw std::runtime_error("You did not provide a .FCIDUMP file name");
     }
 
-    // If the xyz_filename isn't properly converted into an input file stream, we assume the user supplied a wrong file
-    std::ifstream input_file_stream (fcidump_filename);
-
-    if (!input_file_stream.good()) {
-        throw std::runtime_error("The provided FCIDUMP file is illegible. Maybe you specified a wrong path?");
+    // If the file can't be opened, we assume the user supplied a wrong file
+    fcidump_filename = libwint::io::resolveFilename(fcidump_filename);
+    std::unique_ptr<libwint::io::LineChunkReader> reader;
+    try {
+        reader.reset(new libwint::io::LineChunkReader(fcidump_filename, 1 << 22));
+    } catch (const std::runtime_error&) {
+        if (libwint::io::isSupported(libwint::io::detectCompression(fcidump_filename))) {
+            throw std::runtime_error("The provided FCIDUMP file is illegible. Maybe you specified a wrong path?");
+        }
+        throw;
     }
 
+    auto start_time = std::chrono::steady_clock::now();
+    Eigen::MatrixXd h_SO = Eigen::MatrixXd::Zero(this->K, this->K);
+    Eigen::Tensor<double, 4> g_SO (this->K, this->K, this->K, this->K);
+    g_SO.setZero();
 
+    bool is_header = true;
+    bool found_number_of_orbitals = false;
+    size_t number_of_lines = 0;  // the number of lines in the previous chunks
+
+
+    // Do the actual parsing, chunk by chunk
+    const char* begin;
+    const char* end;
+    std::vector<char> chunk;
+    while (reader->read(begin, end, chunk)) {
+        libwint::io::Scanner scanner (begin, end);
+
+        //  The header (&FCI NORB=...,NELEC=...,MS2=..., ORBSYM=..., ISYM=...) ends with a line containing &END or /. Check the number of orbitals to see if it's a valid FCIDUMP file
+        while (is_header && !scanner.atEnd()) {
+            const char* line_begin = scanner.get_position();
+            scanner.skipLine();
+            const std::string line (line_begin, scanner.get_position());
+
+            auto norb = line.find("NORB");
+            if (norb != std::string::npos) {
+                auto equals = line.find('=', norb);
+                if (equals == std::string::npos) {
+                    throw std::runtime_error("The NORB entry in the header of the provided FCIDUMP file is illegible.");
+                }
+
+                libwint::io::Scanner norb_scanner (line.c_str() + equals + 1, line.c_str() + line.size());
+                size_t value = 0;
+                if (!norb_scanner.readIndex(value)) {
+                    throw std::runtime_error("The NORB entry in the header of the provided FCIDUMP file is illegible.");
+                }
+                if (this->K != value) {
+                    throw std::invalid_argument("It appears that the given number of spatial orbitals is inconsistent with the given FCIDUMP file.");
+                }
+                found_number_of_orbitals = true;
+            }
 
-    // Do the actual parsing
+            auto first = line.find_first_not_of(" \t\r\n");
+            if ((line.find("&END") != std::string::npos) || (line.find("&end") != std::string::npos) || ((first != std::string::npos) && (line[first] == '/'))) {
+                is_header = false;
+            }
+        }
 
-    //  Get the number of orbitals to check if it's a valid FCIDUMP file
-    std::string start_line;  // first line contains orbitals and electron count
-    std::getline(input_file_stream, start_line);
-    std::stringstream linestream (start_line);
 
-    size_t value;
-    char iter;
+        //  Start reading in the one- and two-electron integrals
+        double x;
+        size_t i, j, a, b;
 
-    while (linestream >> iter) {
-        if (iter == '=') {
-            linestream >> value;  // right here we have the number of orbitals
-            if (this->K != value) {
-                throw std::invalid_argument("It appears that the given number of spatial orbitals is inconsistent with the given FCIDUMP file.");
+        while (!scanner.atEnd()) {
+            scanner.skipBlanks();
+            if (scanner.atEndOfLine()) {  // skip empty lines
+                scanner.skipLine();
+                continue;
             }
-            break;  // we can finish reading the linestream after we found K
-        }
-    }
 
+            // Based on what the values of the indices are, we can read one-electron integrals, two-electron integrals and the internuclear repulsion energy
+            //  See also (http://hande.readthedocs.io/en/latest/manual/integrals.html)
+            //  I think the documentation is a bit unclear for the two-electron integrals, but we can rest assured that FCIDUMP files give the two-electron integrals in CHEMIST's notation.
+            const size_t line_number = number_of_lines + scanner.get_line_number();
+            if (!(scanner.readDouble(x) && scanner.readIndex(i) && scanner.readIndex(a) && scanner.readIndex(j) && scanner.readIndex(b)) || (i > this->K) || (a > this->K) || (j > this->K) || (b > this->K)) {
+                throw std::runtime_error("Line " + std::to_string(line_number) + " of the provided FCIDUMP file is illegible.");
+            }
+            scanner.skipLine();
 
-    Eigen::MatrixXd h_SO = Eigen::MatrixXd::Zero(this->K, this->K);
-    Eigen::Tensor<double, 4> g_SO (this->K, this->K, this->K, this->K);
-    g_SO.setZero();
+            //  Internuclear repulsion energy
+            if ((i == 0) && (j == 0) && (a == 0) && (b == 0)) {
+                this->core_energy = x;
+            }
+
+            //  Single-particle eigenvalues (skipped)
+            else if ((i > 0) && (a == 0) && (j == 0) && (b == 0)) {}
+
+            //  One-electron integrals (h_core)
+            else if ((i > 0) && (a > 0) && (j == 0) && (b == 0)) {
+                size_t p = i - 1;
+                size_t q = a - 1;
+                h_SO(p,q) = x;
+
+                // Apply the permutational symmetry for real orbitals
+                h_SO(q,p) = x;
+            }
 
-    //  Skip 3 lines
-    for (size_t counter = 0; counter < 3; counter++) {
-        std::getline(input_file_stream, start_line);
+            //  Two-electron integrals are given in CHEMIST'S NOTATION, so just copy them over
+            else if ((i > 0) && (a > 0) && (j > 0) && (b > 0)) {
+                size_t p = i - 1;
+                size_t q = a - 1;
+                size_t r = j - 1;
+                size_t s = b - 1;
+                g_SO(p,q,r,s) = x;
+
+                // Apply the permutational symmetries for real orbitals
+                g_SO(p,q,s,r) = x;
+                g_SO(q,p,r,s) = x;
+                g_SO(q,p,s,r) = x;
+
+                g_SO(r,s,p,q) = x;
+                g_SO(s,r,p,q) = x;
+                g_SO(r,s,q,p) = x;
+                g_SO(s,r,q,p) = x;
+            }
+
+            //  Any other pattern of zero indices (e.g. x 0 3 0 0 or x 1 0 2 3) doesn't mean anything
+            else {
+                throw std::runtime_error("Line " + std::to_string(line_number) + " of the provided FCIDUMP file is illegible.");
+            }
+        }  // while loop
+
+        number_of_lines += scanner.get_line_number() - 1;
     }
 
+    if (!found_number_of_orbitals) {
+        throw std::runtime_error("The provided FCIDUMP file doesn't specify the number of orbitals (NORB) in its header.");
+    }
 
-    //  Start reading in the one- and two-electron integrals
-    double x;
-    size_t i, j, a, b;
+    this->h_SO = h_SO;
+    this->g_SO = g_SO;
+    this->g_SO_mapped.reset();
 
-    std::string line;
-    while (std::getline(input_file_stream, line)) {
-        std::istringstream iss (line);
 
-        // Based on what the values of the indices are, we can read one-electron integrals, two-electron integrals and the internuclear repulsion energy
-        //  See also (http://hande.readthedocs.io/en/latest/manual/integrals.html)
-        //  I think the documentation is a bit unclear for the two-electron integrals, but we can rest assured that FCIDUMP files give the two-electron integrals in CHEMIST's notation.
-        iss >> x >> i >> a >> j >> b;
+    libwint::io::ParseStatistics statistics;
+    statistics.number_of_bytes = reader->get_number_of_bytes();
+    statistics.number_of_lines = number_of_lines;
+    statistics.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    this->parse_statistics += statistics;
+}
 
-        //  Internuclear repulsion energy (skipped)
-        if ((i == 0) && (j == 0) && (a == 0) && (b == 0)) {}
 
-        //  Single-particle eigenvalues (skipped)
-        else if ((a == 0) && (j == 0) && (b == 0)) {}
+/**
+ *  If the two-electron integrals are memory-mapped, copy them into g_SO, so that they can be modified
+ */
+void SOBasis::materializeTwoElectronIntegrals() {
 
-        //  One-electron integrals (h_core)
-        else if ((j == 0) && (b == 0)) {
-            size_t p = i - 1;
-            size_t q = a - 1;
-            h_SO(p,q) = x;
+    if (this->g_SO_mapped) {
+        this->g_SO = this->g_SO_mapped->get_view();
+        this->g_SO_mapped.reset();
+    }
+}
 
-            // Apply the permutational symmetry for real orbitals
-            h_SO(q,p) = x;
-        }
 
-        //  Two-electron integrals are given in CHEMIST'S NOTATION, so just copy them over
-        else if ((i > 0) && (a > 0) && (j > 0) && (b > 0)) {
-            size_t p = i - 1;
-            size_t q = a - 1;
-            size_t r = j - 1;
-            size_t s = b - 1;
-            g_SO(p,q,r,s) = x;
-
-            // Apply the permutational symmetries for real orbitals
-            g_SO(p,q,s,r) = x;
-            g_SO(q,p,r,s) = x;
-            g_SO(q,p,s,r) = x;
-
-            g_SO(r,s,p,q) = x;
-            g_SO(s,r,p,q) = x;
-            g_SO(r,s,q,p) = x;
-            g_SO(s,r,q,p) = x;
-        }
-    }  // while loop
+/**
+ *  @return the unique two-electron integrals under the 8-fold permutational symmetry
+ */
+libwint::PackedERITensor SOBasis::packTwoElectronIntegrals() const {
 
-    this->h_SO = h_SO;
-    this->g_SO = g_SO;
+    return libwint::PackedERITensor(this->get_g_SO_view());
+}
+
+
+/**
+ *  Set the core energy and the one- and two-electron integrals from a given @param: checkpoint
+ */
+void SOBasis::loadIntegrals(const libwint::IntegralCheckpoint& checkpoint) {
+
+    if (checkpoint.get_K() != this->K) {
+        throw std::invalid_argument("It appears that the given number of spatial orbitals is inconsistent with the given checkpoint file.");
+    }
+
+    this->core_energy = checkpoint.get_core_energy();
+    this->h_SO = checkpoint.get_h();
+
+    // The two-electron integrals are unpacked straight from the mapping
+    this->g_SO = libwint::PackedERITensor::unpack(checkpoint.get_packed_g(), this->K);
+    this->g_SO_mapped.reset();
 }
 
 
@@ -136,7 +247,31 @@ SOBasis::SOBasis(const libwint::AOBasis& ao_basis, const Eigen::MatrixXd& C) :
     Eigen::MatrixXd h_AO = ao_basis.get_T() + ao_basis.get_V();
     this->h_SO = libwint::transformations::transform_AO_to_SO(h_AO, C);
 
-    this->g_SO = libwint::transformations::transform_AO_to_SO(ao_basis.get_g(), C);
+    // Only the unique integrals are transformed (mapped integrals straight from the mapping), and then unpacked
+    const auto g_SO_packed = libwint::transformations::transformTwoElectronIntegralsPacked(ao_basis.get_g_view(), C);
+    this->g_SO = libwint::PackedERITensor::unpack(g_SO_packed.get_data(), g_SO_packed.get_K());
+}
+
+/**
+ *  Constructor for the active space that is spanned by the orbitals @param: C_active, in which the doubly occupied orbitals @param: C_core are frozen, based on a given @param: ao_basis (every column of C_core and C_active represents a spatial orbital, e.g. C.leftCols(n_core) and C.middleCols(n_core, n_active))
+ *
+ *  The one-electron integrals are the inactive Fock matrix in the active orbitals (see transformations::calculateInactiveFockMatrix), the core energy is the energy of the core orbitals and the two-electron integrals are only transformed to the active orbitals, which costs O(K^4 n_active) instead of O(K^5)
+ */
+SOBasis::SOBasis(const libwint::AOBasis& ao_basis, const Eigen::MatrixXd& C_core, const Eigen::MatrixXd& C_active) :
+        K (static_cast<size_t>(C_active.cols()))
+{
+
+    const auto g_AO = ao_basis.get_g_view();
+    if ((C_core.rows() != g_AO.dimension(0)) || (C_active.rows() != g_AO.dimension(0))) {
+        throw std::invalid_argument("The number of rows of the coefficient matrices should be equal to the number of basis functions.");
+    }
+
+    Eigen::MatrixXd h_AO = ao_basis.get_T() + ao_basis.get_V();
+    Eigen::MatrixXd F_I = libwint::transformations::calculateInactiveFockMatrix(h_AO, g_AO, C_core);
+
+    this->core_energy = libwint::transformations::calculateCoreEnergy(h_AO, F_I, C_core);
+    this->h_SO = libwint::transformations::transform_AO_to_SO(F_I, C_active);
+    this->g_SO = libwint::transformations::transformTwoElectronIntegrals(g_AO, C_active);  // C_active is rectangular
 }
 
 /**
@@ -157,15 +292,179 @@ SOBasis::SOBasis(std::string fcidump_filename, size_t K, bool hack) :
 }
 
 
+/*
+ *  GETTERS
+ */
+
+const Eigen::Tensor<double, 4>& SOBasis::get_g_SO() const {
+
+    if (this->g_SO_mapped) {
+        throw std::logic_error("The two-electron integrals are memory-mapped, and can only be accessed through get_g_SO_view().");
+    } else {
+        return this->g_SO;
+    }
+}
+
+Eigen::TensorMap<const Eigen::Tensor<double, 4>> SOBasis::get_g_SO_view() const {
+
+    if (this->g_SO_mapped) {
+        return this->g_SO_mapped->get_view();
+    } else {
+        return Eigen::TensorMap<const Eigen::Tensor<double, 4>> (this->g_SO.data(), this->g_SO.dimensions());
+    }
+}
+
+
+
+/*
+ *  RELEASE
+ */
+
+/**
+ *  @return the one-electron integrals, which are moved out of this basis (so they aren't copied), leaving it with an empty matrix
+ */
+Eigen::MatrixXd SOBasis::release_h_SO() {
+
+    Eigen::MatrixXd h_SO = std::move(this->h_SO);
+    this->h_SO.resize(0, 0);
+    return h_SO;
+}
+
+
+/**
+ *  @return the two-electron integrals, which are moved out of this basis (so they aren't copied), leaving it with an empty tensor
+ *
+ *  Memory-mapped integrals are copied onto the heap, after which the mapping is released
+ */
+Eigen::Tensor<double, 4> SOBasis::release_g_SO() {
+
+    this->materializeTwoElectronIntegrals();
+
+    Eigen::Tensor<double, 4> g_SO = std::move(this->g_SO);
+    this->g_SO = Eigen::Tensor<double, 4>();
+    return g_SO;
+}
+
+
+
 /*
  *  PUBLIC METHODS
  */
 
+/**
+ *  Write the two-electron integrals to the tensor file @param: filename (see MappedERITensor), so that they can be mapped by other SOBasis instances
+ */
+void SOBasis::saveTwoElectronIntegrals(const std::string& filename) const {
+
+    libwint::MappedERITensor::save(filename, this->get_g_SO_view());
+}
+
+
+/**
+ *  Replace the two-electron integrals by a shared, read-only mapping of the tensor file @param: filename (see MappedERITensor)
+ *
+ *  All the processes that map the same file share one copy of the integrals in the page cache. A transformation of the integrals copies them onto the heap first
+ */
+void SOBasis::mapTwoElectronIntegrals(const std::string& filename) {
+
+    auto g_SO_mapped = std::make_shared<const libwint::MappedERITensor>(filename);
+    if (g_SO_mapped->get_K() != this->K) {
+        throw std::invalid_argument("The dimension of the given tensor file is inconsistent with the number of spatial orbitals.");
+    }
+
+    this->g_SO_mapped = g_SO_mapped;
+    this->g_SO = Eigen::Tensor<double, 4>();  // release the heap storage
+}
+
+
+/**
+ *  Write the core energy and the one- and two-electron integrals to the binary checkpoint file @param: filename (see IntegralCheckpoint)
+ *
+ *  Loading a checkpoint is much faster than parsing an FCIDUMP file, so a text file only has to be parsed once
+ */
+void SOBasis::saveCheckpoint(const std::string& filename) const {
+
+    libwint::IntegralCheckpoint::save(filename, this->core_energy, this->h_SO, this->packTwoElectronIntegrals());
+}
+
+
+/**
+ *  Set the core energy and the one- and two-electron integrals from the binary checkpoint file @param: filename (see IntegralCheckpoint), which is memory-mapped and verified against its checksum
+ */
+void SOBasis::loadCheckpoint(const std::string& filename) {
+
+    this->loadIntegrals(libwint::IntegralCheckpoint(filename));
+}
+
+
+/**
+ *  Write the integrals to the FCIDUMP file @param: fcidump_filename for a system of @param: number_of_electrons electrons (with MS2=0 and all the orbitals in the totally symmetric irrep)
+ *
+ *  Only the symmetry-unique two-electron integrals (pq|rs) (p >= q, r >= s, (pq) >= (rs)) and one-electron integrals h_pq (p >= q) whose absolute value is larger than @param: threshold are written, followed by the core energy. The file is streamed through an io::BufferedWriter, so an existing file is only replaced once the new one has been written completely
+ *  See saveCheckpoint() for a binary alternative
+ */
+void SOBasis::writeFCIDUMPFile(const std::string& fcidump_filename, size_t number_of_electrons, double threshold) const {
+
+    libwint::io::BufferedWriter writer (fcidump_filename);
+
+    // Write the header
+    writer.write(" &FCI NORB=" + std::to_string(this->K) + ",NELEC=" + std::to_string(number_of_electrons) + ",MS2=0,\n");
+    writer.write("  ORBSYM=");
+    for (size_t p = 0; p < this->K; p++) {
+        writer.write("1,");
+    }
+    writer.write("\n  ISYM=1\n &END\n");
+
+
+    // Write the integrals as "value p q r s", with 1-based orbital indices and 0 for the absent indices
+    auto write_line = [&writer] (double value, size_t i, size_t a, size_t j, size_t b) {
+        writer.writeDouble(value, 24);
+        writer.writeIndex(i, 5);
+        writer.writeIndex(a, 5);
+        writer.writeIndex(j, 5);
+        writer.writeIndex(b, 5);
+        writer.write("\n", 1);
+    };
+
+    //  The two-electron integrals are read from a view, so that mapped integrals aren't copied
+    auto g_SO = this->get_g_SO_view();
+    const auto dim = static_cast<long>(this->K);
+    for (long p = 0; p < dim; p++) {
+        for (long q = 0; q <= p; q++) {
+            for (long r = 0; r <= p; r++) {
+                const long s_max = (r == p) ? q : r;
+                for (long s = 0; s <= s_max; s++) {
+                    double value = g_SO(p, q, r, s);
+                    if (std::abs(value) > threshold) {
+                        write_line(value, p + 1, q + 1, r + 1, s + 1);
+                    }
+                }
+            }
+        }
+    }
+
+    //  The one-electron integrals are the ones the basis presents (e.g. including a Mulliken constraint)
+    Eigen::MatrixXd h_SO = this->get_h_SO();
+    for (size_t p = 0; p < this->K; p++) {
+        for (size_t q = 0; q <= p; q++) {
+            if (std::abs(h_SO(p, q)) > threshold) {
+                write_line(h_SO(p, q), p + 1, q + 1, 0, 0);
+            }
+        }
+    }
+
+    write_line(this->core_energy, 0, 0, 0, 0);
+
+    writer.close();
+}
+
+
 /**
  *  Transform the one- and two-electron integrals according to the basis transformation matrix @param T
  */
 void SOBasis::transform(const Eigen::MatrixXd& T) {
 
+    this->materializeTwoElectronIntegrals();
     this->h_SO = libwint::transformations::transformOneElectronIntegrals(this->h_SO, T);
     this->g_SO = libwint::transformations::transformTwoElectronIntegrals(this->g_SO, T);
 }
@@ -176,87 +475,218 @@ void SOBasis::transform(const Eigen::MatrixXd& T) {
  */
 void SOBasis::rotateJacobi(size_t p, size_t q, double theta) {
 
-    // We can use our specialized rotate{One,Two}ElectronIntegralsJacobi functions
-    this->h_SO = libwint::transformations::rotateOneElectronIntegralsJacobi(this->h_SO, p, q, theta);
-    this->g_SO = libwint::transformations::rotateTwoElectronIntegralsJacobi(this->g_SO, p, q, theta);
+    this->materializeTwoElectronIntegrals();
+
+    // We can use our specialized rotate{One,Two}ElectronIntegralsJacobiInPlace functions, which only update the elements that change
+    libwint::transformations::rotateOneElectronIntegralsJacobiInPlace(this->h_SO, p, q, theta);
+    libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(this->g_SO, p, q, theta);
 }
 
+
 /**
- *  Parse a given One file for the one- and two-electron integrals and overlap.
+ *  Transform the one- and two-electron integrals according to the given sequence of Jacobi @param: rotations, which are applied in order
+ *
+ *  The two-electron integrals are updated in one blocked pass per index for the whole sequence (see transformations::rotateTwoElectronIntegralsJacobiInPlace). For long sequences, the rotations are accumulated into one transformation matrix instead
  */
-void SOBasis::parseTwo(std::string fcidump_filename) {
-    std::ifstream input_file_stream (fcidump_filename + ".two");
-    if (!input_file_stream.good()) {
-        throw std::runtime_error("The provided BLANKKKKKK file is illegible. Maybe you specified a wrong path?");
+void SOBasis::rotateJacobi(const std::vector<libwint::transformations::JacobiRotationParameters>& rotations) {
+
+    // Applying n rotations costs about 8 n K^3 flops, and a four-index transformation (with efficient matrix products) about 8 K^5 flops
+    if (8 * rotations.size() > this->K * this->K) {
+        this->transform(libwint::transformations::jacobiRotationMatrix(rotations, this->K));
+        return;
     }
-    //  Start reading in the one- and two-electron integrals
-    std::string dtoe;
-    size_t i, j, a, b;
-    double x;
+
+    this->materializeTwoElectronIntegrals();
+    libwint::transformations::rotateOneElectronIntegralsJacobiInPlace(this->h_SO, rotations);
+    libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(this->g_SO, rotations);
+}
+
+/**
+ *  @return the tensor hypercontraction (pq|rs) ~ sum_PQ X_pP X_qP Z_PQ X_rQ X_sQ of the two-electron integrals, fitted from their Cholesky decomposition with @param: threshold, and with at most @param: max_number_of_points points (0 meaning no limit)
+ *
+ *  See THCERITensor for the details of the fit; THCERITensor::validate(this->get_g_SO()) reports its error
+ */
+libwint::THCERITensor SOBasis::calculateTHCFactorization(double threshold, size_t max_number_of_points) const {
+
+    libwint::LowRankERITensor g_cholesky = this->g_SO_mapped ? libwint::LowRankERITensor(Eigen::Tensor<double, 4>(this->get_g_SO_view()), threshold) : libwint::LowRankERITensor(this->g_SO, threshold);
+    return libwint::THCERITensor(g_cholesky, threshold, max_number_of_points);
+}
+
+
+/**
+ *  Parse the (full) two-electron integrals from the file fcidump_filename.two, whose lines are "p q r s (pq|rs)", on @param: number_of_threads threads (0 meaning libwint's default)
+ */
+void SOBasis::parseTwo(std::string fcidump_filename, size_t number_of_threads) {
+
     Eigen::Tensor<double, 4> g_SO (this->K, this->K, this->K, this->K);
     g_SO.setZero();
-    std::string line;
-    while (std::getline(input_file_stream, line)) {
-        std::istringstream iss(line);
-
-        // Based on what the values of the indices are, we can read one-electron integrals, two-electron integrals and the internuclear repulsion energy
-        //  See also (http://hande.readthedocs.io/en/latest/manual/integrals.html)
-        //  I think the documentation is a bit unclear for the two-electron integrals, but we can rest assured that FCIDUMP files give the two-electron integrals in CHEMIST's notation.
-        iss >> i >> a >> j >> b >> dtoe;
-        //std::cout << dtoe;
-        auto e(dtoe.find_first_of("Dd"));
-        if (e != std::string::npos) {
-            dtoe[e] = 'E';
-        }
-        x = std::stod(dtoe);
+
+    this->parseIntegralFile(fcidump_filename + ".two", 4, [&g_SO] (const size_t* indices, double x) {
         //  Two-electron integrals are given in CHEMIST'S NOTATION, so just copy them over
-        if ((i > 0) && (a > 0) && (j > 0) && (b > 0)) {
-            size_t p = i - 1;
-            size_t q = a - 1;
-            size_t r = j - 1;
-            size_t s = b - 1;
-            g_SO(p,q,r,s) = x;
+        g_SO(indices[0] - 1, indices[1] - 1, indices[2] - 1, indices[3] - 1) = x;
+    }, number_of_threads);
 
-        }
-    }  // while loop
     this->g_SO = g_SO;
+    this->g_SO_mapped.reset();
 }
 
-void SOBasis::parseOne(std::string fcidump_filename) {
 
+/**
+ *  Parse the (full) one-electron integrals from the file fcidump_filename.one, whose lines are "p q h_pq", on @param: number_of_threads threads (0 meaning libwint's default)
+ */
+void SOBasis::parseOne(std::string fcidump_filename, size_t number_of_threads) {
 
-    std::ifstream input_file_stream (fcidump_filename + ".one");
-    if (!input_file_stream.good()) {
-        throw std::runtime_error("The provided BLANKKKKKK file is illegible. Maybe you specified a wrong path?");
-    }
-    //  Start reading in the one- and two-electron integrals
-    std::string dtoe;
-    size_t i, j;
-    double x;
     Eigen::MatrixXd h_SO = Eigen::MatrixXd::Zero(this->K, this->K);
-    std::string line;
-    while (std::getline(input_file_stream, line)) {
-        std::istringstream iss(line);
-
-        // Based on what the values of the indices are, we can read one-electron integrals, two-electron integrals and the internuclear repulsion energy
-        //  See also (http://hande.readthedocs.io/en/latest/manual/integrals.html)
-        //  I think the documentation is a bit unclear for the two-electron integrals, but we can rest assured that FCIDUMP files give the two-electron integrals in CHEMIST's notation.
-        iss >> i >> j >> dtoe;
-        auto e(dtoe.find_first_of("Dd"));
-        if (e != std::string::npos) {
-            dtoe[e] = 'E';
-        }
-        x = std::stod(dtoe);
-        //  Two-electron integrals are given in CHEMIST'S NOTATION, so just copy them over
-        if ((i > 0) && (j > 0)) {
-            size_t p = i - 1;
-            size_t r = j - 1;
-            h_SO(p,r) = x;
 
-        }
-    }  // while loop
+    this->parseIntegralFile(fcidump_filename + ".one", 2, [&h_SO] (const size_t* indices, double x) {
+        h_SO(indices[0] - 1, indices[1] - 1) = x;
+    }, number_of_threads);
+
     this->h_SO = h_SO;
 }
 
 
+/**
+ *  Parse an integral file @param: filename, in which every line holds @param: number_of_indices (1-based) orbital indices followed by the value of an integral, and call @param: set_integral(indices, value) for every integral whose indices are all non-zero
+ *
+ *  The file can be compressed (gzip or zstd, see io::DecompressingReader), and filename.gz or filename.zst is read if filename doesn't exist
+ *  The file is split into chunks of whole lines (a compressed file is decompressed on a separate thread, while the previous chunks are being parsed), which are tokenized by an io::Scanner on @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads). Every thread parses its chunks into a thread-local buffer, which is applied in the order of the chunks, so that the result is identical to a serial parse.
+ *  The parsing throughput is added to the parse statistics
+ */
+void SOBasis::parseIntegralFile(const std::string& filename, size_t number_of_indices, const std::function<void(const size_t*, double)>& set_integral, size_t number_of_threads) {
+
+    const std::string resolved_filename = libwint::io::resolveFilename(filename);
+    std::ifstream file (resolved_filename, std::ifstream::binary | std::ifstream::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("The provided integral file " + filename + " is illegible. Maybe you specified a wrong path?");
+    }
+    const size_t file_size = static_cast<size_t>(file.tellg());
+    file.close();
+
+
+    // Use a few chunks per thread (to balance the load), but keep them small enough to bound the memory of the buffers
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+    const size_t chunk_size = std::min<size_t>(std::max<size_t>(file_size / (8 * number_of_threads), 1 << 16), 1 << 22);
+    number_of_threads = std::min(number_of_threads, file_size / chunk_size + 1);
+
+    auto start_time = std::chrono::steady_clock::now();
+    libwint::io::LineChunkReader reader (resolved_filename, chunk_size);
+
+
+    // The chunks are handed out in order. A thread applies its parsed chunk as soon as all the previous chunks have been applied
+    size_t next_chunk = 0;
+    std::mutex supply_mutex;
+    std::exception_ptr supply_exception;  // e.g. a corrupt compressed file
+    size_t next_chunk_to_apply = 0;
+    size_t number_of_lines = 0;  // the number of lines in the chunks that have been applied
+    std::string error_message;  // the first error, in the order of the chunks
+    std::exception_ptr parse_exception;  // e.g. std::bad_alloc while buffering a chunk, also stored in the order of the chunks
+    std::atomic<bool> has_error (false);
+    std::mutex apply_mutex;
+    std::condition_variable apply_condition;
+
+    libwint::threading::parallelFor(number_of_threads, [&] (size_t) {
+        std::vector<char> storage;
+        std::vector<size_t> indices_buffer;
+        std::vector<double> values_buffer;
+
+        while (!has_error) {
+            //  Take the next chunk
+            const char* begin;
+            const char* end;
+            size_t chunk;
+            {
+                std::lock_guard<std::mutex> lock (supply_mutex);
+                try {
+                    if (supply_exception || !reader.read(begin, end, storage)) {
+                        break;
+                    }
+                } catch (...) {
+                    supply_exception = std::current_exception();
+                    break;
+                }
+                chunk = next_chunk++;
+            }
+
+            indices_buffer.clear();
+            values_buffer.clear();
+
+            //  Parse the chunk into the buffers. A failure must not keep this chunk from taking its turn below, or the threads waiting for the next chunks would wait forever
+            libwint::io::Scanner scanner (begin, end);
+            bool is_legible = true;
+            std::exception_ptr chunk_exception;
+            try {
+                size_t indices[4];
+                double x;
+                while (!scanner.atEnd()) {
+                    scanner.skipBlanks();
+                    if (scanner.atEndOfLine()) {  // skip empty lines
+                        scanner.skipLine();
+                        continue;
+                    }
+
+                    bool has_zero_index = false;
+                    for (size_t index = 0; index < number_of_indices; index++) {
+                        is_legible = is_legible && scanner.readIndex(indices[index]) && (indices[index] <= this->K);
+                        has_zero_index = has_zero_index || (indices[index] == 0);
+                    }
+                    if (!(is_legible && scanner.readDouble(x))) {
+                        is_legible = false;
+                        break;
+                    }
+                    scanner.skipLine();
+
+                    if (!has_zero_index) {
+                        indices_buffer.insert(indices_buffer.end(), indices, indices + number_of_indices);
+                        values_buffer.push_back(x);
+                    }
+                }
+            } catch (...) {
+                chunk_exception = std::current_exception();
+            }
+
+
+            //  Wait for the previous chunks, and apply this one
+            std::unique_lock<std::mutex> lock (apply_mutex);
+            apply_condition.wait(lock, [&next_chunk_to_apply, chunk] () { return next_chunk_to_apply == chunk; });
+
+            if (error_message.empty() && !parse_exception) {
+                if (chunk_exception) {
+                    parse_exception = chunk_exception;
+                    has_error = true;
+                } else if (is_legible) {
+                    for (size_t i = 0; i < values_buffer.size(); i++) {
+                        set_integral(indices_buffer.data() + i * number_of_indices, values_buffer[i]);
+                    }
+                    number_of_lines += scanner.get_line_number() - 1;
+                } else {
+                    error_message = "Line " + std::to_string(number_of_lines + scanner.get_line_number()) + " of the provided integral file " + resolved_filename + " is illegible.";
+                    has_error = true;
+                }
+            }
+
+            next_chunk_to_apply++;
+            apply_condition.notify_all();
+        }
+    });
+
+    if (!error_message.empty()) {
+        throw std::runtime_error(error_message);
+    }
+    if (parse_exception) {
+        std::rethrow_exception(parse_exception);
+    }
+    if (supply_exception) {
+        std::rethrow_exception(supply_exception);
+    }
+
+
+    libwint::io::ParseStatistics statistics;
+    statistics.number_of_bytes = reader.get_number_of_bytes();
+    statistics.number_of_lines = number_of_lines;
+    statistics.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    this->parse_statistics += statistics;
+}
+
+
 }  // namespace libwint
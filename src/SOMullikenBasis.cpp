@@ -59,7 +59,35 @@ double SOMullikenBasis::mullikenPopulationCI(Eigen::MatrixXd &rdm_aa, Eigen::Mat
 
 void SOMullikenBasis::rotateJacobi(size_t p, size_t q, double theta) {
     SOBasis::rotateJacobi(p, q, theta);
-    this->mulliken_matrix = libwint::transformations::rotateOneElectronIntegralsJacobi(this->mulliken_matrix, p, q, theta);
+    libwint::transformations::rotateOneElectronIntegralsJacobiInPlace(this->mulliken_matrix, p, q, theta);
+}
+
+void SOMullikenBasis::rotateJacobi(const std::vector<libwint::transformations::JacobiRotationParameters>& rotations) {
+    SOBasis::rotateJacobi(rotations);
+    libwint::transformations::rotateOneElectronIntegralsJacobiInPlace(this->mulliken_matrix, rotations);
+}
+
+/**
+ *  Write the integrals, together with the Lagrange multiplier, C, S and the Mulliken matrix, to the binary checkpoint file @param: filename (see IntegralCheckpoint)
+ */
+void SOMullikenBasis::saveCheckpoint(const std::string& filename) const {
+    libwint::IntegralCheckpoint::save(filename, this->core_energy, this->h_SO, this->packTwoElectronIntegrals(), {this->lagrange_multiplier}, {this->C, this->S, this->mulliken_matrix});
+}
+
+/**
+ *  Set the integrals, the Lagrange multiplier, C, S and the Mulliken matrix from the binary checkpoint file @param: filename that was written by an SOMullikenBasis
+ */
+void SOMullikenBasis::loadCheckpoint(const std::string& filename) {
+    libwint::IntegralCheckpoint checkpoint (filename);
+    if ((checkpoint.get_scalars().size() != 1) || (checkpoint.get_matrices().size() != 3)) {
+        throw std::runtime_error("The provided checkpoint file wasn't written by an SOMullikenBasis.");
+    }
+
+    this->loadIntegrals(checkpoint);
+    this->lagrange_multiplier = checkpoint.get_scalars()[0];
+    this->C = checkpoint.get_matrices()[0];
+    this->S = checkpoint.get_matrices()[1];
+    this->mulliken_matrix = checkpoint.get_matrices()[2];
 }
 
 SOMullikenBasis::SOMullikenBasis(std::string fcidump_filename, size_t K) : SOBasis(K) {
@@ -72,10 +100,11 @@ SOMullikenBasis::SOMullikenBasis(std::string fcidump_filename, size_t K) : SOBas
 }
 
 void SOMullikenBasis::parseOve(std::string fcidump_filename) {
-    std::ifstream input_file_stream (fcidump_filename + ".ove");
-    if (!input_file_stream.good()) {
+    const std::string filename = libwint::io::resolveFilename(fcidump_filename + ".ove");  // the file can be compressed
+    if (!std::ifstream(filename).good()) {
         throw std::runtime_error("The provided BLANKKKKKK file is illegible. Maybe you specified a wrong path?");
     }
+    std::istringstream input_file_stream (libwint::io::readFile(filename));
     //  Start reading in the one- and two-electron integrals
 
     double x;
@@ -97,10 +126,11 @@ void SOMullikenBasis::parseOve(std::string fcidump_filename) {
 }
 
 void SOMullikenBasis::parseC(std::string fcidump_filename) {
-    std::ifstream input_file_stream (fcidump_filename + ".mo");
-    if (!input_file_stream.good()) {
+    const std::string filename = libwint::io::resolveFilename(fcidump_filename + ".mo");  // the file can be compressed
+    if (!std::ifstream(filename).good()) {
         throw std::runtime_error("The provided BLANKKKKKK file is illegible. Maybe you specified a wrong path?");
     }
+    std::istringstream input_file_stream (libwint::io::readFile(filename));
     //  Start reading in the one- and two-electron integrals
 
     double x;
@@ -0,0 +1,238 @@
+#include "THCERITensor.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+
+
+namespace libwint {
+
+
+/*
+ *  PRIVATE METHODS
+ */
+
+/**
+ *  @return the (N_P x n_p n_q)-matrix of the point products X_pP X_qP for the orbital pairs in the block starting at @param: p and @param: q, with dimensions @param: n_p and @param: n_q, in which the pairs are ordered like the (column-major) indices of the block
+ */
+Eigen::MatrixXd THCERITensor::calculatePairProducts(size_t p, size_t q, size_t n_p, size_t n_q) const {
+
+    Eigen::MatrixXd pair_products (this->X.cols(), static_cast<long>(n_p * n_q));
+    for (size_t j = 0; j < n_q; j++) {
+        for (size_t i = 0; i < n_p; i++) {
+            pair_products.col(i + n_p * j) = this->X.row(p + i).cwiseProduct(this->X.row(q + j)).transpose();
+        }
+    }
+
+    return pair_products;
+}
+
+
+
+/*
+ *  CONSTRUCTORS
+ */
+
+/**
+ *  Default constructor for an empty (K = 0, N_P = 0) tensor
+ */
+THCERITensor::THCERITensor() :
+    K (0)
+{}
+
+
+/**
+ *  Constructor from the (K x N_P) collocation matrix @param: X and the (N_P x N_P) core matrix @param: Z
+ */
+THCERITensor::THCERITensor(const Eigen::MatrixXd& X, const Eigen::MatrixXd& Z) :
+    K (static_cast<size_t>(X.rows())),
+    X (X),
+    Z (Z)
+{
+    if ((Z.rows() != X.cols()) || (Z.cols() != X.cols())) {
+        throw std::invalid_argument("The dimensions of the core matrix should be the number of columns of the collocation matrix.");
+    }
+}
+
+
+/**
+ *  Constructor from the low-rank (density-fitted or Cholesky-decomposed) two-electron integrals @param: g, through a least-squares THC fit
+ *
+ *  The candidate points are the eigenvectors u of the factors L^J = sum_u lambda_u u u^T. From the candidates with |lambda_u| >= @param: threshold, the points are chosen by a pivoted Cholesky decomposition of their weighted overlaps |lambda_u| |lambda_v| (u^T v)^2, until the largest remaining diagonal element is smaller than @param: threshold^2, or until @param: max_number_of_points points are chosen (0 meaning no limit)
+ *  The core matrix is then the least-squares solution Z = S^(-1) E S^(-1), with S_PQ = (X^T X)_PQ^2 and E_PQ = sum_pqrs X_pP X_qP (pq|rs) X_rQ X_sQ
+ */
+THCERITensor::THCERITensor(const libwint::LowRankERITensor& g, double threshold, size_t max_number_of_points) :
+    K (g.get_K())
+{
+    if (threshold <= 0.0) {
+        throw std::invalid_argument("The threshold for the THC factorization should be positive.");
+    }
+
+    const auto K = static_cast<long>(this->K);
+    const auto& L = g.get_L();
+
+
+    // Every factor L^J is a symmetric matrix, so it is a sum of the products u u^T of its eigenvectors: these are our candidate points
+    std::vector<Eigen::VectorXd> candidates;
+    std::vector<double> weights;
+    for (long J = 0; J < L.rows(); J++) {
+        Eigen::RowVectorXd L_J_row = L.row(J);
+        Eigen::Map<const Eigen::MatrixXd> L_J (L_J_row.data(), K, K);  // L^J_pq is found at (p, q)
+
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigensolver ((L_J + L_J.transpose()) / 2);
+        for (long u = 0; u < K; u++) {
+            const double weight = std::abs(eigensolver.eigenvalues()(u));
+            if (weight >= threshold) {
+                candidates.push_back(eigensolver.eigenvectors().col(u));
+                weights.push_back(weight);
+            }
+        }
+    }
+    const auto number_of_candidates = candidates.size();
+
+
+    // Choose the points among the candidates by a pivoted Cholesky decomposition of their weighted overlaps G_uv = |lambda_u| |lambda_v| (u^T v)^2, whose columns are only calculated for the pivots
+    Eigen::VectorXd diagonal (number_of_candidates);  // G_uu = lambda_u^2, since the eigenvectors are normalized
+    for (size_t u = 0; u < number_of_candidates; u++) {
+        diagonal(u) = weights[u] * weights[u];
+    }
+
+    std::vector<size_t> points;
+    std::vector<Eigen::VectorXd> cholesky_vectors;
+    while ((points.size() < number_of_candidates) && ((max_number_of_points == 0) || (points.size() < max_number_of_points))) {
+        long pivot;
+        const double max_diagonal = diagonal.maxCoeff(&pivot);
+        if (max_diagonal < threshold * threshold) {
+            break;
+        }
+
+        Eigen::VectorXd column (number_of_candidates);
+        for (size_t v = 0; v < number_of_candidates; v++) {
+            const double overlap = candidates[pivot].dot(candidates[v]);
+            column(v) = weights[pivot] * weights[v] * overlap * overlap;
+        }
+        for (const auto& cholesky_vector : cholesky_vectors) {
+            column -= cholesky_vector(pivot) * cholesky_vector;
+        }
+        column /= std::sqrt(max_diagonal);
+
+        diagonal -= column.cwiseAbs2();
+        diagonal(pivot) = 0.0;  // the pivot has been treated exactly, so guard against round-off
+
+        cholesky_vectors.push_back(column);
+        points.push_back(static_cast<size_t>(pivot));
+    }
+
+    const auto number_of_points = static_cast<long>(points.size());
+    this->X = Eigen::MatrixXd (K, number_of_points);
+    for (long P = 0; P < number_of_points; P++) {
+        this->X.col(P) = candidates[points[P]];
+    }
+
+
+    // Fit the core matrix in a least-squares sense: Z = S^(-1) E S^(-1)
+    //  S_PQ = sum_pq X_pP X_qP X_pQ X_qQ = (X^T X)_PQ^2
+    Eigen::MatrixXd XTX = this->X.transpose() * this->X;
+    Eigen::MatrixXd S = XTX.cwiseProduct(XTX);
+
+    //  E_PQ = sum_J (L^J X_P X_P) (L^J X_Q X_Q), in which the (K^2 x N_P)-matrix of the point products is only built once
+    Eigen::MatrixXd LX = L * this->calculatePairProducts(0, 0, this->K, this->K).transpose();  // (rank x N_P)
+    Eigen::MatrixXd E = LX.transpose() * LX;
+
+    //  S can be (nearly) singular, so we use its pseudo-inverse through its eigenvalue decomposition
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigensolver (S);
+    const Eigen::VectorXd& eigenvalues = eigensolver.eigenvalues();
+    const double singularity_threshold = 1.0e-12 * ((eigenvalues.size() > 0) ? eigenvalues.cwiseAbs().maxCoeff() : 0.0);
+
+    Eigen::VectorXd inverse_eigenvalues = Eigen::VectorXd::Zero(number_of_points);
+    for (long P = 0; P < number_of_points; P++) {
+        if (eigenvalues(P) > singularity_threshold) {
+            inverse_eigenvalues(P) = 1.0 / eigenvalues(P);
+        }
+    }
+    Eigen::MatrixXd S_inverse = eigensolver.eigenvectors() * inverse_eigenvalues.asDiagonal() * eigensolver.eigenvectors().transpose();
+
+    this->Z = S_inverse * E * S_inverse;
+}
+
+
+
+/*
+ *  OPERATORS
+ */
+
+/**
+ *  @return the reconstructed element (pq|rs)
+ */
+double THCERITensor::operator()(size_t p, size_t q, size_t r, size_t s) const {
+
+    Eigen::VectorXd pq = this->X.row(p).cwiseProduct(this->X.row(q)).transpose();
+    Eigen::VectorXd rs = this->X.row(r).cwiseProduct(this->X.row(s)).transpose();
+
+    return pq.dot(this->Z * rs);
+}
+
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  @return the reconstructed block (p q|r s) of the two-electron integrals, with dimensions (@param: n_p, @param: n_q, @param: n_r, @param: n_s), starting at the indices @param: p, @param: q, @param: r and @param: s
+ */
+Eigen::Tensor<double, 4> THCERITensor::reconstructBlock(size_t p, size_t q, size_t r, size_t s, size_t n_p, size_t n_q, size_t n_r, size_t n_s) const {
+
+    if ((p + n_p > this->K) || (q + n_q > this->K) || (r + n_r > this->K) || (s + n_s > this->K)) {
+        throw std::invalid_argument("The requested block is out of range.");
+    }
+
+    Eigen::MatrixXd bra_products = this->calculatePairProducts(p, q, n_p, n_q);
+    Eigen::MatrixXd ket_products = this->calculatePairProducts(r, s, n_r, n_s);
+
+    // The block, as a (n_p n_q x n_r n_s)-matrix, has the same (column-major) memory layout as the rank-four tensor
+    Eigen::Tensor<double, 4> block (static_cast<long>(n_p), static_cast<long>(n_q), static_cast<long>(n_r), static_cast<long>(n_s));
+    Eigen::Map<Eigen::MatrixXd> block_matrix (block.data(), static_cast<long>(n_p * n_q), static_cast<long>(n_r * n_s));
+    block_matrix.noalias() = bra_products.transpose() * (this->Z * ket_products);
+
+    return block;
+}
+
+
+/**
+ *  @return the reconstructed dense rank-four tensor of the two-electron integrals
+ */
+Eigen::Tensor<double, 4> THCERITensor::toDense() const {
+    return this->reconstructBlock(0, 0, 0, 0, this->K, this->K, this->K, this->K);
+}
+
+
+/**
+ *  @return the maximum and root-mean-square error of the reconstructed two-electron integrals with respect to the dense two-electron integrals @param: g
+ */
+THCERITensor::ValidationReport THCERITensor::validate(const Eigen::Tensor<double, 4>& g) const {
+
+    const auto K = static_cast<long>(this->K);
+    if ((g.dimension(0) != K) || (g.dimension(1) != K) || (g.dimension(2) != K) || (g.dimension(3) != K)) {
+        throw std::invalid_argument("The dimensions of the given tensor are not compatible with the THC factorization.");
+    }
+
+    ValidationReport report;
+    report.number_of_points = this->get_number_of_points();
+    if (K == 0) {
+        return report;
+    }
+
+    Eigen::Tensor<double, 4> difference = this->toDense() - g;
+    Eigen::Tensor<double, 0> max_error = difference.abs().maximum();
+    Eigen::Tensor<double, 0> sum_of_squares = difference.square().sum();
+
+    report.max_error = max_error(0);
+    report.rms_error = std::sqrt(sum_of_squares(0) / static_cast<double>(difference.size()));
+
+    return report;
+}
+
+
+}  // namespace libwint
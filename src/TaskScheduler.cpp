@@ -0,0 +1,113 @@
+#include "TaskScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <numeric>
+
+#include "threading.hpp"
+
+
+
+namespace libwint {
+
+
+/*
+ *  PUBLIC METHODS
+ */
+
+/**
+ *  Add a @param: task (that will be called with the id of the thread that runs it) with an estimated @param: cost
+ */
+void TaskScheduler::addTask(double cost, const std::function<void(size_t)>& task) {
+    this->tasks.push_back(Task {cost, task});
+}
+
+
+/**
+ *  Run all the added tasks on @param: number_of_threads threads (0 meaning libwint's default, see threading::numberOfThreads), wait for them to finish and update the thread statistics
+ *
+ *  The scheduler is empty afterwards. If any of the tasks throws, the first exception is rethrown after all the threads have finished.
+ */
+void TaskScheduler::run(size_t number_of_threads) {
+
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+    this->statistics = std::vector<ThreadStatistics>(number_of_threads);
+
+    // Take over the tasks, so that the scheduler is empty afterwards (even if a task throws)
+    std::vector<Task> tasks;
+    tasks.swap(this->tasks);
+
+
+    // Deal out the tasks, most expensive first, each time to the queue with the smallest total cost (the longest-processing-time rule)
+    std::vector<size_t> order (tasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&tasks] (size_t i, size_t j) { return tasks[i].cost > tasks[j].cost; });
+
+    std::vector<std::deque<size_t>> queues (number_of_threads);
+    std::vector<double> queue_costs (number_of_threads, 0.0);
+    for (const auto& task_index : order) {
+        auto cheapest_queue = static_cast<size_t>(std::min_element(queue_costs.begin(), queue_costs.end()) - queue_costs.begin());
+        queues[cheapest_queue].push_back(task_index);
+        queue_costs[cheapest_queue] += tasks[task_index].cost;
+    }
+    std::vector<std::mutex> queue_mutexes (number_of_threads);
+
+
+    // Every thread works through its own queue and steals from the others when it runs dry
+    //  Since no tasks are added while running, a thread can stop as soon as all queues are empty
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&] (size_t thread_id) {
+
+        auto& thread_statistics = this->statistics[thread_id];
+
+        while (true) {
+            size_t task_index = 0;
+            bool found_task = false;
+
+            // Try our own queue first, taking the most expensive task
+            {
+                std::lock_guard<std::mutex> lock (queue_mutexes[thread_id]);
+                if (!queues[thread_id].empty()) {
+                    task_index = queues[thread_id].front();
+                    queues[thread_id].pop_front();
+                    found_task = true;
+                }
+            }
+
+            // Else, steal the cheapest task of one of the other queues
+            for (size_t offset = 1; !found_task && (offset < number_of_threads); offset++) {
+                auto victim = (thread_id + offset) % number_of_threads;
+
+                std::lock_guard<std::mutex> lock (queue_mutexes[victim]);
+                if (!queues[victim].empty()) {
+                    task_index = queues[victim].back();
+                    queues[victim].pop_back();
+                    found_task = true;
+                    thread_statistics.number_of_stolen_tasks++;
+                }
+            }
+
+            if (!found_task) {
+                break;
+            }
+
+            auto task_start = std::chrono::steady_clock::now();
+            tasks[task_index].function(thread_id);
+            thread_statistics.busy_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - task_start).count();
+            thread_statistics.number_of_tasks++;
+        }
+    };
+    libwint::threading::parallelFor(number_of_threads, worker);
+
+
+    // Everything that wasn't spent running tasks, was spent idling
+    double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (auto& thread_statistics : this->statistics) {
+        thread_statistics.idle_time = std::max(wall_time - thread_statistics.busy_time, 0.0);
+    }
+}
+
+
+}  // namespace libwint
@@ -0,0 +1,868 @@
+#include "io.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef LIBWINT_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef LIBWINT_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+
+
+namespace libwint {
+namespace io {
+
+
+namespace {
+
+// The powers of ten that are exactly representable as a double (or as a long double with a 64-bit mantissa)
+const double exact_powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+const long double exact_long_powers_of_ten[] = {1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L};
+
+
+bool isDigit(char c) { return (c >= '0') && (c <= '9'); }
+
+
+/**
+ *  Parse the number [begin, end) with std::strtod, after replacing a D exponent by an E exponent
+ */
+double parseDoubleSlowly(const char* begin, const char* end) {
+
+    std::string token (begin, end);
+    auto e = token.find_first_of("Dd");
+    if (e != std::string::npos) {
+        token[e] = 'E';
+    }
+
+    return std::strtod(token.c_str(), nullptr);
+}
+
+}  // anonymous namespace
+
+
+
+/*
+ *  STRUCTS
+ */
+
+ParseStatistics& ParseStatistics::operator+=(const ParseStatistics& other) {
+
+    this->number_of_bytes += other.number_of_bytes;
+    this->number_of_lines += other.number_of_lines;
+    this->elapsed_seconds += other.elapsed_seconds;
+    return *this;
+}
+
+
+
+/*
+ *  FUNCTIONS
+ */
+
+/**
+ *  Parse the floating point number at @param: begin, which can't extend beyond @param: end, into @param: value
+ *
+ *  Both E and D (Fortran double precision) exponents are accepted, in upper or lower case. The result is correctly rounded, like std::strtod.
+ *
+ *  @return a pointer to the first character after the number, or nullptr if there isn't a number at @param: begin
+ */
+const char* parseDouble(const char* begin, const char* end, double& value) {
+
+    const char* p = begin;
+
+    bool is_negative = false;
+    if ((p != end) && ((*p == '-') || (*p == '+'))) {
+        is_negative = (*p == '-');
+        p++;
+    }
+
+
+    // Read at most 19 significant digits (which always fit in a uint64_t) into the mantissa, so that the number is mantissa * 10^exponent
+    uint64_t mantissa = 0;
+    int number_of_significant_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    bool is_truncated = false;  // if significant digits had to be dropped
+
+    auto read_digit = [&] (char c, bool is_fractional) {
+        has_digits = true;
+        if (number_of_significant_digits < 19) {
+            mantissa = 10 * mantissa + static_cast<uint64_t>(c - '0');
+            if (mantissa != 0) {
+                number_of_significant_digits++;
+            }
+            if (is_fractional) {
+                exponent--;
+            }
+        } else {
+            if (!is_fractional) {
+                exponent++;
+            }
+            is_truncated |= (c != '0');
+        }
+    };
+
+    while ((p != end) && isDigit(*p)) {
+        read_digit(*p, false);
+        p++;
+    }
+    if ((p != end) && (*p == '.')) {
+        p++;
+        while ((p != end) && isDigit(*p)) {
+            read_digit(*p, true);
+            p++;
+        }
+    }
+    if (!has_digits) {
+        return nullptr;
+    }
+
+    if ((p != end) && ((*p == 'E') || (*p == 'e') || (*p == 'D') || (*p == 'd'))) {
+        p++;
+
+        bool is_negative_exponent = false;
+        if ((p != end) && ((*p == '-') || (*p == '+'))) {
+            is_negative_exponent = (*p == '-');
+            p++;
+        }
+        if ((p == end) || !isDigit(*p)) {
+            return nullptr;
+        }
+
+        int explicit_exponent = 0;
+        while ((p != end) && isDigit(*p)) {
+            if (explicit_exponent < 100000) {  // anything larger over- or underflows anyway
+                explicit_exponent = 10 * explicit_exponent + (*p - '0');
+            }
+            p++;
+        }
+        exponent += is_negative_exponent ? -explicit_exponent : explicit_exponent;
+    }
+
+
+    // Convert mantissa * 10^exponent to the nearest double
+    if (mantissa == 0) {
+        value = is_negative ? -0.0 : 0.0;
+        return p;
+    }
+
+    // If both the mantissa and the power of ten are exact doubles, a single (correctly rounded) operation gives the correctly rounded result (Clinger's fast path)
+    if (!is_truncated && (mantissa <= (uint64_t(1) << 53)) && (exponent >= -22) && (exponent <= 22)) {
+        double result = static_cast<double>(mantissa);
+        result = (exponent < 0) ? result / exact_powers_of_ten[-exponent] : result * exact_powers_of_ten[exponent];
+        value = is_negative ? -result : result;
+        return p;
+    }
+
+#if LDBL_MANT_DIG >= 64
+    // FCIDUMP files typically contain 17 significant digits, which don't fit in a double's mantissa, but do fit in a long double's. The long double result is off by at most half of its last bit, so rounding it to a double is correct, unless it lies (almost) halfway between two doubles
+    if (!is_truncated && (exponent >= -27) && (exponent <= 27)) {
+        long double result = static_cast<long double>(mantissa);
+        result = (exponent < 0) ? result / exact_long_powers_of_ten[-exponent] : result * exact_long_powers_of_ten[exponent];
+
+        int binary_exponent;
+        const auto bits = static_cast<uint64_t>(std::ldexp(std::frexp(result, &binary_exponent), 64));
+        const uint64_t rounding_bits = bits & 0x7ff;  // the 11 bits that are dropped when rounding to a double
+        if ((rounding_bits < 0x3ff) || (rounding_bits > 0x401)) {
+            value = static_cast<double>(is_negative ? -result : result);
+            return p;
+        }
+    }
+#endif
+
+    // In all the other (rare) cases, fall back to the standard library
+    value = parseDoubleSlowly(begin, p);
+    return p;
+}
+
+
+/**
+ *  Parse the unsigned integer at @param: begin, which can't extend beyond @param: end, into @param: value
+ *
+ *  @return a pointer to the first character after the integer, or nullptr if there isn't an integer at @param: begin or if it overflows a size_t
+ */
+const char* parseIndex(const char* begin, const char* end, size_t& value) {
+
+    const char* p = begin;
+    if ((p != end) && (*p == '+')) {
+        p++;
+    }
+    if ((p == end) || !isDigit(*p)) {
+        return nullptr;
+    }
+
+    size_t result = 0;
+    while ((p != end) && isDigit(*p)) {
+        const auto digit = static_cast<size_t>(*p - '0');
+        if (result > (SIZE_MAX - digit) / 10) {  // the integer doesn't fit, so it can't be a valid index
+            return nullptr;
+        }
+        result = 10 * result + digit;
+        p++;
+    }
+
+    value = result;
+    return p;
+}
+
+
+
+/**
+ *  Format @param: value in scientific notation with 17 significant digits (like printf's %.16e) into @param: buffer, which should hold at least 32 characters
+ *
+ *  The digits are calculated in extended precision rather than through printf. The (rare) values for which extended precision can't guarantee correctly rounded digits are formatted by printf, so the result is always the same as printf's, and parses back to exactly @param: value
+ *
+ *  @return the number of characters that were written
+ */
+size_t formatDouble(double value, char* buffer) {
+
+    if (!std::isfinite(value) || (value == 0.0)) {
+        return static_cast<size_t>(std::snprintf(buffer, 32, "%.16e", value));
+    }
+
+    char* p = buffer;
+    double magnitude = value;
+    if (value < 0.0) {
+        *p++ = '-';
+        magnitude = -value;
+    }
+
+
+    // Find the 17 significant digits as the integer nearest to magnitude * 10^(16 - exponent), for the decimal exponent of the magnitude
+    //  The estimate of the exponent from the binary exponent can be off by one, which is corrected below
+    int binary_exponent;
+    std::frexp(magnitude, &binary_exponent);
+    auto exponent = static_cast<int>(std::floor((binary_exponent - 1) * 0.30102999566398120));
+
+    uint64_t digits = 0;
+    bool is_exact_scale = true;  // if the scaling only multiplies by exact powers of ten (at most twice), so that its error is bounded
+    long double fraction = 0.0L;
+    for (size_t attempt = 0; attempt < 3; attempt++) {
+        const int scale = 16 - exponent;
+        long double scaled = magnitude;
+        if ((scale >= 0) && (scale <= 27)) {
+            scaled *= exact_long_powers_of_ten[scale];
+        } else if ((scale > 27) && (scale <= 54)) {
+            scaled *= exact_long_powers_of_ten[27];
+            scaled *= exact_long_powers_of_ten[scale - 27];
+        } else if ((scale < 0) && (scale >= -27)) {
+            scaled /= exact_long_powers_of_ten[-scale];
+        } else if ((scale < -27) && (scale >= -54)) {
+            scaled /= exact_long_powers_of_ten[27];
+            scaled /= exact_long_powers_of_ten[-scale - 27];
+        } else {
+            scaled *= std::pow(10.0L, scale);
+            is_exact_scale = false;
+        }
+        digits = static_cast<uint64_t>(scaled + 0.5L);
+        fraction = scaled - static_cast<long double>(static_cast<uint64_t>(scaled));
+
+        if (digits >= 100000000000000000ULL) {
+            exponent++;
+        } else if (digits < 10000000000000000ULL) {
+            exponent--;
+        } else {
+            break;
+        }
+    }
+
+    // Every rounding in extended precision is off by at most 2^-8 for the scaled magnitude (< 2^57), so after at most two roundings the digits are correctly rounded (and hence parse back to the same double), unless the scaled magnitude is (almost) halfway between two integers
+#if LDBL_MANT_DIG >= 64
+    const bool is_correctly_rounded = is_exact_scale && (std::abs(fraction - 0.5L) > 1.0L / 64);
+#else
+    const bool is_correctly_rounded = false;
+#endif
+    if (!is_correctly_rounded) {
+        return static_cast<size_t>(std::snprintf(buffer, 32, "%.16e", value));
+    }
+
+
+    // Write d.dddddddddddddddde+XX
+    char digit_characters[17];
+    for (int i = 16; i >= 0; i--) {
+        digit_characters[i] = static_cast<char>('0' + digits % 10);
+        digits /= 10;
+    }
+    *p++ = digit_characters[0];
+    *p++ = '.';
+    std::memcpy(p, digit_characters + 1, 16);
+    p += 16;
+
+    *p++ = 'e';
+    *p++ = (exponent < 0) ? '-' : '+';
+    const int exponent_magnitude = (exponent < 0) ? -exponent : exponent;
+    if (exponent_magnitude >= 100) {
+        *p++ = static_cast<char>('0' + exponent_magnitude / 100);
+    }
+    *p++ = static_cast<char>('0' + (exponent_magnitude / 10) % 10);
+    *p++ = static_cast<char>('0' + exponent_magnitude % 10);
+
+    return static_cast<size_t>(p - buffer);
+}
+
+
+/**
+ *  Split the text [@param: begin, @param: end) into chunks of whole lines of about @param: chunk_size bytes
+ *
+ *  @return the boundaries of the chunks: chunk i is [boundaries[i], boundaries[i+1]), and every boundary except the first is just after a newline (or at the end)
+ */
+std::vector<const char*> splitAtNewlines(const char* begin, const char* end, size_t chunk_size) {
+
+    if (chunk_size == 0) {
+        throw std::invalid_argument("The chunk size should be positive.");
+    }
+
+    std::vector<const char*> boundaries {begin};
+    const char* position = begin;
+    while (static_cast<size_t>(end - position) > chunk_size) {
+        auto newline = static_cast<const char*>(std::memchr(position + chunk_size, '\n', static_cast<size_t>(end - position - chunk_size)));
+        if (newline == nullptr) {
+            break;
+        }
+
+        position = newline + 1;
+        boundaries.push_back(position);
+    }
+
+    if (boundaries.back() != end) {
+        boundaries.push_back(end);
+    }
+    return boundaries;
+}
+
+
+
+/*
+ *  SCANNER
+ */
+
+/**
+ *  Skip the rest of the current line, including its newline
+ */
+void Scanner::skipLine() {
+
+    if (this->atEnd()) {
+        return;
+    }
+
+    auto newline = static_cast<const char*>(std::memchr(this->position, '\n', static_cast<size_t>(this->end - this->position)));
+    if (newline == nullptr) {
+        this->position = this->end;
+    } else {
+        this->position = newline + 1;
+        this->line_number++;
+    }
+}
+
+
+/**
+ *  Skip the blanks and parse the next floating point number into @param: value
+ *
+ *  @return if a number was parsed
+ */
+bool Scanner::readDouble(double& value) {
+
+    this->skipBlanks();
+    auto next = parseDouble(this->position, this->end, value);
+    if (next == nullptr) {
+        return false;
+    }
+
+    this->position = next;
+    return true;
+}
+
+
+/**
+ *  Skip the blanks and parse the next unsigned integer into @param: value
+ *
+ *  @return if an integer was parsed
+ */
+bool Scanner::readIndex(size_t& value) {
+
+    this->skipBlanks();
+    auto next = parseIndex(this->position, this->end, value);
+    if (next == nullptr) {
+        return false;
+    }
+
+    this->position = next;
+    return true;
+}
+
+
+/*
+ *  BUFFERED WRITER
+ */
+
+/**
+ *  Constructor that creates the file @param: filename, with a buffer of @param: buffer_size characters
+ */
+BufferedWriter::BufferedWriter(const std::string& filename, size_t buffer_size) :
+    output_file (filename),
+    output_file_stream (this->output_file.get_stream()),
+    buffer (std::max<size_t>(buffer_size, 64)),
+    size (0)
+{
+    if (!this->output_file_stream.good()) {
+        throw std::runtime_error("The file " + filename + " could not be created. Maybe you specified a wrong path?");
+    }
+}
+
+
+/**
+ *  Write the buffer to disk
+ */
+void BufferedWriter::flush() {
+
+    this->output_file_stream.write(this->buffer.data(), static_cast<std::streamsize>(this->size));
+    this->size = 0;
+
+    if (!this->output_file_stream.good()) {
+        throw std::runtime_error("Something went wrong while writing to disk. Maybe the disk is full?");
+    }
+}
+
+
+/**
+ *  Append @param: number_of_characters characters at @param: characters
+ */
+void BufferedWriter::write(const char* characters, size_t number_of_characters) {
+
+    if (this->size + number_of_characters > this->buffer.size()) {
+        this->flush();
+
+        // Text that doesn't fit in the buffer is written directly
+        if (number_of_characters > this->buffer.size()) {
+            this->output_file_stream.write(characters, static_cast<std::streamsize>(number_of_characters));
+            return;
+        }
+    }
+
+    std::memcpy(this->buffer.data() + this->size, characters, number_of_characters);
+    this->size += number_of_characters;
+}
+
+
+/**
+ *  Append a double @param: value with 17 significant digits (see formatDouble), right-aligned in a field of @param: width characters
+ */
+void BufferedWriter::writeDouble(double value, size_t width) {
+
+    char characters[64];
+    const size_t length = formatDouble(value, characters + 32);
+    const size_t padding = std::min<size_t>((width > length) ? width - length : 0, 32);
+    std::memset(characters + 32 - padding, ' ', padding);
+
+    this->write(characters + 32 - padding, padding + length);
+}
+
+
+/**
+ *  Append an unsigned integer @param: value, right-aligned in a field of @param: width characters
+ */
+void BufferedWriter::writeIndex(size_t value, size_t width) {
+
+    char characters[64];
+    char* p = characters + 64;
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    const size_t length = static_cast<size_t>(characters + 64 - p);
+    const size_t padding = std::min<size_t>((width > length) ? width - length : 0, static_cast<size_t>(p - characters));
+    p -= padding;
+    std::memset(p, ' ', padding);
+
+    this->write(p, padding + length);
+}
+
+
+/**
+ *  Write the buffer to disk, close the file and replace the destination by it
+ */
+void BufferedWriter::close() {
+
+    this->flush();
+    this->output_file.commit();
+}
+
+
+/*
+ *  COMPRESSION
+ */
+
+/**
+ *  @return the compression of the file @param: filename, as detected from its first bytes
+ */
+Compression detectCompression(const std::string& filename) {
+
+    std::ifstream input_file_stream (filename, std::ios::binary);
+    unsigned char magic[4] = {0, 0, 0, 0};
+    input_file_stream.read(reinterpret_cast<char*>(magic), sizeof(magic));
+
+    if ((magic[0] == 0x1f) && (magic[1] == 0x8b)) {
+        return Compression::gzip;
+    } else if ((magic[0] == 0x28) && (magic[1] == 0xb5) && (magic[2] == 0x2f) && (magic[3] == 0xfd)) {
+        return Compression::zstd;
+    } else {
+        return Compression::none;  // also for files that don't exist, which their reader should report
+    }
+}
+
+
+/**
+ *  @return if libwint was built with support for the given @param: compression (i.e. with zlib for gzip and with libzstd for zstd)
+ */
+bool isSupported(Compression compression) {
+
+    switch (compression) {
+        case Compression::none: {
+            return true;
+        }
+        case Compression::gzip: {
+#ifdef LIBWINT_HAS_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        }
+        case Compression::zstd: {
+#ifdef LIBWINT_HAS_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ *  @return @param: filename if it exists, otherwise the first existing compressed variant (@param: filename.gz or @param: filename.zst), or @param: filename if none of those exist
+ */
+std::string resolveFilename(const std::string& filename) {
+
+    for (const char* suffix : {"", ".gz", ".zst"}) {
+        if (std::ifstream(filename + suffix).good()) {
+            return filename + suffix;
+        }
+    }
+
+    return filename;
+}
+
+
+/**
+ *  @return the whole (decompressed) contents of the file @param: filename
+ */
+std::string readFile(const std::string& filename) {
+
+    DecompressingReader reader (filename);
+
+    std::string contents;
+    std::vector<char> chunk;
+    while (reader.read(chunk)) {
+        contents.append(chunk.data(), chunk.size());
+    }
+
+    return contents;
+}
+
+
+
+/*
+ *  DECOMPRESSING READER
+ */
+
+/**
+ *  Constructor that starts reading the file @param: filename, in chunks of about @param: chunk_size characters, of which at most @param: queue_capacity wait to be read
+ */
+DecompressingReader::DecompressingReader(const std::string& filename, size_t chunk_size, size_t queue_capacity) :
+    filename (filename),
+    compression (detectCompression(filename)),
+    chunk_size (std::max<size_t>(chunk_size, 1)),
+    queue_capacity (std::max<size_t>(queue_capacity, 1))
+{
+    if (!std::ifstream(filename).good()) {
+        throw std::runtime_error("The file " + filename + " could not be opened. Maybe you specified a wrong path?");
+    }
+    if (!isSupported(this->compression)) {
+        throw std::runtime_error("The file " + filename + " is compressed in a format that libwint wasn't built to read (gzip requires zlib, zstd requires libzstd).");
+    }
+
+    this->decompression_thread = std::thread(&DecompressingReader::decompress, this);
+}
+
+
+DecompressingReader::~DecompressingReader() {
+
+    {
+        std::lock_guard<std::mutex> lock (this->queue_mutex);
+        this->is_stopped = true;
+    }
+    this->queue_condition.notify_all();
+
+    this->decompression_thread.join();
+}
+
+
+/**
+ *  Queue the whole lines in @param: text, and keep the last (incomplete) line in @param: text. If @param: is_last, all the text is queued
+ *
+ *  @return false if the reader has been stopped
+ */
+bool DecompressingReader::queueLines(std::vector<char>& text, bool is_last) {
+
+    size_t length = text.size();
+    if (!is_last) {
+        while ((length > 0) && (text[length - 1] != '\n')) {
+            length--;
+        }
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    std::vector<char> chunk (text.begin(), text.begin() + length);
+    text.erase(text.begin(), text.begin() + length);
+
+    std::unique_lock<std::mutex> lock (this->queue_mutex);
+    this->queue_condition.wait(lock, [this] () { return (this->queue.size() < this->queue_capacity) || this->is_stopped; });
+    if (this->is_stopped) {
+        return false;
+    }
+
+    this->queue.push_back(std::move(chunk));
+    this->queue_condition.notify_all();
+    return true;
+}
+
+
+/**
+ *  The loop of the background thread, which reads and decompresses the file into chunks
+ */
+void DecompressingReader::decompress() {
+
+    try {
+        std::ifstream input_file_stream (this->filename, std::ios::binary);
+
+        std::vector<char> input (1 << 18);
+        auto read_input = [&input_file_stream, &input] () {
+            input_file_stream.read(input.data(), static_cast<std::streamsize>(input.size()));
+            return static_cast<size_t>(input_file_stream.gcount());
+        };
+
+        const size_t output_block_size = 1 << 18;
+        std::vector<char> text;  // the decompressed text that hasn't been queued yet
+        text.reserve(this->chunk_size + output_block_size);
+
+        switch (this->compression) {
+            case Compression::none: {
+                for (size_t number_of_bytes = read_input(); number_of_bytes > 0; number_of_bytes = read_input()) {
+                    text.insert(text.end(), input.data(), input.data() + number_of_bytes);
+                    if ((text.size() >= this->chunk_size) && !this->queueLines(text, false)) {
+                        return;
+                    }
+                }
+                break;
+            }
+
+            case Compression::gzip: {
+#ifdef LIBWINT_HAS_ZLIB
+                z_stream stream;
+                std::memset(&stream, 0, sizeof(stream));
+                if (inflateInit2(&stream, 15 + 32) != Z_OK) {  // 15 + 32: the largest window, with automatic detection of the gzip header
+                    throw std::runtime_error("The gzip decompression could not be initialized.");
+                }
+                std::unique_ptr<z_stream, int(*)(z_stream*)> stream_guard (&stream, inflateEnd);
+
+                bool is_end_of_member = false;
+                for (size_t number_of_bytes = read_input(); number_of_bytes > 0; number_of_bytes = read_input()) {
+                    stream.next_in = reinterpret_cast<Bytef*>(input.data());
+                    stream.avail_in = static_cast<uInt>(number_of_bytes);
+
+                    while (true) {
+                        // A gzip file can consist of multiple concatenated members
+                        if (is_end_of_member) {
+                            if (stream.avail_in == 0) {
+                                break;
+                            }
+                            inflateReset(&stream);
+                            is_end_of_member = false;
+                        }
+
+                        const size_t size = text.size();
+                        text.resize(size + output_block_size);
+                        stream.next_out = reinterpret_cast<Bytef*>(text.data() + size);
+                        stream.avail_out = static_cast<uInt>(output_block_size);
+
+                        int status = inflate(&stream, Z_NO_FLUSH);
+                        const bool is_output_full = (stream.avail_out == 0);
+                        text.resize(size + output_block_size - stream.avail_out);
+
+                        if (status == Z_STREAM_END) {
+                            is_end_of_member = true;
+                        } else if ((status != Z_OK) && (status != Z_BUF_ERROR)) {
+                            throw std::runtime_error("The gzip compressed file " + this->filename + " is corrupted.");
+                        }
+
+                        if ((text.size() >= this->chunk_size) && !this->queueLines(text, false)) {
+                            return;
+                        }
+                        if (!is_output_full && (stream.avail_in == 0)) {
+                            break;
+                        }
+                    }
+                }
+
+                if (!is_end_of_member) {
+                    throw std::runtime_error("The gzip compressed file " + this->filename + " is truncated.");
+                }
+#endif
+                break;
+            }
+
+            case Compression::zstd: {
+#ifdef LIBWINT_HAS_ZSTD
+                std::unique_ptr<ZSTD_DStream, size_t(*)(ZSTD_DStream*)> stream (ZSTD_createDStream(), ZSTD_freeDStream);
+                if (!stream || ZSTD_isError(ZSTD_initDStream(stream.get()))) {
+                    throw std::runtime_error("The zstd decompression could not be initialized.");
+                }
+
+                size_t last_result = 0;  // 0 at the end of a frame
+                for (size_t number_of_bytes = read_input(); number_of_bytes > 0; number_of_bytes = read_input()) {
+                    ZSTD_inBuffer input_buffer = {input.data(), number_of_bytes, 0};
+
+                    while (true) {
+                        const size_t size = text.size();
+                        text.resize(size + output_block_size);
+                        ZSTD_outBuffer output_buffer = {text.data() + size, output_block_size, 0};
+
+                        last_result = ZSTD_decompressStream(stream.get(), &output_buffer, &input_buffer);
+                        if (ZSTD_isError(last_result)) {
+                            throw std::runtime_error("The zstd compressed file " + this->filename + " is corrupted: " + ZSTD_getErrorName(last_result));
+                        }
+                        const bool is_output_full = (output_buffer.pos == output_block_size);
+                        text.resize(size + output_buffer.pos);
+
+                        if ((text.size() >= this->chunk_size) && !this->queueLines(text, false)) {
+                            return;
+                        }
+                        if (!is_output_full && (input_buffer.pos == input_buffer.size)) {
+                            break;
+                        }
+                    }
+                }
+
+                if (last_result != 0) {
+                    throw std::runtime_error("The zstd compressed file " + this->filename + " is truncated.");
+                }
+#endif
+                break;
+            }
+        }
+
+        this->queueLines(text, true);
+
+    } catch (...) {
+        std::lock_guard<std::mutex> lock (this->queue_mutex);
+        this->error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock (this->queue_mutex);
+        this->is_finished = true;
+    }
+    this->queue_condition.notify_all();
+}
+
+
+/**
+ *  Wait for the next chunk of whole lines and move it into @param: chunk. Errors of the background thread are rethrown
+ *
+ *  @return false if all the chunks have been read
+ */
+bool DecompressingReader::read(std::vector<char>& chunk) {
+
+    std::unique_lock<std::mutex> lock (this->queue_mutex);
+    this->queue_condition.wait(lock, [this] () { return !this->queue.empty() || this->is_finished; });
+
+    if (!this->queue.empty()) {
+        chunk = std::move(this->queue.front());
+        this->queue.pop_front();
+        this->queue_condition.notify_all();
+        return true;
+    }
+
+    if (this->error) {
+        std::rethrow_exception(this->error);
+    }
+    return false;
+}
+
+
+/*
+ *  LINE CHUNK READER
+ */
+
+/**
+ *  Constructor for the file @param: filename, which will be read in chunks of about @param: chunk_size characters
+ */
+LineChunkReader::LineChunkReader(const std::string& filename, size_t chunk_size) {
+
+    if (detectCompression(filename) == Compression::none) {
+        this->mapped_file.reset(new libwint::MappedFile(filename));
+
+        const char* begin = this->mapped_file->get_data();
+        this->boundaries = splitAtNewlines(begin, begin + this->mapped_file->get_size(), std::max<size_t>(chunk_size, 1));
+    } else {
+        this->reader.reset(new DecompressingReader(filename, chunk_size));
+    }
+}
+
+
+/**
+ *  Read the next chunk [@param: begin, @param: end), using @param: storage for decompressed text. The chunk stays valid as long as @param: storage isn't changed
+ *
+ *  @return false if all the chunks have been read
+ */
+bool LineChunkReader::read(const char*& begin, const char*& end, std::vector<char>& storage) {
+
+    if (this->reader) {
+        if (!this->reader->read(storage)) {
+            return false;
+        }
+        begin = storage.data();
+        end = begin + storage.size();
+    } else {
+        if (this->next_chunk + 1 >= this->boundaries.size()) {
+            return false;
+        }
+        begin = this->boundaries[this->next_chunk];
+        end = this->boundaries[this->next_chunk + 1];
+        this->next_chunk++;
+    }
+
+    this->number_of_bytes += static_cast<size_t>(end - begin);
+    return true;
+}
+
+
+}  // namespace io
+}  // namespace libwint
@@ -0,0 +1,84 @@
+#include "threading.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+namespace libwint {
+namespace threading {
+
+
+/**
+ *  @return the number of threads that should be used when @param: number_of_threads threads are requested:
+ *      - a non-zero request is honoured as such
+ *      - a zero request falls back to the environment variable LIBWINT_NUM_THREADS, or to the number of hardware threads if that variable isn't set
+ */
+size_t numberOfThreads(size_t number_of_threads) {
+
+    if (number_of_threads > 0) {
+        return number_of_threads;
+    }
+
+    const char* environment_value = std::getenv("LIBWINT_NUM_THREADS");
+    if (environment_value != nullptr) {
+        try {
+            auto value = std::stoul(environment_value);
+            if (value > 0) {
+                return value;
+            }
+        } catch (const std::exception& e) {
+            throw std::invalid_argument("The environment variable LIBWINT_NUM_THREADS should be a positive integer.");
+        }
+    }
+
+    // std::thread::hardware_concurrency() is allowed to return 0 if it can't figure out the number of hardware threads
+    return std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1));
+}
+
+
+/**
+ *  Run @param: worker(thread_id) on @param: number_of_threads threads (thread_id = 0, ..., number_of_threads - 1) and wait for all of them to finish
+ *
+ *  The worker with thread_id 0 runs on the calling thread. If any of the workers throws, the first exception is rethrown after all the threads have been joined.
+ */
+void parallelFor(size_t number_of_threads, const std::function<void(size_t)>& worker) {
+
+    number_of_threads = std::max(number_of_threads, static_cast<size_t>(1));
+
+    // Exceptions can't cross thread boundaries by themselves, so we'll have to catch and store them
+    std::vector<std::exception_ptr> exceptions (number_of_threads);
+    auto guarded_worker = [&worker, &exceptions] (size_t thread_id) {
+        try {
+            worker(thread_id);
+        } catch (...) {
+            exceptions[thread_id] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(number_of_threads - 1);
+    for (size_t thread_id = 1; thread_id < number_of_threads; thread_id++) {
+        threads.emplace_back(guarded_worker, thread_id);
+    }
+    guarded_worker(0);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& exception : exceptions) {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
+
+
+}  // namespace threading
+}  // namespace libwint
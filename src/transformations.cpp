@@ -1,15 +1,95 @@
 #include "transformations.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include <Eigen/Jacobi>
 
+#include "threading.hpp"
+
 
 
 namespace libwint {
 namespace transformations {
 
 
+namespace {
+
+/**
+ *  A Jacobi rotation of the orbitals p and q, with c = cos(theta) and s = sin(theta)
+ */
+struct Givens {
+    size_t p;
+    size_t q;
+    double c;
+    double s;
+};
+
+
+/**
+ *  Apply the given sequence of Jacobi @param: rotations to the axis @param: axis of the rank-four tensor @param: g
+ *
+ *  Since g is stored column-major, the tensor can be seen as a number of (K^axis x K)-matrices whose columns are the slices of the given axis, and a rotation of p and q rotates the columns p and q of every matrix
+ *  The rows of every matrix are handled in tiles of about @param: tile_size elements, to which the whole sequence is applied while they are in cache
+ */
+void rotateAxisJacobi(Eigen::Tensor<double, 4>& g, size_t axis, const std::vector<Givens>& rotations, size_t tile_size = 1 << 12) {
+
+    const auto K = static_cast<size_t>(g.dimension(0));
+    if (K == 0) {  // there's nothing to rotate
+        return;
+    }
+
+    size_t stride = 1;  // K^axis, i.e. the number of rows of the matrices
+    for (size_t i = 0; i < axis; i++) {
+        stride *= K;
+    }
+    const size_t block_size = stride * K;  // the number of elements in one matrix
+    const size_t number_of_blocks = static_cast<size_t>(g.size()) / block_size;
+    const size_t rows_per_tile = std::max<size_t>(tile_size / K, 1);
+
+    double* data = g.data();
+    for (size_t block = 0; block < number_of_blocks; block++) {
+        for (size_t row_begin = 0; row_begin < stride; row_begin += rows_per_tile) {
+            const size_t number_of_rows = std::min(rows_per_tile, stride - row_begin);
+            double* tile = data + block * block_size + row_begin;
+
+            for (const auto& rotation : rotations) {
+                double* x = tile + rotation.p * stride;
+                double* y = tile + rotation.q * stride;
+
+                // Cfr. B' = B J with J(p,p) = J(q,q) = c and J(p,q) = -J(q,p) = s
+                for (size_t i = 0; i < number_of_rows; i++) {
+                    const double x_i = x[i];
+                    const double y_i = y[i];
+                    x[i] = rotation.c * x_i - rotation.s * y_i;
+                    y[i] = rotation.s * x_i + rotation.c * y_i;
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ *  Check the given Jacobi @param: rotations for an M-dimensional vector space, and @return their sines and cosines
+ */
+std::vector<Givens> toGivens(const std::vector<JacobiRotationParameters>& rotations, size_t M) {
+
+    std::vector<Givens> givens;
+    givens.reserve(rotations.size());
+    for (const auto& rotation : rotations) {
+        checkJacobiParameters(rotation.p, rotation.q, M);
+        givens.push_back(Givens {rotation.p, rotation.q, std::cos(rotation.angle), std::sin(rotation.angle)});
+    }
+
+    return givens;
+}
+
+}  // anonymous namespace
+
+
+
 /*
  *  GENERAL TRANSFORMATIONS
  */
@@ -48,42 +128,134 @@ Eigen::MatrixXd transformOneElectronIntegrals(const Eigen::MatrixXd& h, const Ei
  *      B' = B T ,
  *
  *  where the basis vectors are collected as elements of a row vector
+ *
+ *  T may be rectangular (K x M), in which case the transformed tensor has dimension M. The transformation is done one index (quarter) at a time, and every quarter transformation is one matrix product on a matrix view of the (partially transformed) tensor:
+ *      (a, bcd) -> (bcd, P) -> (cdP, Q) -> (dPQ, R) -> (PQR, S)
+ *  i.e. the first index is contracted with T and the new index is appended at the end, so no shuffles are needed. The intermediates alternate between two scratch buffers
  */
 Eigen::Tensor<double, 4> transformTwoElectronIntegrals(const Eigen::Tensor<double, 4>& g, const Eigen::MatrixXd& T) {
+    return transformTwoElectronIntegrals(Eigen::TensorMap<const Eigen::Tensor<double, 4>>(g.data(), g.dimensions()), T);
+}
 
-    // Since we're only getting T as a matrix, we should make the appropriate tensor to perform contractions
-    // For the const Eigen::MatrixXd& argument, we need the const double in the template
-    //      For more info, see: https://stackoverflow.com/questions/45283468/eigen-const-tensormap
-    Eigen::TensorMap<Eigen::Tensor<const double, 2>> T_tensor (T.data(), T.rows(), T.cols());
+Eigen::Tensor<double, 4> transformTwoElectronIntegrals(const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g, const Eigen::MatrixXd& T) {
 
+    const auto K = static_cast<Eigen::Index>(g.dimension(0));
+    const auto M = static_cast<Eigen::Index>(T.cols());
+    if ((g.dimension(1) != K) || (g.dimension(2) != K) || (g.dimension(3) != K)) {
+        throw std::invalid_argument("The given tensor is not a rank-four tensor of equal dimensions.");
+    }
+    if (T.rows() != K) {
+        throw std::invalid_argument("The number of rows of the transformation matrix should be equal to the dimension of the tensor.");
+    }
+
+    // Every quarter transformation contracts the first index and appends the transformed index at the end, so after four of them the indices are in the right order again
+    // The intermediates (b c d P) and (d P Q R) share the first buffer, (c d P Q) uses the second one
+    Eigen::VectorXd buffer1 (std::max(K * K * K * M, K * M * M * M));
+    Eigen::VectorXd buffer2 (K * K * M * M);
 
-    // We will have to do four single contractions, so we specify the contraction indices
-    // Eigen3 does not document its tensor contraction clearly, so see the accepted answer on stackoverflow (https://stackoverflow.com/a/47558349/7930415):
-    //      Eigen3 does not accept a way to specify the output axes: instead, it retains the order from left to right of the axes that survive the contraction.
-    //      This means that, in order to get the right ordering of the axes, we will have to swap axes
+    // 1) (b c d P) = sum_a g(a b c d) T(a P)
+    Eigen::Map<const Eigen::MatrixXd> quarter0 (g.data(), K, K * K * K);
+    Eigen::Map<Eigen::MatrixXd> (buffer1.data(), K * K * K, M).noalias() = quarter0.transpose() * T;
 
-    // g(T U V W)  T^*(V R) -> a(T U R W) but we get a(T U W R)
-    Eigen::array<Eigen::IndexPair<int>, 1> contraction_pair1 = {Eigen::IndexPair<int>(2, 0)};
-    Eigen::array<int, 4> shuffle_1 {0, 1, 3, 2};
+    // 2) (c d P Q) = sum_b (b c d P) T(b Q)
+    Eigen::Map<const Eigen::MatrixXd> quarter1 (buffer1.data(), K, K * K * M);
+    Eigen::Map<Eigen::MatrixXd> (buffer2.data(), K * K * M, M).noalias() = quarter1.transpose() * T;
 
-    // a(T U R W)  T(W S) -> b(T U R S) and we get b(T U R S), so no shuffle is needed
-    Eigen::array<Eigen::IndexPair<int>, 1> contraction_pair2 = {Eigen::IndexPair<int>(3, 0)};
+    // 3) (d P Q R) = sum_c (c d P Q) T(c R)
+    Eigen::Map<const Eigen::MatrixXd> quarter2 (buffer2.data(), K, K * M * M);
+    Eigen::Map<Eigen::MatrixXd> (buffer1.data(), K * M * M, M).noalias() = quarter2.transpose() * T;
 
-    // T(U Q)  b(T U R S) -> c(T Q R S) but we get c(Q T R S)
-    Eigen::array<Eigen::IndexPair<int>, 1> contraction_pair3 = {Eigen::IndexPair<int>(0, 1)};
-    Eigen::array<int, 4> shuffle_3 {1, 0, 2, 3};
+    // 4) (P Q R S) = sum_d (d P Q R) T(d S)
+    Eigen::Tensor<double, 4> g_transformed (M, M, M, M);
+    Eigen::Map<const Eigen::MatrixXd> quarter3 (buffer1.data(), K, M * M * M);
+    Eigen::Map<Eigen::MatrixXd> (g_transformed.data(), M * M * M, M).noalias() = quarter3.transpose() * T;
 
-    // T^*(T P)  c(T Q R S) -> g'(P Q R S) and we get g_SO(p q r s), so no shuffle is needed
-    Eigen::array<Eigen::IndexPair<int>, 1> contraction_pair4 = {Eigen::IndexPair<int>(0, 0)};
+    return g_transformed;
+}
 
 
-    // Calculate the contractions. We write this as one large contraction to
-    //  1) avoid storing intermediate contractions
-    //  2) let Eigen3 figure out some optimizations
-    Eigen::Tensor<double, 4> g_transformed = T_tensor.conjugate().contract(T_tensor.contract(g.contract(T_tensor.conjugate(), contraction_pair1).shuffle(shuffle_1).contract(T_tensor, contraction_pair2), contraction_pair3).shuffle(shuffle_3), contraction_pair4);
+/**
+ *  Transform the two-electron integrals @param: g, which should have the 8-fold permutational symmetry, with the (K x M) transformation matrix @param: T (as in transformTwoElectronIntegrals), and @return only the unique transformed integrals (pq|rs) with p >= q, r >= s and (pq) >= (rs)
+ *
+ *  The transformation works on pair-packed intermediates, in two halves:
+ *      1) for every AO pair (ab) with a >= b, the K x K matrix (..|ab) is transformed into T^T (..|ab) T, of which only the pairs (pq) with p >= q are kept
+ *      2) for every pair (pq), the symmetric K x K matrix (pq|..) is transformed into T^T (pq|..) T, of which only the pairs (rs) with r >= s and (rs) <= (pq) are kept
+ *  which takes about half the flops and a quarter of the intermediate memory of the full transformation. The pairs are distributed over @param: number_of_threads threads, where 0 means libwint's default (see threading::numberOfThreads)
+ */
+libwint::PackedERITensor transformTwoElectronIntegralsPacked(const Eigen::Tensor<double, 4>& g, const Eigen::MatrixXd& T, size_t number_of_threads) {
+    return transformTwoElectronIntegralsPacked(Eigen::TensorMap<const Eigen::Tensor<double, 4>>(g.data(), g.dimensions()), T, number_of_threads);
+}
+
+libwint::PackedERITensor transformTwoElectronIntegralsPacked(const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g, const Eigen::MatrixXd& T, size_t number_of_threads) {
+
+    const auto K = static_cast<size_t>(g.dimension(0));
+    const auto M = static_cast<size_t>(T.cols());
+    if ((g.dimension(1) != g.dimension(0)) || (g.dimension(2) != g.dimension(0)) || (g.dimension(3) != g.dimension(0))) {
+        throw std::invalid_argument("The given tensor is not a rank-four tensor of equal dimensions.");
+    }
+    if (static_cast<size_t>(T.rows()) != K) {
+        throw std::invalid_argument("The number of rows of the transformation matrix should be equal to the dimension of the tensor.");
+    }
+
+    const size_t number_of_AO_pairs = K * (K + 1) / 2;
+    const size_t number_of_MO_pairs = M * (M + 1) / 2;
+    number_of_threads = libwint::threading::numberOfThreads(number_of_threads);
+
+
+    // 1) The half-transformed integrals (pq|ab), stored as the (AO pairs x MO pairs) matrix H((ab), (pq)), so that the second half reads contiguous columns
+    Eigen::MatrixXd H (number_of_AO_pairs, number_of_MO_pairs);
+    libwint::threading::parallelFor(number_of_threads, [&] (size_t thread_id) {
+        Eigen::MatrixXd half (M, K);
+        Eigen::MatrixXd transformed (M, M);
+
+        for (size_t ab = thread_id; ab < number_of_AO_pairs; ab += number_of_threads) {
+            // Find a >= b from the pair index (ab) = a (a + 1) / 2 + b
+            size_t a = static_cast<size_t>((std::sqrt(8.0 * static_cast<double>(ab) + 1.0) - 1.0) / 2.0);
+            while (a * (a + 1) / 2 > ab) { a--; }
+            while ((a + 1) * (a + 2) / 2 <= ab) { a++; }
+            const size_t b = ab - a * (a + 1) / 2;
+
+            Eigen::Map<const Eigen::MatrixXd> g_ab (g.data() + (a + K * b) * K * K, K, K);
+            half.noalias() = T.transpose() * g_ab;
+            transformed.noalias() = half * T;
+
+            for (size_t p = 0; p < M; p++) {
+                for (size_t q = 0; q <= p; q++) {
+                    H(ab, p * (p + 1) / 2 + q) = transformed(p, q);
+                }
+            }
+        }
+    });
+
+
+    // 2) For every pair (pq), transform (pq|ab) into (pq|rs) and keep (rs) <= (pq), which are stored contiguously in the packed tensor
+    libwint::PackedERITensor g_transformed (M);
+    double* packed = g_transformed.get_data().data();
+    libwint::threading::parallelFor(number_of_threads, [&] (size_t thread_id) {
+        Eigen::MatrixXd g_pq (K, K);
+        Eigen::MatrixXd half (M, K);
+        Eigen::MatrixXd transformed (M, M);
+
+        for (size_t pq = thread_id; pq < number_of_MO_pairs; pq += number_of_threads) {
+            for (size_t a = 0; a < K; a++) {
+                for (size_t b = 0; b <= a; b++) {
+                    g_pq(a, b) = g_pq(b, a) = H(a * (a + 1) / 2 + b, pq);
+                }
+            }
+            half.noalias() = T.transpose() * g_pq;
+            transformed.noalias() = half * T;
+
+            double* row = packed + pq * (pq + 1) / 2;
+            for (size_t r = 0, rs = 0; (r < M) && (rs <= pq); r++) {
+                for (size_t s = 0; (s <= r) && (rs <= pq); s++, rs++) {
+                    row[rs] = transformed(r, s);
+                }
+            }
+        }
+    });
 
     return g_transformed;
-};
+}
 
 
 /*
@@ -123,6 +295,56 @@ Eigen::Tensor<double, 4> transform_AO_to_SO(const Eigen::Tensor<double, 4>& g_AO
     return transformTwoElectronIntegrals(g_AO, C);
 };
 
+Eigen::Tensor<double, 4> transform_AO_to_SO(const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g_AO, const Eigen::MatrixXd& C) {
+    return transformTwoElectronIntegrals(g_AO, C);
+};
+
+
+/*
+ *  ACTIVE SPACES
+ */
+
+/**
+ *  @return the inactive Fock matrix F_I = h + J[D] - 1/2 K[D] in the AO basis, for the AO one-electron integrals @param: h_AO, the AO two-electron integrals @param: g_AO and the doubly occupied core orbitals @param: C_core (every column represents a spatial orbital)
+ *
+ *  D = 2 C_core C_core^T is the core density matrix, J[D]_ab = sum_cd (ab|cd) D_cd and K[D]_ab = sum_cd (ac|bd) D_cd
+ */
+Eigen::MatrixXd calculateInactiveFockMatrix(const Eigen::MatrixXd& h_AO, const Eigen::TensorMap<const Eigen::Tensor<double, 4>>& g_AO, const Eigen::MatrixXd& C_core) {
+
+    const auto K = static_cast<Eigen::Index>(g_AO.dimension(0));
+    if ((g_AO.dimension(1) != K) || (g_AO.dimension(2) != K) || (g_AO.dimension(3) != K) || (h_AO.rows() != K) || (h_AO.cols() != K) || (C_core.rows() != K)) {
+        throw std::invalid_argument("The dimensions of the given integrals and core orbitals are inconsistent.");
+    }
+
+    const Eigen::MatrixXd D = 2 * C_core * C_core.transpose();
+
+    // J[D] is the matrix-vector product of the (K^2 x K^2) supermatrix (ab|cd) with the vectorized D
+    Eigen::MatrixXd J (K, K);
+    Eigen::Map<Eigen::VectorXd> (J.data(), K * K).noalias() = Eigen::Map<const Eigen::MatrixXd> (g_AO.data(), K * K, K * K) * Eigen::Map<const Eigen::VectorXd> (D.data(), K * K);
+
+    // K[D]_(.b) = sum_d (..|bd) D_(.d), in which every (..|bd) is a contiguous (K x K) matrix
+    Eigen::MatrixXd K_D = Eigen::MatrixXd::Zero(K, K);
+    for (Eigen::Index d = 0; d < K; d++) {
+        for (Eigen::Index b = 0; b < K; b++) {
+            Eigen::Map<const Eigen::MatrixXd> g_bd (g_AO.data() + (b + K * d) * K * K, K, K);
+            K_D.col(b).noalias() += g_bd * D.col(d);
+        }
+    }
+
+    return h_AO + J - 0.5 * K_D;
+}
+
+
+/**
+ *  @return the energy of the doubly occupied core orbitals @param: C_core, i.e. E_core = 1/2 tr(D (h_AO + F_I)) with D = 2 C_core C_core^T, for the AO one-electron integrals @param: h_AO and the inactive Fock matrix @param: F_I (see calculateInactiveFockMatrix)
+ */
+double calculateCoreEnergy(const Eigen::MatrixXd& h_AO, const Eigen::MatrixXd& F_I, const Eigen::MatrixXd& C_core) {
+
+    // tr(D X) = 2 tr(C^T X C)
+    return (C_core.transpose() * (h_AO + F_I) * C_core).trace();
+}
+
+
 
 /*
  *  JACOBI ROTATIONS AND WRAPPERS
@@ -180,24 +402,31 @@ Eigen::MatrixXd jacobiRotationMatrix(size_t p, size_t q, double theta, size_t M)
 }
 
 
+/**
+ *  Give the M-dimensional product J_1 J_2 ... J_n of the Jacobi rotation matrices for the given sequence of @param: rotations, i.e. the transformation matrix that applies the rotations in the given order
+ */
+Eigen::MatrixXd jacobiRotationMatrix(const std::vector<JacobiRotationParameters>& rotations, size_t M) {
+
+    Eigen::MatrixXd U = Eigen::MatrixXd::Identity(M, M);
+
+    // Every rotation only mixes two columns of the product
+    for (const auto& rotation : toGivens(rotations, M)) {
+        U.applyOnTheRight(rotation.p, rotation.q, Eigen::JacobiRotation<double> (rotation.c, rotation.s));
+    }
+
+    return U;
+}
+
+
 /**
  *  Using a Jacobi rotation with angle theta of the orbitals p and q, return the transformed one-electron integrals.
  *  This function is implemented using Eigen's Jacobi module.
  */
 Eigen::MatrixXd rotateOneElectronIntegralsJacobi(const Eigen::MatrixXd& h, size_t p, size_t q, double theta) {
 
-    checkJacobiParameters(p, q, h);
-
-    double c = std::cos(theta);
-    double s = std::sin(theta);
-
     // Initialize the rotated matrix by making a copy of the original matrix
     Eigen::MatrixXd h_rotated = h;
-
-    // Use Eigen's Jacobi module to apply the Jacobi rotations directly (cfr. T.adjoint() * h * T)
-    Eigen::JacobiRotation<double> jacobi (c, s);
-    h_rotated.applyOnTheLeft(p, q, jacobi.adjoint());
-    h_rotated.applyOnTheRight(p, q, jacobi);
+    rotateOneElectronIntegralsJacobiInPlace(h_rotated, p, q, theta);
 
     return h_rotated;
 }
@@ -205,16 +434,77 @@ Eigen::MatrixXd rotateOneElectronIntegralsJacobi(const Eigen::MatrixXd& h, size_
 
 /**
  *  Using a Jacobi rotation with angle theta of the orbitals p and q, return the transformed two-electron integrals.
- *  While waiting for an analogous Eigen::Tensor Jacobi module, this function is just a wrapper around transformTwoElectronIntegrals using a Jacobi rotation matrix.
+ *  This function is a wrapper around rotateTwoElectronIntegralsJacobiInPlace on a copy of @param: g.
  */
 Eigen::Tensor<double, 4> rotateTwoElectronIntegralsJacobi(const Eigen::Tensor<double, 4>& g, size_t p, size_t q, double theta) {
 
-    auto dim = static_cast<size_t>(g.dimension(1));  // g.dimension() returns a long
-    Eigen::MatrixXd J = jacobiRotationMatrix(p, q, theta, dim);
+    Eigen::Tensor<double, 4> g_rotated = g;
+    rotateTwoElectronIntegralsJacobiInPlace(g_rotated, p, q, theta);
 
-    return transformTwoElectronIntegrals(g, J);
+    return g_rotated;
 };
 
 
+/**
+ *  Using a Jacobi rotation with angle @param: theta (in radians) of the orbitals p and q, transform the one-electron integrals @param: h in place
+ */
+void rotateOneElectronIntegralsJacobiInPlace(Eigen::MatrixXd& h, size_t p, size_t q, double theta) {
+
+    checkJacobiParameters(p, q, h);
+
+    // Use Eigen's Jacobi module to apply the Jacobi rotations directly (cfr. T.adjoint() * h * T)
+    Eigen::JacobiRotation<double> jacobi (std::cos(theta), std::sin(theta));
+    h.applyOnTheLeft(p, q, jacobi.adjoint());
+    h.applyOnTheRight(p, q, jacobi);
+}
+
+
+/**
+ *  Using a Jacobi rotation with angle @param: theta (in radians) of the orbitals p and q, transform the two-electron integrals @param: g in place
+ *
+ *  A Jacobi rotation only mixes the slices p and q of every index, so the rotation is applied to one index at a time, updating only the O(K^3) elements that have that index equal to p or q. No Jacobi rotation matrix or intermediate tensor is needed
+ */
+void rotateTwoElectronIntegralsJacobiInPlace(Eigen::Tensor<double, 4>& g, size_t p, size_t q, double theta) {
+
+    rotateTwoElectronIntegralsJacobiInPlace(g, {JacobiRotationParameters {p, q, theta}});
+}
+
+
+/**
+ *  Apply the given sequence of Jacobi @param: rotations, in order, to the one-electron integrals @param: h in place
+ */
+void rotateOneElectronIntegralsJacobiInPlace(Eigen::MatrixXd& h, const std::vector<JacobiRotationParameters>& rotations) {
+
+    for (const auto& rotation : toGivens(rotations, static_cast<size_t>(h.cols()))) {
+        Eigen::JacobiRotation<double> jacobi (rotation.c, rotation.s);
+        h.applyOnTheLeft(rotation.p, rotation.q, jacobi.adjoint());
+        h.applyOnTheRight(rotation.p, rotation.q, jacobi);
+    }
+}
+
+
+/**
+ *  Apply the given sequence of Jacobi @param: rotations, in order, to the two-electron integrals @param: g in place
+ *
+ *  For every index, the tensor is walked through once in cache-sized blocks, to which all the rotations are applied before moving on to the next block. The whole sequence therefore costs four passes over g, instead of four passes per rotation
+ */
+void rotateTwoElectronIntegralsJacobiInPlace(Eigen::Tensor<double, 4>& g, const std::vector<JacobiRotationParameters>& rotations) {
+
+    auto dim = static_cast<size_t>(g.dimension(0));  // g.dimension() returns a long
+    if ((g.dimension(1) != g.dimension(0)) || (g.dimension(2) != g.dimension(0)) || (g.dimension(3) != g.dimension(0))) {
+        throw std::invalid_argument("The given tensor is not a rank-four tensor of equal dimensions.");
+    }
+    const auto givens = toGivens(rotations, dim);
+    if (givens.empty() || (dim == 0)) {  // don't pass over g for nothing
+        return;
+    }
+
+    // The rotations of different indices commute, so the whole sequence can be applied to one index after the other
+    for (size_t axis = 0; axis < 4; axis++) {
+        rotateAxisJacobi(g, axis, givens);
+    }
+}
+
+
 }  // namespace transformations
 }  // namespace libwint
@@ -2,9 +2,13 @@
 
 
 #include "AOBasis.hpp"
+#include "ERIFile.hpp"
+#include "LibintCommunicator.hpp"
 
 #include "cpputil.hpp"
 
+#include <cstdio>
+
 #include <boost/test/unit_test.hpp>
 #include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
 
@@ -88,3 +92,324 @@ BOOST_AUTO_TEST_CASE( szabo_h2_sto3g ) {
 
     BOOST_CHECK(std::abs(basis.get_g()(1,0,1,0) - 0.2970) < 1.0e-4);
 }
+
+
+BOOST_AUTO_TEST_CASE( schwarz_screening_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    size_t nbf = 7;
+
+    Eigen::Tensor<double, 4> ref_teri (nbf, nbf, nbf, nbf);
+    cpputil::io::readArrayFromFile("../tests/ref_data/h2o_sto-3g_two_electron.data", ref_teri);
+
+
+    // A vanishing threshold shouldn't screen anything
+    libwint::AOBasis basis (water, "STO-3G");
+    basis.calculateElectronRepulsionIntegrals(0.0);
+
+    BOOST_CHECK_EQUAL(basis.get_number_of_screened_quartets(), 0);
+    BOOST_CHECK(cpputil::linalg::areEqual(basis.get_g(), ref_teri, 1.0e-6));
+
+
+    // By the Cauchy-Schwarz inequality, the screened integrals can't be larger than the threshold
+    double threshold = 1.0e-02;
+    libwint::AOBasis screened_basis (water, "STO-3G");
+    screened_basis.calculateElectronRepulsionIntegrals(threshold);
+
+    BOOST_CHECK(screened_basis.get_number_of_screened_quartets() > 0);
+    BOOST_CHECK(cpputil::linalg::areEqual(screened_basis.get_g(), ref_teri, threshold));
+}
+
+
+BOOST_AUTO_TEST_CASE( multithreaded_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    size_t nbf = 7;
+
+    Eigen::Tensor<double, 4> ref_teri (nbf, nbf, nbf, nbf);
+    cpputil::io::readArrayFromFile("../tests/ref_data/h2o_sto-3g_two_electron.data", ref_teri);
+
+    // The result shouldn't depend on the number of threads
+    for (size_t number_of_threads : {1, 2, 3, 8}) {
+        libwint::AOBasis basis (water, "STO-3G");
+        basis.calculateElectronRepulsionIntegrals(0.0, number_of_threads);
+
+        BOOST_CHECK(cpputil::linalg::areEqual(basis.get_g(), ref_teri, 1.0e-6));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( basisset_cache ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    libwint::Molecule h2 ("../tests/ref_data/h2.xyz");
+    auto& communicator = libwint::LibintCommunicator::get();
+    communicator.clearBasisSetCache();
+
+    // Asking for the same basis set twice should give the same (cached) instance
+    auto basisset1 = communicator.getBasisSet("STO-3G", water.get_atoms());
+    auto basisset2 = communicator.getBasisSet("STO-3G", water.get_atoms());
+    BOOST_CHECK_EQUAL(basisset1.get(), basisset2.get());
+    BOOST_CHECK_EQUAL(basisset1->nbf, 7);
+    BOOST_CHECK_EQUAL(basisset1->shell2bf.size(), basisset1->basisset.size());
+
+    // ... but another basis set name or other atoms should give another instance
+    BOOST_CHECK(communicator.getBasisSet("6-31G", water.get_atoms()).get() != basisset1.get());
+    BOOST_CHECK(communicator.getBasisSet("STO-3G", h2.get_atoms()).get() != basisset1.get());
+
+    // Clearing the cache shouldn't invalidate the basis sets that are still in use
+    communicator.clearBasisSetCache();
+    BOOST_CHECK_EQUAL(basisset1->nbf, 7);
+    BOOST_CHECK(communicator.getBasisSet("STO-3G", water.get_atoms()).get() != basisset1.get());
+}
+
+
+BOOST_AUTO_TEST_CASE( fused_one_body_integrals_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    auto& communicator = libwint::LibintCommunicator::get();
+
+    // Calculating S, T and V in one sweep should give the same results as calculating them separately
+    auto matrices = communicator.calculateOneBodyIntegrals({libint2::Operator::overlap, libint2::Operator::kinetic, libint2::Operator::nuclear}, "STO-3G", water.get_atoms());
+    BOOST_REQUIRE_EQUAL(matrices.size(), 3);
+
+    BOOST_CHECK(matrices[0].isApprox(communicator.calculateOneBodyIntegrals(libint2::Operator::overlap, "STO-3G", water.get_atoms()), 1.0e-12));
+    BOOST_CHECK(matrices[1].isApprox(communicator.calculateOneBodyIntegrals(libint2::Operator::kinetic, "STO-3G", water.get_atoms()), 1.0e-12));
+    BOOST_CHECK(matrices[2].isApprox(communicator.calculateOneBodyIntegrals(libint2::Operator::nuclear, "STO-3G", water.get_atoms()), 1.0e-12));
+
+    // The fused matrices should be symmetric, since only the lower triangle is calculated
+    for (const auto& matrix : matrices) {
+        BOOST_CHECK(matrix.isApprox(matrix.transpose(), 1.0e-12));
+    }
+
+    // Check the fused results against the reference data from Horton
+    size_t nbf = 7;
+    Eigen::MatrixXd ref_S (nbf, nbf);
+    Eigen::MatrixXd ref_T (nbf, nbf);
+    Eigen::MatrixXd ref_V (nbf, nbf);
+    cpputil::io::readArrayFromFile("../tests/ref_data/h2o_sto-3g_overlap.data", ref_S);
+    cpputil::io::readArrayFromFile("../tests/ref_data/h2o_sto-3g_kinetic.data", ref_T);
+    cpputil::io::readArrayFromFile("../tests/ref_data/h2o_sto-3g_nuclear.data", ref_V);
+
+    BOOST_CHECK(matrices[0].isApprox(ref_S, 1.0e-8));
+    BOOST_CHECK(matrices[1].isApprox(ref_T, 1.0e-8));
+    BOOST_CHECK(matrices[2].isApprox(ref_V, 1.0e-8));
+}
+
+
+BOOST_AUTO_TEST_CASE( direct_coulomb_exchange_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    libwint::AOBasis basis (water, "STO-3G");
+    basis.calculateIntegrals();
+    auto nbf = static_cast<long>(basis.calculateNumberOfBasisFunctions());
+    const auto& g = basis.get_g();
+
+    // Use two (arbitrary) symmetric density matrices
+    std::vector<Eigen::MatrixXd> D;
+    for (size_t i = 0; i < 2; i++) {
+        Eigen::MatrixXd A = Eigen::MatrixXd::Random(nbf, nbf);
+        D.push_back(A + A.transpose());
+    }
+
+    // Contract the stored two-electron integrals to get the reference J and K
+    std::vector<Eigen::MatrixXd> ref_J (2, Eigen::MatrixXd::Zero(nbf, nbf));
+    std::vector<Eigen::MatrixXd> ref_K (2, Eigen::MatrixXd::Zero(nbf, nbf));
+    for (size_t i = 0; i < 2; i++) {
+        for (long p = 0; p < nbf; p++) {
+            for (long q = 0; q < nbf; q++) {
+                for (long r = 0; r < nbf; r++) {
+                    for (long s = 0; s < nbf; s++) {
+                        ref_J[i](p,q) += g(p,q,r,s) * D[i](r,s);
+                        ref_K[i](p,q) += g(p,r,q,s) * D[i](r,s);
+                    }
+                }
+            }
+        }
+    }
+
+    // The integral-direct J and K should be the same, for any number of threads
+    for (size_t number_of_threads : {1, 4}) {
+        std::vector<Eigen::MatrixXd> J;
+        std::vector<Eigen::MatrixXd> K;
+        size_t number_of_screened_quartets = 0;
+        libwint::LibintCommunicator::get().calculateCoulombAndExchangeMatrices("STO-3G", water.get_atoms(), D, J, K, 0.0, number_of_screened_quartets, number_of_threads);
+
+        BOOST_REQUIRE_EQUAL(J.size(), 2);
+        BOOST_REQUIRE_EQUAL(K.size(), 2);
+        for (size_t i = 0; i < 2; i++) {
+            BOOST_CHECK(J[i].isApprox(ref_J[i], 1.0e-10));
+            BOOST_CHECK(K[i].isApprox(ref_K[i], 1.0e-10));
+        }
+    }
+
+    // Density matrices of the wrong dimension should be rejected
+    std::vector<Eigen::MatrixXd> J;
+    std::vector<Eigen::MatrixXd> K;
+    BOOST_CHECK_THROW(libwint::LibintCommunicator::get().calculateCoulombAndExchangeMatrices("STO-3G", water.get_atoms(), {Eigen::MatrixXd::Zero(nbf+1, nbf+1)}, J, K), std::invalid_argument);
+}
+
+
+BOOST_AUTO_TEST_CASE( density_fitting_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    libwint::AOBasis basis (water, "STO-3G");
+    basis.calculateElectronRepulsionIntegrals();
+    auto g = basis.get_g();
+
+    BOOST_CHECK_THROW(basis.get_B(), std::logic_error);  // the density fitting factors haven't been calculated yet
+    basis.calculateDensityFittingFactors("def2-universal-jkfit");
+    const auto& B = basis.get_B();
+    BOOST_CHECK_EQUAL(B.get_K(), 7);
+
+    // The density-fitted integrals should be a good approximation of the exact integrals
+    Eigen::Tensor<double, 4> g_DF = B.toDense();
+    Eigen::Tensor<double, 0> max_error = (g_DF - g).abs().maximum();
+    BOOST_CHECK(max_error(0) < 1.0e-02);
+
+    // ... and they should have the 8-fold permutational symmetry
+    BOOST_CHECK(std::abs(B(1,2,3,4) - B(2,1,4,3)) < 1.0e-12);
+    BOOST_CHECK(std::abs(B(1,2,3,4) - B(3,4,1,2)) < 1.0e-12);
+
+
+    // The three-index integrals shouldn't depend on the number of threads
+    const auto& communicator = libwint::LibintCommunicator::get();
+    Eigen::MatrixXd three_index_integrals = communicator.calculateThreeCenterIntegrals("STO-3G", "def2-universal-jkfit", water.get_atoms(), 1);
+    BOOST_CHECK(three_index_integrals.isApprox(communicator.calculateThreeCenterIntegrals("STO-3G", "def2-universal-jkfit", water.get_atoms(), 3), 1.0e-12));
+
+    // ... and the two-index integrals should be symmetric
+    Eigen::MatrixXd V = communicator.calculateTwoCenterIntegrals("def2-universal-jkfit", water.get_atoms());
+    BOOST_CHECK(V.isApprox(V.transpose(), 1.0e-12));
+    BOOST_CHECK_EQUAL(V.rows(), three_index_integrals.rows());
+
+    // The rows of the density fitting factors should be indexed by the auxiliary basis functions
+    BOOST_CHECK_EQUAL(B.get_rank(), static_cast<size_t>(V.rows()));
+}
+
+
+BOOST_AUTO_TEST_CASE( cholesky_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    libwint::AOBasis basis (water, "STO-3G");
+    basis.calculateElectronRepulsionIntegrals();
+    auto g = basis.get_g();
+
+    BOOST_CHECK_THROW(basis.get_L(), std::logic_error);  // the Cholesky vectors haven't been calculated yet
+    BOOST_CHECK_THROW(basis.calculateCholeskyVectors(0.0), std::invalid_argument);
+
+    // Every element of the reconstructed integrals should have an error smaller than the threshold, and a tighter threshold should need more Cholesky vectors
+    size_t previous_rank = 0;
+    for (double threshold : {1.0e-02, 1.0e-05, 1.0e-08}) {
+        basis.calculateCholeskyVectors(threshold);
+        const auto& L = basis.get_L();
+
+        Eigen::Tensor<double, 0> max_error = (L.toDense() - g).abs().maximum();
+        BOOST_CHECK(max_error(0) < threshold);
+
+        BOOST_CHECK(L.get_rank() >= previous_rank);
+        BOOST_CHECK(L.get_rank() <= 28);  // there are 28 unique pairs for 7 basis functions
+        previous_rank = L.get_rank();
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( out_of_core_h2o_631g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    const auto& communicator = libwint::LibintCommunicator::get();
+    Eigen::Tensor<double, 4> g = communicator.calculateTwoBodyIntegrals("6-31G", water.get_atoms());
+
+    // Writing the integrals with a memory budget of a few kilobytes (i.e. in multiple chunks) and reading them back should give the same integrals, for any number of threads
+    const std::string filename = "AOBasis_test.eri";
+    for (size_t number_of_threads : {1, 4}) {
+        size_t number_of_screened_quartets = 0;
+        communicator.writeTwoBodyIntegrals("6-31G", water.get_atoms(), filename, 32768, 0.0, number_of_screened_quartets, number_of_threads);
+
+        libwint::ERIFileReader reader (filename);
+        BOOST_CHECK_EQUAL(reader.get_K(), static_cast<size_t>(g.dimension(0)));
+        BOOST_CHECK(cpputil::linalg::areEqual(reader.readTensor(), g, 1.0e-12));
+    }
+
+    // The memory budget should at least hold the largest shell quartet, and a too small one shouldn't touch the existing file
+    size_t number_of_screened_quartets = 0;
+    BOOST_CHECK_THROW(communicator.writeTwoBodyIntegrals("6-31G", water.get_atoms(), filename, 200, 0.0, number_of_screened_quartets), std::invalid_argument);
+    BOOST_CHECK(cpputil::linalg::areEqual(libwint::ERIFileReader(filename).readTensor(), g, 1.0e-12));
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE( mapped_electron_repulsion_integrals_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    libwint::AOBasis basis (water, "STO-3G");
+    BOOST_CHECK_THROW(basis.saveElectronRepulsionIntegrals("AOBasis_test.tensor"), std::logic_error);  // g hasn't been calculated yet
+
+    basis.calculateIntegrals();
+    const std::string filename = "AOBasis_test.tensor";
+    basis.saveElectronRepulsionIntegrals(filename);
+
+
+    // Another basis should map the same integrals instead of calculating them
+    libwint::AOBasis mapped_basis (water, "STO-3G");
+    mapped_basis.mapElectronRepulsionIntegrals(filename);
+
+    BOOST_CHECK(mapped_basis.is_mapped_g());
+    BOOST_CHECK(!basis.is_mapped_g());
+    BOOST_CHECK_EQUAL(mapped_basis.calculateNumberOfBasisFunctions(), 7);
+    BOOST_CHECK_THROW(mapped_basis.get_g(), std::logic_error);  // mapped integrals are only accessible through the view
+
+    Eigen::Tensor<double, 4> g_view = mapped_basis.get_g_view();
+    BOOST_CHECK(cpputil::linalg::areEqual(g_view, basis.get_g(), 1.0e-15));
+
+
+    // Saving the mapped integrals to the file they're mapped from shouldn't destroy them
+    mapped_basis.saveElectronRepulsionIntegrals(filename);
+    BOOST_CHECK(cpputil::linalg::areEqual(Eigen::Tensor<double, 4>(mapped_basis.get_g_view()), basis.get_g(), 1.0e-15));
+
+    libwint::AOBasis remapped_basis (water, "STO-3G");
+    remapped_basis.mapElectronRepulsionIntegrals(filename);
+    BOOST_CHECK(cpputil::linalg::areEqual(Eigen::Tensor<double, 4>(remapped_basis.get_g_view()), basis.get_g(), 1.0e-15));
+
+
+    // Releasing mapped integrals copies them
+    Eigen::Tensor<double, 4> g_released = mapped_basis.release_g();
+    BOOST_CHECK(!mapped_basis.is_mapped_g());
+    BOOST_CHECK(cpputil::linalg::areEqual(g_released, basis.get_g(), 1.0e-15));
+
+
+    // A tensor file of another basis can't be mapped
+    libwint::AOBasis other_basis (water, "6-31G");
+    BOOST_CHECK_THROW(other_basis.mapElectronRepulsionIntegrals(filename), std::invalid_argument);
+    BOOST_CHECK(!other_basis.is_mapped_g());
+
+    other_basis.calculateOverlapIntegrals();
+    BOOST_CHECK_THROW(other_basis.mapElectronRepulsionIntegrals(filename), std::invalid_argument);
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE( reference_accessors_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    libwint::AOBasis basis (water, "STO-3G");
+    basis.calculateIntegrals();
+
+
+    // The getters shouldn't copy the integrals
+    BOOST_CHECK_EQUAL(&basis.get_S(), &basis.get_S());
+    BOOST_CHECK_EQUAL(basis.get_g().data(), basis.get_g().data());
+    BOOST_CHECK_EQUAL(basis.get_g_view().data(), basis.get_g().data());
+
+
+    // Releasing the electron repulsion integrals moves them out of the basis
+    const double* g_data = basis.get_g().data();
+    Eigen::Tensor<double, 4> g = basis.release_g();
+
+    BOOST_CHECK_EQUAL(g.data(), g_data);
+    BOOST_CHECK_EQUAL(g.dimension(0), 7);
+    BOOST_CHECK_THROW(basis.get_g(), std::logic_error);
+    BOOST_CHECK_THROW(basis.release_g(), std::logic_error);
+    BOOST_CHECK_EQUAL(basis.calculateNumberOfBasisFunctions(), 7);  // the other integrals are still there
+}
@@ -0,0 +1,197 @@
+#define BOOST_TEST_MODULE "ERIFile"
+
+
+#include "ERIFile.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( write_read_blocks ) {
+
+    const std::string filename = "ERIFile_test.eri";
+
+    // Write 100 blocks of 2x1x3x1 values from 4 threads, with a memory budget of only a few blocks, so that many chunks are needed
+    const size_t number_of_blocks = 100;
+    const size_t block_size = libwint::ERIFileWriter::blockSize(2, 1, 3, 1);
+    {
+        libwint::ERIFileWriter writer (filename, 12, 7 * block_size);  // large enough for the blocks with p = 9 and r = 9
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; t++) {
+            threads.emplace_back([&writer, t, number_of_blocks] () {
+                for (size_t i = t; i < number_of_blocks; i += 4) {
+                    double data[6];
+                    for (size_t j = 0; j < 6; j++) {
+                        data[j] = static_cast<double>(6 * i + j);
+                    }
+                    writer.addBlock(i % 10, 0, i / 10, 1, 2, 1, 3, 1, data);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        writer.close();
+        BOOST_CHECK_THROW(writer.addBlock(0, 0, 0, 0, 1, 1, 1, 1, nullptr), std::logic_error);
+    }
+
+
+    // Every block should be read back (in some order) with its values
+    libwint::ERIFileReader reader (filename);
+    BOOST_CHECK_EQUAL(reader.get_K(), 12);
+    BOOST_CHECK_EQUAL(reader.get_number_of_blocks(), number_of_blocks);
+
+    std::vector<bool> is_read (number_of_blocks, false);
+    reader.readBlocks([&is_read] (const libwint::ERIBlock& block) {
+        BOOST_REQUIRE_EQUAL(block.n_p * block.n_q * block.n_r * block.n_s, 6);
+
+        auto i = static_cast<size_t>(block.data[0]) / 6;
+        BOOST_REQUIRE(i < is_read.size());
+        BOOST_CHECK_EQUAL(block.p, i % 10);
+        BOOST_CHECK_EQUAL(block.r, i / 10);
+        BOOST_CHECK_EQUAL(block.data[5], static_cast<double>(6 * i + 5));
+        is_read[i] = true;
+    });
+
+    for (const auto& read : is_read) {
+        BOOST_CHECK(read);
+    }
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE ( read_tensor ) {
+
+    const std::string filename = "ERIFile_test.eri";
+
+    // Write the canonical element (10|10) and check that all its permutations are filled in
+    {
+        libwint::ERIFileWriter writer (filename, 2, 1024);
+        double value = 0.5;
+        writer.addBlock(1, 0, 1, 0, 1, 1, 1, 1, &value);
+        writer.close();
+    }
+
+    Eigen::Tensor<double, 4> g = libwint::ERIFileReader(filename).readTensor();
+    BOOST_CHECK_EQUAL(g(1,0,1,0), 0.5);
+    BOOST_CHECK_EQUAL(g(0,1,0,1), 0.5);
+    BOOST_CHECK_EQUAL(g(0,1,1,0), 0.5);
+    BOOST_CHECK_EQUAL(g(0,0,0,0), 0.0);
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE ( errors ) {
+
+    const std::string filename = "ERIFile_test.eri";
+
+    // A memory budget should at least hold one block, and a too small one shouldn't touch an existing file
+    {
+        std::ofstream output_file_stream (filename);
+        output_file_stream << "existing";
+    }
+    BOOST_CHECK_THROW(libwint::ERIFileWriter (filename, 2, 8), std::invalid_argument);
+    {
+        std::ifstream input_file_stream (filename);
+        std::string content;
+        input_file_stream >> content;
+        BOOST_CHECK_EQUAL(content, "existing");
+    }
+    {
+        libwint::ERIFileWriter writer (filename, 2, 2 * libwint::ERIFileWriter::blockSize(1, 1, 1, 1));
+        double data[16] = {};
+        BOOST_CHECK_THROW(writer.addBlock(0, 0, 0, 0, 2, 2, 2, 2, data), std::invalid_argument);
+    }
+
+    // A writer that isn't closed (e.g. because the calculation failed partway) should discard its blocks instead of finishing an incomplete file
+    try {
+        libwint::ERIFileWriter writer (filename, 2, 1024);
+        double value = 1.0;
+        writer.addBlock(0, 0, 0, 0, 1, 1, 1, 1, &value);
+        throw std::runtime_error("The calculation failed.");
+    } catch (const std::runtime_error&) {}
+    {
+        std::ifstream input_file_stream (filename);
+        std::string content;
+        input_file_stream >> content;
+        BOOST_CHECK_EQUAL(content, "existing");
+    }
+    BOOST_CHECK_THROW(libwint::ERIFileReader reader (filename), std::runtime_error);
+
+    std::remove(filename.c_str());
+    {
+        libwint::ERIFileWriter writer (filename, 2, 1024);
+    }
+    BOOST_CHECK(!std::ifstream(filename).good());
+
+
+    // Files that aren't ERI files should be rejected
+    {
+        std::ofstream output_file_stream (filename);
+        output_file_stream << "This is not an ERI file, although it's long enough.";
+    }
+    BOOST_CHECK_THROW(libwint::ERIFileReader reader (filename), std::runtime_error);
+    BOOST_CHECK_THROW(libwint::ERIFileReader reader ("this_file_does_not_exist.eri"), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE ( corrupt_files ) {
+
+    const std::string filename = "ERIFile_test.eri";
+
+    // Write a valid file with two 1x1x1x1 blocks in one chunk for K = 2
+    const auto writeFile = [&filename] () {
+        libwint::ERIFileWriter writer (filename, 2, 2 * libwint::ERIFileWriter::blockSize(2, 2, 2, 2));
+        double value = 1.0;
+        writer.addBlock(0, 0, 0, 0, 1, 1, 1, 1, &value);
+        writer.addBlock(0, 0, 1, 1, 1, 1, 1, 1, &value);
+        writer.close();
+    };
+
+    // Overwrite the 64-bit word at @param: position (in bytes) of the file
+    const auto corrupt = [&filename] (long position, uint64_t word) {
+        std::fstream file_stream (filename, std::ios::binary | std::ios::in | std::ios::out);
+        file_stream.seekp(position);
+        file_stream.write(reinterpret_cast<const char*>(&word), sizeof(word));
+    };
+
+    const long chunk_header_position = 32;  // after the magic, the version, K and the number of blocks
+    const long block_header_position = chunk_header_position + 16;
+
+    writeFile();
+    BOOST_CHECK_NO_THROW(libwint::ERIFileReader (filename).readTensor());
+
+    // A chunk that is larger than the rest of the file
+    writeFile();
+    corrupt(chunk_header_position, 1000000);
+    BOOST_CHECK_THROW(libwint::ERIFileReader (filename).readTensor(), std::runtime_error);
+
+    // More blocks in a chunk than fit in it, or than there are in the file
+    writeFile();
+    corrupt(chunk_header_position + 8, 3);
+    BOOST_CHECK_THROW(libwint::ERIFileReader (filename).readTensor(), std::runtime_error);
+    writeFile();
+    corrupt(24, 1);  // the number of blocks in the file header
+    BOOST_CHECK_THROW(libwint::ERIFileReader (filename).readTensor(), std::runtime_error);
+
+    // A block that lies outside of the tensor, or whose data lies outside of the chunk
+    writeFile();
+    corrupt(block_header_position, 2);  // p = 2 >= K
+    BOOST_CHECK_THROW(libwint::ERIFileReader (filename).readTensor(), std::runtime_error);
+    writeFile();
+    corrupt(block_header_position + 72 + 4 * 8, 2);  // n_p = 2 in the last block, so p + n_p <= K, but its data doesn't fit
+    BOOST_CHECK_THROW(libwint::ERIFileReader (filename).readTensor(), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
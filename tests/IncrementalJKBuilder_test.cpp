@@ -0,0 +1,72 @@
+#define BOOST_TEST_MODULE "IncrementalJKBuilder"
+
+
+#include "IncrementalJKBuilder.hpp"
+#include "LibintCommunicator.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( incremental_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    const size_t nbf = 7;
+
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(nbf, nbf);
+    Eigen::MatrixXd D = A + A.transpose();
+
+    libwint::IncrementalJKBuilder builder (water, "STO-3G", 0.0, 3);
+
+
+    // Simulate a converging SCF procedure, in which the density changes less and less, and compare with a full build every time
+    for (size_t iteration = 0; iteration < 6; iteration++) {
+        Eigen::MatrixXd B = Eigen::MatrixXd::Random(nbf, nbf);
+        D += std::pow(10.0, -static_cast<double>(iteration)) * (B + B.transpose());
+
+        builder.update({D});
+
+        std::vector<Eigen::MatrixXd> ref_J;
+        std::vector<Eigen::MatrixXd> ref_K;
+        libwint::LibintCommunicator::get().calculateCoulombAndExchangeMatrices("STO-3G", water.get_atoms(), {D}, ref_J, ref_K);
+
+        BOOST_CHECK(builder.get_J()[0].isApprox(ref_J[0], 1.0e-10));
+        BOOST_CHECK(builder.get_K()[0].isApprox(ref_K[0], 1.0e-10));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE ( density_screening_h2o_sto3g ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    const size_t nbf = 7;
+    const double threshold = 1.0e-08;
+
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(nbf, nbf);
+    Eigen::MatrixXd D = A + A.transpose();
+
+    libwint::IncrementalJKBuilder builder (water, "STO-3G", threshold, 0);
+    builder.update({D});
+    size_t number_of_screened_quartets_full = builder.get_number_of_screened_quartets();
+
+    // A tiny density change should screen more shell quartets than the full density did
+    Eigen::MatrixXd B = Eigen::MatrixXd::Random(nbf, nbf);
+    D += 1.0e-09 * (B + B.transpose());
+    builder.update({D});
+    BOOST_CHECK(builder.get_number_of_screened_quartets() > number_of_screened_quartets_full);
+
+    // ... while the error stays of the order of the screening threshold
+    std::vector<Eigen::MatrixXd> ref_J;
+    std::vector<Eigen::MatrixXd> ref_K;
+    libwint::LibintCommunicator::get().calculateCoulombAndExchangeMatrices("STO-3G", water.get_atoms(), {D}, ref_J, ref_K);
+
+    BOOST_CHECK((builder.get_J()[0] - ref_J[0]).cwiseAbs().maxCoeff() < 1.0e-06);
+    BOOST_CHECK((builder.get_K()[0] - ref_K[0]).cwiseAbs().maxCoeff() < 1.0e-06);
+
+
+    // After a reset, the next update should be a full build again
+    builder.reset();
+    builder.update({D});
+    BOOST_CHECK(builder.get_J()[0].isApprox(ref_J[0], 1.0e-06));
+}
@@ -0,0 +1,106 @@
+#define BOOST_TEST_MODULE "IntegralCheckpoint"
+
+
+#include "IntegralCheckpoint.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( save_load ) {
+
+    const std::string filename = "IntegralCheckpoint_test.chk";
+
+    // Save some random integrals with additional data
+    const size_t K = 4;
+    Eigen::MatrixXd h = Eigen::MatrixXd::Random(K, K);
+    libwint::PackedERITensor g (K);
+    g.get_data().setRandom();
+    Eigen::MatrixXd M = Eigen::MatrixXd::Random(3, 5);
+
+    libwint::IntegralCheckpoint::save(filename, 1.25, h, g, {-0.5, 2.0}, {M, Eigen::MatrixXd()});
+
+
+    // Every section should be read back exactly
+    libwint::IntegralCheckpoint checkpoint (filename);
+
+    BOOST_CHECK_EQUAL(checkpoint.get_K(), K);
+    BOOST_CHECK_EQUAL(checkpoint.get_core_energy(), 1.25);
+    BOOST_CHECK(checkpoint.get_h() == h);
+    BOOST_CHECK(checkpoint.get_packed_g() == g.get_data());
+
+    BOOST_REQUIRE_EQUAL(checkpoint.get_scalars().size(), 2);
+    BOOST_CHECK_EQUAL(checkpoint.get_scalars()[0], -0.5);
+    BOOST_CHECK_EQUAL(checkpoint.get_scalars()[1], 2.0);
+
+    BOOST_REQUIRE_EQUAL(checkpoint.get_matrices().size(), 2);
+    BOOST_CHECK(checkpoint.get_matrices()[0] == M);
+    BOOST_CHECK_EQUAL(checkpoint.get_matrices()[1].size(), 0);
+
+
+    // Saving another (smaller) checkpoint to the same file replaces it, so the loaded checkpoint is left intact
+    libwint::IntegralCheckpoint::save(filename, 0.5, Eigen::MatrixXd::Zero(1, 1), libwint::PackedERITensor (1));
+    BOOST_CHECK(checkpoint.get_h() == h);
+    BOOST_CHECK(checkpoint.get_matrices()[0] == M);
+    BOOST_CHECK_EQUAL(libwint::IntegralCheckpoint (filename).get_K(), 1);
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE ( save_load_throws ) {
+
+    const std::string filename = "IntegralCheckpoint_test.chk";
+
+    // The dimensions of h and g should match
+    libwint::PackedERITensor g (3);
+    BOOST_CHECK_THROW(libwint::IntegralCheckpoint::save(filename, 0.0, Eigen::MatrixXd::Zero(2, 2), g), std::invalid_argument);
+
+
+    // A corrupted checkpoint file should be detected by its checksum
+    g.get_data().setConstant(0.1);
+    libwint::IntegralCheckpoint::save(filename, 0.0, Eigen::MatrixXd::Zero(3, 3), g);
+    BOOST_CHECK_NO_THROW(libwint::IntegralCheckpoint checkpoint (filename));
+
+    {
+        std::fstream file_stream (filename, std::ios::binary | std::ios::in | std::ios::out);
+        file_stream.seekp(8 * 10);
+        file_stream.put('\x7f');
+    }
+    BOOST_CHECK_THROW(libwint::IntegralCheckpoint checkpoint (filename), std::runtime_error);
+
+
+    // A crafted checkpoint file with a valid checksum, whose section sizes overflow, should be detected as well: here a 2^32 x 2^32 matrix without any elements
+    {
+        uint64_t words[9];
+        std::memcpy(words, "LWCHKPNT", 8);
+        words[1] = 1;  // the version
+        words[2] = 0;  // K
+        words[3] = 0;  // the number of scalars
+        words[4] = 1;  // the number of matrices
+        words[5] = 0;  // the core energy
+        words[6] = uint64_t(1) << 32;  // the number of rows
+        words[7] = uint64_t(1) << 32;  // the number of columns
+        words[8] = libwint::IntegralCheckpoint::checksum(words, 8);
+
+        std::ofstream output_file_stream (filename, std::ios::binary);
+        output_file_stream.write(reinterpret_cast<const char*>(words), sizeof(words));
+    }
+    BOOST_CHECK_THROW(libwint::IntegralCheckpoint checkpoint (filename), std::runtime_error);
+
+
+    // Other files can't be read as a checkpoint
+    {
+        std::ofstream output_file_stream (filename);
+        output_file_stream << "This is not a checkpoint file, but it is long enough to be one." << std::endl;
+    }
+    BOOST_CHECK_THROW(libwint::IntegralCheckpoint checkpoint (filename), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
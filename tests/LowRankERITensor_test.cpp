@@ -0,0 +1,98 @@
+#define BOOST_TEST_MODULE "LowRankERITensor"
+
+
+#include "LowRankERITensor.hpp"
+
+#include "cpputil.hpp"
+#include "transformations.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( constructor ) {
+
+    BOOST_CHECK_NO_THROW(libwint::LowRankERITensor (3, Eigen::MatrixXd::Random(5, 9)));
+    BOOST_CHECK_THROW(libwint::LowRankERITensor (3, Eigen::MatrixXd::Random(5, 8)), std::invalid_argument);
+
+    libwint::LowRankERITensor empty;
+    BOOST_CHECK_EQUAL(empty.get_K(), 0);
+    BOOST_CHECK_EQUAL(empty.get_rank(), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE ( reconstruction ) {
+
+    const size_t K = 4;
+    const size_t rank = 6;
+    Eigen::MatrixXd L = Eigen::MatrixXd::Random(rank, K * K);
+    libwint::LowRankERITensor g_low_rank (K, L);
+    BOOST_CHECK_EQUAL(g_low_rank.get_rank(), rank);
+
+    // Check the elements of the dense tensor and of a block against the explicit sum over the factors
+    Eigen::Tensor<double, 4> g = g_low_rank.toDense();
+    Eigen::Tensor<double, 4> block = g_low_rank.reconstructBlock(1, 0, 2, 1, 3, 2, 2, 3);
+
+    for (size_t p = 0; p < K; p++) {
+        for (size_t q = 0; q < K; q++) {
+            for (size_t r = 0; r < K; r++) {
+                for (size_t s = 0; s < K; s++) {
+                    double ref_value = 0.0;
+                    for (size_t P = 0; P < rank; P++) {
+                        ref_value += L(P, p + K * q) * L(P, r + K * s);
+                    }
+
+                    BOOST_REQUIRE(std::abs(g(p,q,r,s) - ref_value) < 1.0e-12);
+                    BOOST_REQUIRE(std::abs(g_low_rank(p,q,r,s) - ref_value) < 1.0e-12);
+
+                    if ((p >= 1) && (q < 2) && (r >= 2) && (s >= 1)) {
+                        BOOST_REQUIRE(std::abs(block(p-1,q,r-2,s-1) - ref_value) < 1.0e-12);
+                    }
+                }
+            }
+        }
+    }
+
+    // A block that is out of range should be rejected
+    BOOST_CHECK_THROW(g_low_rank.reconstructBlock(2, 0, 0, 0, 3, 1, 1, 1), std::invalid_argument);
+}
+
+
+BOOST_AUTO_TEST_CASE ( dense_cholesky_lih_sto6g ) {
+
+    const size_t K = 6;
+    Eigen::Tensor<double, 4> g (K, K, K, K);
+    cpputil::io::readArrayFromFile("../tests/ref_data/lih_hf_sto6g_twoint.data", g);
+
+    BOOST_CHECK_THROW(libwint::LowRankERITensor (g, 0.0), std::invalid_argument);
+
+    // Every element of the reconstructed integrals should have an error smaller than the threshold
+    for (double threshold : {1.0e-03, 1.0e-06, 1.0e-10}) {
+        libwint::LowRankERITensor g_cholesky (g, threshold);
+        BOOST_CHECK(g_cholesky.get_rank() <= K * (K + 1) / 2);
+
+        Eigen::Tensor<double, 0> max_error = (g_cholesky.toDense() - g).abs().maximum();
+        BOOST_CHECK(max_error(0) < threshold);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE ( transform_lih_sto6g ) {
+
+    const size_t K = 6;
+    Eigen::Tensor<double, 4> g (K, K, K, K);
+    cpputil::io::readArrayFromFile("../tests/ref_data/lih_hf_sto6g_twoint.data", g);
+
+    // Transforming the factors should be the same as transforming the dense integrals, also for a rectangular transformation matrix
+    Eigen::MatrixXd T = Eigen::MatrixXd::Random(K, 4);
+    libwint::LowRankERITensor g_cholesky (g, 1.0e-12);
+    g_cholesky.transform(T);
+    BOOST_CHECK_EQUAL(g_cholesky.get_K(), 4);
+
+    Eigen::Tensor<double, 4> ref_g_transformed = libwint::transformations::transformTwoElectronIntegrals(g, T);
+    Eigen::Tensor<double, 0> max_error = (g_cholesky.toDense() - ref_g_transformed).abs().maximum();
+    BOOST_CHECK(max_error(0) < 1.0e-08);
+
+    BOOST_CHECK_THROW(g_cholesky.transform(T), std::invalid_argument);  // T has 6 rows, while there are only 4 orbitals now
+}
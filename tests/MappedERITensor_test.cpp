@@ -0,0 +1,100 @@
+#define BOOST_TEST_MODULE "MappedERITensor"
+
+
+#include "MappedERITensor.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( save_map ) {
+
+    const std::string filename = "MappedERITensor_test.tensor";
+
+    // Save a tensor with distinct elements
+    const long K = 5;
+    Eigen::Tensor<double, 4> g (K, K, K, K);
+    for (long i = 0; i < g.size(); i++) {
+        g.data()[i] = 0.5 * static_cast<double>(i) - 3.0;
+    }
+    libwint::MappedERITensor::save(filename, Eigen::TensorMap<const Eigen::Tensor<double, 4>>(g.data(), g.dimensions()));
+
+
+    // The mapped tensor should have the same dimension and elements, both element-wise and through its view
+    libwint::MappedERITensor g_mapped (filename);
+    BOOST_CHECK_EQUAL(g_mapped.get_K(), 5);
+
+    auto g_view = g_mapped.get_view();
+    BOOST_CHECK_EQUAL(g_view.dimension(3), K);
+    for (long p = 0; p < K; p++) {
+        for (long q = 0; q < K; q++) {
+            for (long r = 0; r < K; r++) {
+                for (long s = 0; s < K; s++) {
+                    BOOST_REQUIRE_EQUAL(g_mapped(p, q, r, s), g(p, q, r, s));
+                    BOOST_REQUIRE_EQUAL(g_view(p, q, r, s), g(p, q, r, s));
+                }
+            }
+        }
+    }
+
+
+    // A copy shares the mapping, which stays valid after the original is gone
+    libwint::MappedERITensor* g_original = new libwint::MappedERITensor(filename);
+    libwint::MappedERITensor g_copy (*g_original);
+    delete g_original;
+    BOOST_CHECK_EQUAL(g_copy(4, 3, 2, 1), g(4, 3, 2, 1));
+
+
+    // Saving a mapped tensor to its own file replaces the file, so the existing mapping keeps its elements
+    libwint::MappedERITensor::save(filename, g_copy.get_view());
+    BOOST_CHECK_EQUAL(g_copy(4, 3, 2, 1), g(4, 3, 2, 1));
+    BOOST_CHECK_EQUAL(libwint::MappedERITensor(filename)(4, 3, 2, 1), g(4, 3, 2, 1));
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE ( save_map_throws ) {
+
+    const std::string filename = "MappedERITensor_test.tensor";
+
+    // Only rank-four tensors of equal dimensions can be saved
+    Eigen::Tensor<double, 4> g (2, 2, 3, 2);
+    g.setZero();
+    BOOST_CHECK_THROW(libwint::MappedERITensor::save(filename, Eigen::TensorMap<const Eigen::Tensor<double, 4>>(g.data(), g.dimensions())), std::invalid_argument);
+
+
+    // Files that don't exist, that aren't tensor files or that are truncated can't be mapped
+    BOOST_CHECK_THROW(libwint::MappedERITensor("this_file_does_not_exist.tensor"), std::runtime_error);
+
+    {
+        std::ofstream output_file_stream (filename);
+        output_file_stream << "This is not a tensor file." << std::endl;
+    }
+    BOOST_CHECK_THROW(libwint::MappedERITensor g_mapped (filename), std::runtime_error);
+
+    Eigen::Tensor<double, 4> h (2, 2, 2, 2);
+    h.setConstant(1.0);
+    libwint::MappedERITensor::save(filename, Eigen::TensorMap<const Eigen::Tensor<double, 4>>(h.data(), h.dimensions()));
+    {
+        std::ofstream output_file_stream (filename, std::ios::binary | std::ios::app);
+        output_file_stream.write("extra", 5);
+    }
+    BOOST_CHECK_THROW(libwint::MappedERITensor g_mapped (filename), std::runtime_error);
+
+    // ... nor can files whose dimension K makes K^4 overflow, e.g. K = 2^16 without any elements
+    {
+        std::ofstream output_file_stream (filename, std::ios::binary);
+        const uint64_t header[2] = {1, uint64_t(1) << 16};
+        output_file_stream.write("LWTENSOR", 8);
+        output_file_stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+    BOOST_CHECK_THROW(libwint::MappedERITensor g_mapped (filename), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
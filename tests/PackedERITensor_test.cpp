@@ -0,0 +1,74 @@
+#define BOOST_TEST_MODULE "PackedERITensor"
+
+
+#include "PackedERITensor.hpp"
+
+#include "cpputil.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( compound_indices ) {
+
+    // The pair index is symmetric and enumerates the pairs p >= q contiguously
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::pairIndex(0, 0), 0);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::pairIndex(1, 0), 1);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::pairIndex(1, 1), 2);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::pairIndex(3, 2), libwint::PackedERITensor::pairIndex(2, 3));
+
+    // All 8 permutationally equivalent indices should give the same compound index
+    size_t pqrs = libwint::PackedERITensor::compoundIndex(3, 1, 2, 0);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::compoundIndex(1, 3, 2, 0), pqrs);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::compoundIndex(3, 1, 0, 2), pqrs);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::compoundIndex(1, 3, 0, 2), pqrs);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::compoundIndex(2, 0, 3, 1), pqrs);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::compoundIndex(0, 2, 3, 1), pqrs);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::compoundIndex(2, 0, 1, 3), pqrs);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::compoundIndex(0, 2, 1, 3), pqrs);
+
+    // For K = 7, there are 28 pairs and 406 unique elements
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor::numberOfElements(7), 406);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor(7).size(), 406);
+    BOOST_CHECK_EQUAL(libwint::PackedERITensor().size(), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE ( dense_conversion_h2o_sto3g ) {
+
+    const size_t K = 7;
+    Eigen::Tensor<double, 4> g (K, K, K, K);
+    cpputil::io::readArrayFromFile("../tests/ref_data/h2o_sto-3g_two_electron.data", g);
+
+    libwint::PackedERITensor g_packed (g);
+    BOOST_CHECK_EQUAL(g_packed.get_K(), K);
+
+    // The element access should be compatible with the dense tensor
+    for (size_t p = 0; p < K; p++) {
+        for (size_t q = 0; q < K; q++) {
+            for (size_t r = 0; r < K; r++) {
+                for (size_t s = 0; s < K; s++) {
+                    BOOST_REQUIRE(std::abs(g_packed(p,q,r,s) - g(p,q,r,s)) < 1.0e-12);
+                }
+            }
+        }
+    }
+
+    // Converting back should give the original tensor
+    BOOST_CHECK(cpputil::linalg::areEqual(g_packed.toDense(), g, 1.0e-12));
+    BOOST_CHECK(libwint::PackedERITensor(g_packed.toDense()).isApprox(g_packed));
+
+
+    // Writing an element should write all its equivalents
+    g_packed(1,3,0,2) = 42.0;
+    BOOST_CHECK_EQUAL(g_packed(2,0,3,1), 42.0);
+    BOOST_CHECK(!g_packed.isApprox(libwint::PackedERITensor(g)));
+}
+
+
+BOOST_AUTO_TEST_CASE ( dense_conversion_throws ) {
+
+    Eigen::Tensor<double, 4> g (2, 2, 3, 2);
+    BOOST_CHECK_THROW(libwint::PackedERITensor packed (g), std::invalid_argument);
+}
@@ -7,6 +7,10 @@
 
 #include <cpputil.hpp>
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
 #include <boost/test/unit_test.hpp>
 #include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise clang++ will complain
 
@@ -48,6 +52,83 @@ BOOST_AUTO_TEST_CASE ( transform_jacobi ) {
 }
 
 
+BOOST_AUTO_TEST_CASE ( rotate_jacobi_sequence ) {
+
+    libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+
+    // A short sequence is applied in place, a long one by one transformation. Both should be the same as applying the rotations one by one
+    for (size_t number_of_rotations : {5, 100}) {
+        std::vector<libwint::transformations::JacobiRotationParameters> rotations;
+        for (size_t i = 0; i < number_of_rotations; i++) {
+            size_t p = (3 * i) % 15;
+            size_t q = p + 1 + (i % (15 - p));
+            rotations.push_back({p, q, 0.01 * static_cast<double>(i) - 0.3});
+        }
+
+        libwint::SOBasis sequential_so_basis (16);
+        sequential_so_basis.copy(so_basis);
+        for (const auto& rotation : rotations) {
+            sequential_so_basis.rotateJacobi(rotation.p, rotation.q, rotation.angle);
+        }
+
+        libwint::SOBasis rotated_so_basis (16);
+        rotated_so_basis.copy(so_basis);
+        rotated_so_basis.rotateJacobi(rotations);
+
+        BOOST_CHECK(rotated_so_basis.get_h_SO().isApprox(sequential_so_basis.get_h_SO(), 1.0e-10));
+        BOOST_CHECK(cpputil::linalg::areEqual(rotated_so_basis.get_g_SO(), sequential_so_basis.get_g_SO(), 1.0e-10));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE ( active_space_constructor ) {
+
+    libwint::Molecule water ("../tests/ref_data/h2o.xyz");  // the relative path to the input .xyz-file w.r.t. the out-of-source build directory
+    libwint::AOBasis ao_basis (water, "STO-3G");
+    ao_basis.calculateIntegrals();
+    size_t K = ao_basis.calculateNumberOfBasisFunctions();
+
+    // Use some (non-orthogonal) orbitals, of which the first two are frozen and the next three are active
+    Eigen::MatrixXd C = Eigen::MatrixXd::Random(K, K);
+    libwint::SOBasis so_basis (ao_basis, C);
+    libwint::SOBasis active_so_basis (ao_basis, C.leftCols(2), C.middleCols(2, 3));
+
+    BOOST_CHECK_EQUAL(active_so_basis.get_K(), 3);
+
+
+    // The frozen-core quantities should be the ones in the full SO basis: h_tu + sum_i [2 (tu|ii) - (ti|iu)], sum_i 2 h_ii + sum_ij [2 (ii|jj) - (ij|ji)] and (tu|vw)
+    double ref_core_energy = 0.0;
+    for (size_t i = 0; i < 2; i++) {
+        ref_core_energy += 2 * so_basis.get_h_SO(i,i);
+        for (size_t j = 0; j < 2; j++) {
+            ref_core_energy += 2 * so_basis.get_g_SO(i,i,j,j) - so_basis.get_g_SO(i,j,j,i);
+        }
+    }
+    BOOST_CHECK(std::abs(active_so_basis.get_core_energy() - ref_core_energy) < 1.0e-10 * std::max(1.0, std::abs(ref_core_energy)));
+
+    for (size_t t = 0; t < 3; t++) {
+        for (size_t u = 0; u < 3; u++) {
+            double ref_h = so_basis.get_h_SO(t+2,u+2);
+            for (size_t i = 0; i < 2; i++) {
+                ref_h += 2 * so_basis.get_g_SO(t+2,u+2,i,i) - so_basis.get_g_SO(t+2,i,i,u+2);
+            }
+            BOOST_CHECK(std::abs(active_so_basis.get_h_SO(t,u) - ref_h) < 1.0e-10 * std::max(1.0, std::abs(ref_h)));
+
+            for (size_t v = 0; v < 3; v++) {
+                for (size_t w = 0; w < 3; w++) {
+                    double ref_g = so_basis.get_g_SO(t+2,u+2,v+2,w+2);
+                    BOOST_CHECK(std::abs(active_so_basis.get_g_SO(t,u,v,w) - ref_g) < 1.0e-10 * std::max(1.0, std::abs(ref_g)));
+                }
+            }
+        }
+    }
+
+
+    // The coefficient matrices should belong to the AO basis
+    BOOST_CHECK_THROW(libwint::SOBasis (ao_basis, Eigen::MatrixXd::Random(K + 1, 2), Eigen::MatrixXd::Random(K + 1, 3)), std::invalid_argument);
+}
+
+
 BOOST_AUTO_TEST_CASE ( fcidump_constructor ) {
 
     libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
@@ -91,10 +172,278 @@ BOOST_AUTO_TEST_CASE ( fcidump_constructor_horton ) {
     BOOST_CHECK(std::abs(g_SO(6,5,1,0) - 0.0533584656) <  1.0e-7);
 }
 
+BOOST_AUTO_TEST_CASE ( fcidump_index_patterns ) {
+
+    const std::string filename = "SOBasis_test_patterns.FCIDUMP";
+    auto write_fcidump = [&filename] (const std::string& integral_lines) {
+        std::ofstream output_file_stream (filename);
+        output_file_stream << " &FCI NORB=2,NELEC=2,MS2=0,\n  ORBSYM=1,1,\n  ISYM=1,\n &END\n" << integral_lines;
+    };
+
+    // The core energy (0 0 0 0), the orbital energies (i 0 0 0), the one-electron integrals (i a 0 0) and the two-electron integrals (i a j b) should be read
+    write_fcidump("  0.5  1  2  2  1\n  0.25  2  1  0  0\n  -1.5  1  0  0  0\n  3.0  0  0  0  0\n");
+    libwint::SOBasis so_basis (filename, 2);
+    BOOST_CHECK_EQUAL(so_basis.get_core_energy(), 3.0);
+    BOOST_CHECK_EQUAL(so_basis.get_h_SO(0, 1), 0.25);
+    BOOST_CHECK_EQUAL(so_basis.get_h_SO(1, 0), 0.25);
+    BOOST_CHECK_EQUAL(so_basis.get_h_SO(0, 0), 0.0);
+    BOOST_CHECK_EQUAL(so_basis.get_g_SO(0, 1, 1, 0), 0.5);
+    BOOST_CHECK_EQUAL(so_basis.get_g_SO(1, 0, 0, 1), 0.5);
+
+    // Any other pattern of zero indices is illegible, and should be reported with its line number
+    for (const char* illegible_line : {"  0.5  0  2  0  0\n", "  0.5  1  0  2  2\n", "  0.5  0  0  1  1\n", "  0.5  1  1  1  0\n", "  0.5  1  1  0  2\n", "  0.5  0  0  0  1\n"}) {
+        write_fcidump(std::string("  0.5  1  1  1  1\n") + illegible_line);
+        BOOST_CHECK_EXCEPTION(libwint::SOBasis (filename, 2), std::runtime_error, [] (const std::runtime_error& e) {
+            return std::string(e.what()).find("Line 6 ") != std::string::npos;
+        });
+    }
+
+    std::remove(filename.c_str());
+}
+
 BOOST_AUTO_TEST_CASE ( get_NO ) {
 
     // Check the same reference value as horton does
     libwint::SOBasis so_basis ("../tests/ref_data/h2_psi4_horton.FCIDUMP", 10);
     Eigen::Tensor<double, 4> g_SO = so_basis.get_g_SO();
     BOOST_CHECK(std::abs(g_SO(6,5,1,0) - 0.0533584656) <  1.0e-7);
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE ( thc_factorization ) {
+
+    libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+    Eigen::Tensor<double, 4> g_SO = so_basis.get_g_SO();
+
+    // The THC error should follow the threshold
+    for (double threshold : {1.0e-04, 1.0e-06}) {
+        auto report = so_basis.calculateTHCFactorization(threshold).validate(g_SO);
+
+        BOOST_CHECK(report.max_error < 10 * threshold);
+        BOOST_CHECK(report.rms_error < threshold);
+        BOOST_CHECK(report.number_of_points <= 16 * 17 / 2);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE ( mapped_two_electron_integrals ) {
+
+    libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+    const std::string filename = "SOBasis_test.tensor";
+    so_basis.saveTwoElectronIntegrals(filename);
+
+
+    // A mapped SO basis should give the same integrals
+    libwint::SOBasis mapped_so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+    mapped_so_basis.mapTwoElectronIntegrals(filename);
+
+    BOOST_CHECK(mapped_so_basis.is_mapped_g_SO());
+    BOOST_CHECK_THROW(mapped_so_basis.get_g_SO(), std::logic_error);  // mapped integrals are only accessible through the view
+    BOOST_CHECK(std::abs(mapped_so_basis.get_g_SO(7,7,2,1) - (-0.031278)) < 1.0e-6);
+
+    Eigen::Tensor<double, 4> g_view = mapped_so_basis.get_g_SO_view();
+    BOOST_CHECK(cpputil::linalg::areEqual(g_view, so_basis.get_g_SO(), 1.0e-15));
+
+
+    // Rotating a mapped SO basis copies the integrals onto the heap, leaving the file untouched
+    so_basis.rotateJacobi(2, 5, 0.3);
+    mapped_so_basis.rotateJacobi(2, 5, 0.3);
+
+    BOOST_CHECK(!mapped_so_basis.is_mapped_g_SO());
+    BOOST_CHECK(cpputil::linalg::areEqual(mapped_so_basis.get_g_SO(), so_basis.get_g_SO(), 1.0e-12));
+
+    libwint::SOBasis remapped_so_basis (16);
+    remapped_so_basis.mapTwoElectronIntegrals(filename);
+    BOOST_CHECK(std::abs(remapped_so_basis.get_g_SO(7,7,2,1) - (-0.031278)) < 1.0e-6);
+
+
+    // The dimension of the tensor file should match
+    libwint::SOBasis other_so_basis (10);
+    BOOST_CHECK_THROW(other_so_basis.mapTwoElectronIntegrals(filename), std::invalid_argument);
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE ( reference_accessors ) {
+
+    libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+    const Eigen::MatrixXd h_SO = so_basis.get_h_SO();
+    const Eigen::Tensor<double, 4> g_SO = so_basis.get_g_SO();
+
+
+    // The getter of the two-electron integrals shouldn't copy them
+    BOOST_CHECK_EQUAL(so_basis.get_g_SO().data(), so_basis.get_g_SO().data());
+    BOOST_CHECK_EQUAL(so_basis.get_g_SO_view().data(), so_basis.get_g_SO().data());
+
+
+    // Releasing the integrals moves them out of the basis
+    const double* g_SO_data = so_basis.get_g_SO().data();
+    Eigen::Tensor<double, 4> g_SO_released = so_basis.release_g_SO();
+    Eigen::MatrixXd h_SO_released = so_basis.release_h_SO();
+
+    BOOST_CHECK_EQUAL(g_SO_released.data(), g_SO_data);
+    BOOST_CHECK(cpputil::linalg::areEqual(g_SO_released, g_SO, 0.0));
+    BOOST_CHECK(h_SO_released == h_SO);
+    BOOST_CHECK_EQUAL(so_basis.get_g_SO().size(), 0);
+    BOOST_CHECK_EQUAL(so_basis.get_h_SO().size(), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE ( checkpoint ) {
+
+    libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+    BOOST_CHECK(std::abs(so_basis.get_core_energy() - 1.5900757460937498) < 1.0e-12);
+
+    const std::string filename = "SOBasis_test.chk";
+    so_basis.saveCheckpoint(filename);
+
+
+    // Loading the checkpoint should give exactly the same integrals as parsing the FCIDUMP file
+    libwint::SOBasis loaded_so_basis (16);
+    loaded_so_basis.loadCheckpoint(filename);
+
+    BOOST_CHECK_EQUAL(loaded_so_basis.get_core_energy(), so_basis.get_core_energy());
+    BOOST_CHECK(loaded_so_basis.get_h_SO() == so_basis.get_h_SO());
+    BOOST_CHECK(cpputil::linalg::areEqual(loaded_so_basis.get_g_SO(), so_basis.get_g_SO(), 0.0));
+
+
+    // The number of orbitals should match
+    libwint::SOBasis other_so_basis (10);
+    BOOST_CHECK_THROW(other_so_basis.loadCheckpoint(filename), std::invalid_argument);
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE ( parse_statistics ) {
+
+    // The parser should report how much it parsed
+    libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+    const auto& statistics = so_basis.get_parse_statistics();
+
+    BOOST_CHECK_EQUAL(statistics.number_of_lines, 9457);
+    BOOST_CHECK(statistics.number_of_bytes > 9457 * 30);
+    BOOST_CHECK(statistics.throughput() > 0.0);
+
+
+    // The .one and .two files, which have D exponents, are parsed in the same way
+    libwint::SOBasis so_basis_one_two ("../tests/ref_data/no_0.5_PB", 10, false);
+    BOOST_CHECK_EQUAL(so_basis_one_two.get_parse_statistics().number_of_lines, 100 + 10000);
+    BOOST_CHECK_EQUAL(so_basis_one_two.get_h_SO(0,0), -46.32994162);
+    BOOST_CHECK_EQUAL(so_basis_one_two.get_g_SO(0,0,0,0), 3.818211006);
+}
+
+
+BOOST_AUTO_TEST_CASE ( parallel_parsing ) {
+
+    // Parsing the .one and .two files on multiple threads (i.e. in multiple chunks) should give exactly the same integrals as parsing them on one thread
+    setenv("LIBWINT_NUM_THREADS", "1", 1);
+    libwint::SOBasis serial_so_basis ("../tests/ref_data/no_0.5_PB", 10, false);
+
+    setenv("LIBWINT_NUM_THREADS", "4", 1);
+    libwint::SOBasis parallel_so_basis ("../tests/ref_data/no_0.5_PB", 10, false);
+
+    BOOST_CHECK(parallel_so_basis.get_h_SO() == serial_so_basis.get_h_SO());
+    BOOST_CHECK(cpputil::linalg::areEqual(parallel_so_basis.get_g_SO(), serial_so_basis.get_g_SO(), 0.0));
+    BOOST_CHECK_EQUAL(parallel_so_basis.get_parse_statistics().number_of_lines, serial_so_basis.get_parse_statistics().number_of_lines);
+
+
+    // An illegible line should be reported with its line number in the whole file, regardless of the chunk it's in
+    {
+        std::ifstream input_file_stream ("../tests/ref_data/no_0.5_PB.two");
+        std::ofstream output_file_stream ("SOBasis_test_illegible.two");
+        std::string line;
+        for (size_t line_number = 1; std::getline(input_file_stream, line); line_number++) {
+            output_file_stream << ((line_number == 7654) ? "  1   2   3   oops" : line) << std::endl;
+        }
+    }
+    {
+        std::ifstream input_file_stream ("../tests/ref_data/no_0.5_PB.one");
+        std::ofstream output_file_stream ("SOBasis_test_illegible.one");
+        output_file_stream << input_file_stream.rdbuf();
+    }
+
+    BOOST_CHECK_EXCEPTION(libwint::SOBasis ("SOBasis_test_illegible", 10, false), std::runtime_error, [] (const std::runtime_error& e) {
+        return std::string(e.what()).find("Line 7654 ") != std::string::npos;
+    });
+
+    unsetenv("LIBWINT_NUM_THREADS");
+    std::remove("SOBasis_test_illegible.one");
+    std::remove("SOBasis_test_illegible.two");
+}
+
+
+BOOST_AUTO_TEST_CASE ( compressed_files ) {
+
+    // Parsing gzip-compressed files should give exactly the same integrals as parsing the plain files
+    if (libwint::io::isSupported(libwint::io::Compression::gzip)) {
+        libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+        libwint::SOBasis compressed_so_basis ("../tests/ref_data/beh_cation_631g_caitlin_gz.FCIDUMP.gz", 16);
+
+        BOOST_CHECK(compressed_so_basis.get_h_SO() == so_basis.get_h_SO());
+        BOOST_CHECK(cpputil::linalg::areEqual(compressed_so_basis.get_g_SO(), so_basis.get_g_SO(), 0.0));
+        BOOST_CHECK_EQUAL(compressed_so_basis.get_core_energy(), so_basis.get_core_energy());
+        BOOST_CHECK_EQUAL(compressed_so_basis.get_parse_statistics().number_of_lines, so_basis.get_parse_statistics().number_of_lines);
+        BOOST_CHECK_EQUAL(compressed_so_basis.get_parse_statistics().number_of_bytes, so_basis.get_parse_statistics().number_of_bytes);
+
+
+        // The .one.gz and .two.gz files are found if there are no .one and .two files
+        libwint::SOBasis so_basis_one_two ("../tests/ref_data/no_0.5_PB", 10, false);
+        libwint::SOBasis compressed_so_basis_one_two ("../tests/ref_data/no_0.5_PB_gz", 10, false);
+
+        BOOST_CHECK(compressed_so_basis_one_two.get_h_SO() == so_basis_one_two.get_h_SO());
+        BOOST_CHECK(cpputil::linalg::areEqual(compressed_so_basis_one_two.get_g_SO(), so_basis_one_two.get_g_SO(), 0.0));
+    } else {
+        BOOST_CHECK_THROW(libwint::SOBasis ("../tests/ref_data/beh_cation_631g_caitlin_gz.FCIDUMP.gz", 16), std::runtime_error);
+    }
+
+
+    // The same goes for zstd-compressed files
+    if (libwint::io::isSupported(libwint::io::Compression::zstd)) {
+        libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+        libwint::SOBasis compressed_so_basis ("../tests/ref_data/beh_cation_631g_caitlin_zst.FCIDUMP.zst", 16);
+
+        BOOST_CHECK(compressed_so_basis.get_h_SO() == so_basis.get_h_SO());
+        BOOST_CHECK(cpputil::linalg::areEqual(compressed_so_basis.get_g_SO(), so_basis.get_g_SO(), 0.0));
+        BOOST_CHECK_EQUAL(compressed_so_basis.get_core_energy(), so_basis.get_core_energy());
+
+
+        // The .one.zst and .two.zst files are found if there are no .one and .two files
+        libwint::SOBasis so_basis_one_two ("../tests/ref_data/no_0.5_PB", 10, false);
+        libwint::SOBasis compressed_so_basis_one_two ("../tests/ref_data/no_0.5_PB_zst", 10, false);
+
+        BOOST_CHECK(compressed_so_basis_one_two.get_h_SO() == so_basis_one_two.get_h_SO());
+        BOOST_CHECK(cpputil::linalg::areEqual(compressed_so_basis_one_two.get_g_SO(), so_basis_one_two.get_g_SO(), 0.0));
+    } else {
+        BOOST_CHECK_THROW(libwint::SOBasis ("../tests/ref_data/beh_cation_631g_caitlin_zst.FCIDUMP.zst", 16), std::runtime_error);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE ( write_fcidump ) {
+
+    libwint::SOBasis so_basis ("../tests/ref_data/beh_cation_631g_caitlin.FCIDUMP", 16);
+    so_basis.rotateJacobi(2, 5, 0.3);  // write something that didn't come from a file
+
+    // Writing and reading an FCIDUMP file should give back exactly the same integrals
+    const std::string filename = "SOBasis_test.FCIDUMP";
+    so_basis.writeFCIDUMPFile(filename, 4);
+
+    libwint::SOBasis read_so_basis (filename, 16);
+    BOOST_CHECK_EQUAL(read_so_basis.get_core_energy(), so_basis.get_core_energy());
+    BOOST_CHECK(read_so_basis.get_h_SO() == so_basis.get_h_SO());
+    BOOST_CHECK(cpputil::linalg::areEqual(read_so_basis.get_g_SO(), so_basis.get_g_SO(), 1.0e-15));
+
+    // Only the unique integrals (and the core energy) are written
+    size_t number_of_pairs = 16 * 17 / 2;
+    BOOST_CHECK(read_so_basis.get_parse_statistics().number_of_lines <= 4 + number_of_pairs * (number_of_pairs + 1) / 2 + number_of_pairs + 1);
+
+
+    // Integrals below the threshold are left out
+    so_basis.writeFCIDUMPFile(filename, 4, 1.0e-02);
+    libwint::SOBasis screened_so_basis (filename, 16);
+    BOOST_CHECK(screened_so_basis.get_parse_statistics().number_of_lines < read_so_basis.get_parse_statistics().number_of_lines);
+    BOOST_CHECK(cpputil::linalg::areEqual(screened_so_basis.get_g_SO(), so_basis.get_g_SO(), 1.0e-02));
+
+    std::remove(filename.c_str());
+}
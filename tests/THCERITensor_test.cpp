@@ -0,0 +1,84 @@
+#define BOOST_TEST_MODULE "THCERITensor"
+
+
+#include "THCERITensor.hpp"
+
+#include "cpputil.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( constructor ) {
+
+    BOOST_CHECK_NO_THROW(libwint::THCERITensor (Eigen::MatrixXd::Random(4, 3), Eigen::MatrixXd::Random(3, 3)));
+    BOOST_CHECK_THROW(libwint::THCERITensor (Eigen::MatrixXd::Random(4, 3), Eigen::MatrixXd::Random(4, 4)), std::invalid_argument);
+    BOOST_CHECK_THROW(libwint::THCERITensor (libwint::LowRankERITensor(), 0.0), std::invalid_argument);
+}
+
+
+BOOST_AUTO_TEST_CASE ( reconstruction ) {
+
+    const size_t K = 4;
+    const size_t number_of_points = 5;
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(K, number_of_points);
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(number_of_points, number_of_points);
+    Eigen::MatrixXd Z = A + A.transpose();
+    libwint::THCERITensor g_thc (X, Z);
+
+    // Check the elements of the dense tensor and of a block against the explicit sum over the points
+    Eigen::Tensor<double, 4> g = g_thc.toDense();
+    Eigen::Tensor<double, 4> block = g_thc.reconstructBlock(1, 0, 2, 1, 3, 2, 2, 3);
+
+    for (size_t p = 0; p < K; p++) {
+        for (size_t q = 0; q < K; q++) {
+            for (size_t r = 0; r < K; r++) {
+                for (size_t s = 0; s < K; s++) {
+                    double ref_value = 0.0;
+                    for (size_t P = 0; P < number_of_points; P++) {
+                        for (size_t Q = 0; Q < number_of_points; Q++) {
+                            ref_value += X(p,P) * X(q,P) * Z(P,Q) * X(r,Q) * X(s,Q);
+                        }
+                    }
+
+                    BOOST_REQUIRE(std::abs(g(p,q,r,s) - ref_value) < 1.0e-12);
+                    BOOST_REQUIRE(std::abs(g_thc(p,q,r,s) - ref_value) < 1.0e-12);
+
+                    if ((p >= 1) && (q < 2) && (r >= 2) && (s >= 1)) {
+                        BOOST_REQUIRE(std::abs(block(p-1,q,r-2,s-1) - ref_value) < 1.0e-12);
+                    }
+                }
+            }
+        }
+    }
+
+    // The validation against the reconstructed tensor itself should give no errors
+    auto report = g_thc.validate(g);
+    BOOST_CHECK_EQUAL(report.number_of_points, number_of_points);
+    BOOST_CHECK(report.max_error < 1.0e-12);
+    BOOST_CHECK(report.rms_error < 1.0e-12);
+}
+
+
+BOOST_AUTO_TEST_CASE ( least_squares_fit_lih_sto6g ) {
+
+    const size_t K = 6;
+    Eigen::Tensor<double, 4> g (K, K, K, K);
+    cpputil::io::readArrayFromFile("../tests/ref_data/lih_hf_sto6g_twoint.data", g);
+    libwint::LowRankERITensor g_cholesky (g, 1.0e-10);
+
+    // A tight threshold should reproduce the integrals, a loose one should need fewer points
+    libwint::THCERITensor g_thc (g_cholesky, 1.0e-08);
+    auto report = g_thc.validate(g);
+    BOOST_CHECK(report.max_error < 1.0e-06);
+    BOOST_CHECK(report.rms_error <= report.max_error);
+
+    libwint::THCERITensor g_thc_loose (g_cholesky, 1.0e-02);
+    BOOST_CHECK(g_thc_loose.get_number_of_points() <= g_thc.get_number_of_points());
+    BOOST_CHECK(g_thc_loose.validate(g).rms_error >= report.rms_error);
+
+    // The number of points can be limited
+    libwint::THCERITensor g_thc_limited (g_cholesky, 1.0e-08, 4);
+    BOOST_CHECK_EQUAL(g_thc_limited.get_number_of_points(), 4);
+}
@@ -0,0 +1,76 @@
+#define BOOST_TEST_MODULE "TaskScheduler"
+
+
+#include "TaskScheduler.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise clang++ will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( run_all_tasks ) {
+
+    // Make some tasks with very different costs, and check if every task is run exactly once
+    size_t number_of_tasks = 1000;
+    size_t number_of_threads = 4;
+    std::vector<std::atomic<size_t>> runs (number_of_tasks);
+    for (auto& run : runs) {
+        run = 0;
+    }
+    std::atomic<size_t> invalid_thread_ids (0);  // Boost.Test isn't thread-safe, so we'll check inside the tasks ourselves
+
+    libwint::TaskScheduler scheduler;
+    for (size_t i = 0; i < number_of_tasks; i++) {
+        double cost = static_cast<double>((i % 10) * (i % 10) * (i % 10));
+        scheduler.addTask(cost, [&runs, &invalid_thread_ids, i, number_of_threads] (size_t thread_id) {
+            if (thread_id >= number_of_threads) {
+                invalid_thread_ids++;
+            }
+            runs[i]++;
+        });
+    }
+    BOOST_CHECK_EQUAL(scheduler.numberOfTasks(), number_of_tasks);
+
+    scheduler.run(number_of_threads);
+
+    for (const auto& run : runs) {
+        BOOST_CHECK_EQUAL(run, 1);
+    }
+    BOOST_CHECK_EQUAL(invalid_thread_ids, 0);
+    BOOST_CHECK_EQUAL(scheduler.numberOfTasks(), 0);
+
+
+    // The statistics should account for all the tasks
+    const auto& statistics = scheduler.get_statistics();
+    BOOST_REQUIRE_EQUAL(statistics.size(), number_of_threads);
+
+    size_t total_number_of_tasks = 0;
+    for (const auto& thread_statistics : statistics) {
+        total_number_of_tasks += thread_statistics.number_of_tasks;
+        BOOST_CHECK(thread_statistics.number_of_stolen_tasks <= thread_statistics.number_of_tasks);
+        BOOST_CHECK(thread_statistics.busy_time >= 0.0);
+        BOOST_CHECK(thread_statistics.idle_time >= 0.0);
+    }
+    BOOST_CHECK_EQUAL(total_number_of_tasks, number_of_tasks);
+}
+
+
+BOOST_AUTO_TEST_CASE ( task_exception ) {
+
+    libwint::TaskScheduler scheduler;
+    for (size_t i = 0; i < 10; i++) {
+        scheduler.addTask(1.0, [i] (size_t) {
+            if (i == 5) {
+                throw std::runtime_error("task 5 failed");
+            }
+        });
+    }
+
+    // The exception should reach the caller, and the scheduler should be empty afterwards
+    BOOST_CHECK_THROW(scheduler.run(2), std::runtime_error);
+    BOOST_CHECK_EQUAL(scheduler.numberOfTasks(), 0);
+}
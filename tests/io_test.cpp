@@ -0,0 +1,331 @@
+#define BOOST_TEST_MODULE "io"
+
+
+#include "io.hpp"
+
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <string>
+
+#include <sys/resource.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise the compiler will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( parse_double ) {
+
+    // Check some typical formats, including Fortran's D exponents
+    std::vector<std::pair<std::string, double>> cases = {
+        {"0", 0.0}, {"-0.0", -0.0}, {"42", 42.0}, {"+3.5", 3.5}, {".25", 0.25}, {"7.", 7.0},
+        {"2.2799043576763789e+00", 2.2799043576763789}, {"-0.1579120600146539E+00", -0.1579120600146539},
+        {"0.3818211006D+01", 3.818211006}, {"-0.7566880122d-03", -0.7566880122e-03}, {"5.16622e-18", 5.16622e-18},
+        {"1e308", 1e308}, {"4.9406564584124654e-324", 4.9406564584124654e-324}, {"123456789012345678901234567890", 123456789012345678901234567890.0}
+    };
+
+    for (const auto& c : cases) {
+        double value = -1.0;
+        const char* begin = c.first.c_str();
+        const char* end = begin + c.first.size();
+
+        BOOST_CHECK_EQUAL(libwint::io::parseDouble(begin, end, value), end);
+        BOOST_CHECK_EQUAL(value, c.second);
+        BOOST_CHECK_EQUAL(std::signbit(value), std::signbit(c.second));
+    }
+
+
+    // The parsing stops at the first character that isn't part of the number
+    const std::string text = "1.5D+00   2";
+    double value;
+    BOOST_CHECK_EQUAL(libwint::io::parseDouble(text.c_str(), text.c_str() + text.size(), value), text.c_str() + 7);
+    BOOST_CHECK_EQUAL(value, 1.5);
+
+
+    // Things that aren't numbers
+    for (const char* c : {"", "-", ".", "abc", "1.0e", "1.0D+"}) {
+        BOOST_CHECK(libwint::io::parseDouble(c, c + std::strlen(c), value) == nullptr);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE ( parse_double_correctly_rounded ) {
+
+    // Printing random doubles with 17 significant digits (like FCIDUMP files) should give back exactly the same doubles, just like std::strtod does
+    std::mt19937_64 generator (12345);
+    std::uniform_real_distribution<double> mantissa_distribution (-1.0, 1.0);
+    std::uniform_int_distribution<int> exponent_distribution (-30, 5);
+
+    char buffer[64];
+    for (size_t i = 0; i < 100000; i++) {
+        double x = std::ldexp(mantissa_distribution(generator), 3 * exponent_distribution(generator));
+        int length = std::snprintf(buffer, sizeof(buffer), (i % 2 == 0) ? "%.16e" : "%.10E", x);
+
+        double value;
+        libwint::io::parseDouble(buffer, buffer + length, value);
+        BOOST_REQUIRE_EQUAL(value, std::strtod(buffer, nullptr));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE ( scanner ) {
+
+    const std::string text = "  1   2   -0.4632994162D+02\r\n\n  3 4 0.5\n7";
+    libwint::io::Scanner scanner (text.c_str(), text.c_str() + text.size());
+
+    size_t p, q;
+    double x;
+    BOOST_CHECK(scanner.readIndex(p) && scanner.readIndex(q) && scanner.readDouble(x));
+    BOOST_CHECK_EQUAL(p, 1);
+    BOOST_CHECK_EQUAL(q, 2);
+    BOOST_CHECK_EQUAL(x, -46.32994162);
+
+    scanner.skipBlanks();
+    BOOST_CHECK(scanner.atEndOfLine());
+    scanner.skipLine();
+    BOOST_CHECK(scanner.atEndOfLine());  // an empty line
+    scanner.skipLine();
+    BOOST_CHECK_EQUAL(scanner.get_line_number(), 3);
+
+    BOOST_CHECK(scanner.readIndex(p) && scanner.readIndex(q) && scanner.readDouble(x));
+    BOOST_CHECK_EQUAL(x, 0.5);
+    BOOST_CHECK(!scanner.readIndex(p));  // at the end of the line
+    scanner.skipLine();
+
+    BOOST_CHECK(scanner.readIndex(p));
+    BOOST_CHECK_EQUAL(p, 7);
+    BOOST_CHECK(scanner.atEnd());
+
+
+    // An index that overflows a size_t shouldn't wrap around to a valid one
+    const std::string overflowing_index = "18446744073709551617";
+    BOOST_CHECK(libwint::io::parseIndex(overflowing_index.c_str(), overflowing_index.c_str() + overflowing_index.size(), p) == nullptr);
+}
+
+
+BOOST_AUTO_TEST_CASE ( split_at_newlines ) {
+
+    const std::string text = "first line\nsecond\n\nfourth line is longer\nlast";
+    const char* begin = text.c_str();
+    const char* end = begin + text.size();
+
+    // Every chunk should consist of whole lines, and all the chunks together should be the whole text
+    for (size_t chunk_size : {1, 5, 11, 20, 100}) {
+        auto boundaries = libwint::io::splitAtNewlines(begin, end, chunk_size);
+
+        BOOST_REQUIRE(boundaries.size() >= 2);
+        BOOST_CHECK_EQUAL(boundaries.front(), begin);
+        BOOST_CHECK_EQUAL(boundaries.back(), end);
+        for (size_t i = 1; i < boundaries.size() - 1; i++) {
+            BOOST_CHECK(boundaries[i] > boundaries[i-1]);
+            BOOST_CHECK_EQUAL(*(boundaries[i] - 1), '\n');
+        }
+    }
+
+    BOOST_CHECK_EQUAL(libwint::io::splitAtNewlines(begin, end, 100).size(), 2);
+    BOOST_CHECK_EQUAL(libwint::io::splitAtNewlines(begin, end, 1).size(), 5);  // the empty line is joined with the next line
+    BOOST_CHECK_THROW(libwint::io::splitAtNewlines(begin, end, 0), std::invalid_argument);
+}
+
+
+BOOST_AUTO_TEST_CASE ( format_double ) {
+
+    char buffer[32];
+
+    // Some values should be formatted exactly like printf's %.16e
+    for (double x : {1.0, -2.2799043576763789, 0.1, 1.0e-20, 5.16622e-18, -123456.789, 1.0e300, 0.0, -0.0}) {
+        char reference[32];
+        std::snprintf(reference, sizeof(reference), "%.16e", x);
+
+        size_t length = libwint::io::formatDouble(x, buffer);
+        BOOST_CHECK_EQUAL(std::string(buffer, length), std::string(reference));
+    }
+
+
+    // Formatting random doubles should give the same text as printf, which parses back to exactly the same doubles
+    std::mt19937_64 generator (54321);
+    std::uniform_int_distribution<uint64_t> bits_distribution;
+    for (size_t i = 0; i < 100000; i++) {
+        uint64_t bits = bits_distribution(generator);
+        double x;
+        std::memcpy(&x, &bits, sizeof(x));
+        if (!std::isfinite(x)) {
+            continue;
+        }
+
+        size_t length = libwint::io::formatDouble(x, buffer);
+        BOOST_REQUIRE_EQUAL(std::strtod(std::string(buffer, length).c_str(), nullptr), x);
+
+        char reference[32];
+        std::snprintf(reference, sizeof(reference), "%.16e", x);
+        BOOST_REQUIRE_EQUAL(std::string(buffer, length), std::string(reference));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE ( buffered_writer ) {
+
+    const std::string filename = "io_test.txt";
+
+    // Write more than the (small) buffer holds
+    std::ostringstream reference;
+    {
+        libwint::io::BufferedWriter writer (filename, 100);
+        for (size_t i = 0; i < 50; i++) {
+            writer.writeDouble(0.5 * static_cast<double>(i), 25);
+            writer.writeIndex(i, 5);
+            writer.write("\n");
+
+            char line[64];
+            std::snprintf(line, sizeof(line), "%25.16e%5zu\n", 0.5 * static_cast<double>(i), i);
+            reference << line;
+        }
+        writer.write(std::string(300, 'x'));  // longer than the buffer
+        reference << std::string(300, 'x');
+        writer.close();
+    }
+
+    std::ifstream input_file_stream (filename);
+    std::stringstream contents;
+    contents << input_file_stream.rdbuf();
+    BOOST_CHECK_EQUAL(contents.str(), reference.str());
+
+
+    // A writer that isn't closed should leave the existing file intact
+    {
+        libwint::io::BufferedWriter writer (filename, 100);
+        writer.write(std::string(300, 'y'));
+    }
+    std::ifstream reopened_input_file_stream (filename);
+    std::stringstream reopened_contents;
+    reopened_contents << reopened_input_file_stream.rdbuf();
+    BOOST_CHECK_EQUAL(reopened_contents.str(), reference.str());
+
+    std::remove(filename.c_str());
+
+
+    // A write that fails (here because the file grows beyond the limit of the process, like on a full disk) shouldn't leave a truncated file behind
+    struct rlimit original_limit;
+    getrlimit(RLIMIT_FSIZE, &original_limit);
+    struct rlimit limit = original_limit;
+    limit.rlim_cur = 1000;
+    std::signal(SIGXFSZ, SIG_IGN);  // let the write fail instead of terminating the process
+    setrlimit(RLIMIT_FSIZE, &limit);
+    {
+        libwint::io::BufferedWriter writer (filename, 100);
+        BOOST_CHECK_THROW({
+            for (size_t i = 0; i < 100; i++) {
+                writer.write(std::string(100, 'z'));
+            }
+            writer.close();
+        }, std::runtime_error);
+    }
+    setrlimit(RLIMIT_FSIZE, &original_limit);
+    std::signal(SIGXFSZ, SIG_DFL);
+    BOOST_CHECK(!std::ifstream(filename).good());
+}
+
+
+BOOST_AUTO_TEST_CASE ( compressed_files ) {
+
+    BOOST_CHECK(libwint::io::detectCompression("../tests/ref_data/no_0.5_PB.one") == libwint::io::Compression::none);
+    BOOST_CHECK(libwint::io::detectCompression("../tests/ref_data/no_0.5_PB_gz.one.gz") == libwint::io::Compression::gzip);
+    BOOST_CHECK(libwint::io::detectCompression("../tests/ref_data/no_0.5_PB_zst.one.zst") == libwint::io::Compression::zstd);
+    BOOST_CHECK(libwint::io::isSupported(libwint::io::Compression::none));
+
+    BOOST_CHECK_EQUAL(libwint::io::resolveFilename("../tests/ref_data/no_0.5_PB.one"), "../tests/ref_data/no_0.5_PB.one");
+    BOOST_CHECK_EQUAL(libwint::io::resolveFilename("../tests/ref_data/no_0.5_PB_gz.one"), "../tests/ref_data/no_0.5_PB_gz.one.gz");
+    BOOST_CHECK_EQUAL(libwint::io::resolveFilename("../tests/ref_data/no_0.5_PB_zst.one"), "../tests/ref_data/no_0.5_PB_zst.one.zst");
+
+    std::ifstream input_file_stream ("../tests/ref_data/no_0.5_PB.two");
+    std::stringstream contents;
+    contents << input_file_stream.rdbuf();
+    BOOST_CHECK_EQUAL(libwint::io::readFile("../tests/ref_data/no_0.5_PB.two"), contents.str());
+
+
+    // Concatenated zstd frames are decompressed one after the other, and a truncated file is an error
+    if (libwint::io::isSupported(libwint::io::Compression::zstd)) {
+        BOOST_CHECK_EQUAL(libwint::io::readFile("../tests/ref_data/no_0.5_PB_zst.two.zst"), contents.str());
+
+        std::ifstream compressed_file_stream ("../tests/ref_data/no_0.5_PB_zst.two.zst", std::ifstream::binary);
+        std::stringstream compressed_contents;
+        compressed_contents << compressed_file_stream.rdbuf();
+        const std::string compressed = compressed_contents.str();
+
+        {
+            std::ofstream output_file_stream ("io_test_concatenated.two.zst", std::ofstream::binary);
+            output_file_stream << compressed << compressed;
+        }
+        BOOST_CHECK_EQUAL(libwint::io::readFile("io_test_concatenated.two.zst"), contents.str() + contents.str());
+
+        {
+            std::ofstream output_file_stream ("io_test_truncated.two.zst", std::ofstream::binary);
+            output_file_stream << compressed.substr(0, compressed.size() / 2);
+        }
+        BOOST_CHECK_THROW(libwint::io::readFile("io_test_truncated.two.zst"), std::runtime_error);
+
+        std::remove("io_test_concatenated.two.zst");
+        std::remove("io_test_truncated.two.zst");
+    } else {
+        BOOST_CHECK_THROW(libwint::io::DecompressingReader ("../tests/ref_data/no_0.5_PB_zst.two.zst"), std::runtime_error);
+    }
+
+
+    if (!libwint::io::isSupported(libwint::io::Compression::gzip)) {
+        BOOST_CHECK_THROW(libwint::io::DecompressingReader ("../tests/ref_data/no_0.5_PB_gz.two.gz"), std::runtime_error);
+        return;
+    }
+
+
+    // The decompressed text should be handed over in (small) chunks of whole lines
+    {
+        libwint::io::DecompressingReader reader ("../tests/ref_data/no_0.5_PB_gz.two.gz", 1000, 2);
+        std::string text;
+        std::vector<char> chunk;
+        size_t number_of_chunks = 0;
+        while (reader.read(chunk)) {
+            BOOST_REQUIRE(!chunk.empty());
+            BOOST_CHECK_EQUAL(chunk.back(), '\n');
+            text.append(chunk.begin(), chunk.end());
+            number_of_chunks++;
+        }
+        BOOST_CHECK_EQUAL(text, contents.str());
+        BOOST_CHECK(number_of_chunks > 1);
+    }
+
+
+    // A reader that is destroyed before all the chunks have been read should stop its background thread
+    {
+        libwint::io::DecompressingReader reader ("../tests/ref_data/no_0.5_PB_gz.two.gz", 1000, 2);
+        std::vector<char> chunk;
+        BOOST_CHECK(reader.read(chunk));
+    }
+
+
+    // Concatenated gzip members are decompressed one after the other, and a truncated file is an error
+    std::ifstream compressed_file_stream ("../tests/ref_data/no_0.5_PB_gz.two.gz", std::ifstream::binary);
+    std::stringstream compressed_contents;
+    compressed_contents << compressed_file_stream.rdbuf();
+    const std::string compressed = compressed_contents.str();
+
+    {
+        std::ofstream output_file_stream ("io_test_concatenated.two.gz", std::ofstream::binary);
+        output_file_stream << compressed << compressed;
+    }
+    BOOST_CHECK_EQUAL(libwint::io::readFile("io_test_concatenated.two.gz"), contents.str() + contents.str());
+
+    {
+        std::ofstream output_file_stream ("io_test_truncated.two.gz", std::ofstream::binary);
+        output_file_stream << compressed.substr(0, compressed.size() / 2);
+    }
+    BOOST_CHECK_THROW(libwint::io::readFile("io_test_truncated.two.gz"), std::runtime_error);
+
+    std::remove("io_test_concatenated.two.gz");
+    std::remove("io_test_truncated.two.gz");
+}
@@ -4,6 +4,7 @@
 #include "transformations.hpp"
 
 #include <cpputil.hpp>
+#include <cstdio>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/included/unit_test.hpp>
 
@@ -76,6 +77,27 @@ BOOST_AUTO_TEST_CASE ( transform_jacobi_mulliken ) {
     BOOST_REQUIRE(cpputil::linalg::areEqual(g_transformed_by_jacobi_matrix, so_basis.get_g_SO(), 1.0e-6));
 }
 
+BOOST_AUTO_TEST_CASE ( rotate_jacobi_sequence_mulliken ) {
+
+    libwint::SOMullikenBasis so_basis ("../tests/ref_data/no_0.5_PB", 10);
+    so_basis.calculateMullikenMatrix({0, 1, 2});
+
+    std::vector<libwint::transformations::JacobiRotationParameters> rotations {{0, 3, 0.2}, {1, 2, -0.5}, {0, 1, 1.1}, {4, 9, 0.7}};
+
+    // Applying the sequence at once should update the Mulliken matrix as well
+    libwint::SOMullikenBasis sequential_so_basis (10);
+    sequential_so_basis.copy(so_basis);
+    for (const auto& rotation : rotations) {
+        sequential_so_basis.rotateJacobi(rotation.p, rotation.q, rotation.angle);
+    }
+
+    so_basis.rotateJacobi(rotations);
+
+    BOOST_CHECK(so_basis.get_mulliken_matrix().isApprox(sequential_so_basis.get_mulliken_matrix(), 1.0e-12));
+    BOOST_CHECK(so_basis.get_h_SO().isApprox(sequential_so_basis.get_h_SO(), 1.0e-12));
+    BOOST_CHECK(cpputil::linalg::areEqual(so_basis.get_g_SO(), sequential_so_basis.get_g_SO(), 1.0e-12));
+}
+
 BOOST_AUTO_TEST_CASE ( mulliken_copy ) {
 
     // Create an SOBasis instance with a coefficient matrix being the identity matrix (little hack that we can use to test transformations)
@@ -108,4 +130,66 @@ BOOST_AUTO_TEST_CASE ( reader ) {
     BOOST_CHECK(true);
 
 
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE ( compressed_reader ) {
+
+    // Reading gzip-compressed files should give the same matrices as reading the plain files
+    if (libwint::io::isSupported(libwint::io::Compression::gzip)) {
+        libwint::SOMullikenBasis so_basis ("../tests/ref_data/no_0.5_PB", 10);
+        libwint::SOMullikenBasis compressed_so_basis ("../tests/ref_data/no_0.5_PB_gz", 10);
+
+        BOOST_CHECK(compressed_so_basis.get_C() == so_basis.get_C());
+        BOOST_CHECK(compressed_so_basis.get_S() == so_basis.get_S());
+    }
+}
+
+BOOST_AUTO_TEST_CASE ( mulliken_checkpoint ) {
+
+    std::string fcidump_filename = "../tests/ref_data/no_0.5_PB";
+    libwint::SOMullikenBasis so_basis (fcidump_filename, 10);
+    so_basis.calculateMullikenMatrix({0, 1, 2});
+    so_basis.set_lagrange_multiplier(0.3);
+
+    const std::string filename = "mulliken_test.chk";
+    so_basis.saveCheckpoint(filename);
+
+
+    // Loading the checkpoint should restore the integrals and the Mulliken data
+    libwint::SOMullikenBasis loaded_so_basis (10);
+    loaded_so_basis.loadCheckpoint(filename);
+
+    BOOST_CHECK(loaded_so_basis.get_h_SO().isApprox(so_basis.get_h_SO(), 1.0e-15));
+    BOOST_CHECK(cpputil::linalg::areEqual(loaded_so_basis.get_g_SO(), so_basis.get_g_SO(), 1.0e-15));
+    BOOST_CHECK_EQUAL(loaded_so_basis.get_lagrange_multiplier(), 0.3);
+    BOOST_CHECK(loaded_so_basis.get_mulliken_matrix() == so_basis.get_mulliken_matrix());
+    BOOST_CHECK(loaded_so_basis.get_C() == so_basis.get_C());
+    BOOST_CHECK(loaded_so_basis.get_S() == so_basis.get_S());
+
+
+    // A checkpoint of a plain SOBasis has no Mulliken data
+    libwint::SOBasis plain_so_basis (10);
+    plain_so_basis.loadCheckpoint(filename);
+    plain_so_basis.saveCheckpoint(filename);
+    BOOST_CHECK_THROW(loaded_so_basis.loadCheckpoint(filename), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE ( mulliken_write_fcidump ) {
+
+    libwint::SOMullikenBasis so_basis ("../tests/ref_data/no_0.5_PB", 10);
+    so_basis.calculateMullikenMatrix({0, 1, 2});
+    so_basis.set_lagrange_multiplier(0.3);
+
+    // The written one-electron integrals include the Mulliken constraint
+    const std::string filename = "mulliken_test.FCIDUMP";
+    so_basis.writeFCIDUMPFile(filename, 14);
+
+    libwint::SOBasis read_so_basis (filename, 10);
+    BOOST_CHECK(read_so_basis.get_h_SO().isApprox(so_basis.get_h_SO(), 1.0e-14));
+    BOOST_CHECK(cpputil::linalg::areEqual(read_so_basis.get_g_SO(), so_basis.get_g_SO(), 1.0e-15));
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,58 @@
+#define BOOST_TEST_MODULE "threading"
+
+
+#include "threading.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/included/unit_test.hpp>  // include this to get main(), otherwise clang++ will complain
+
+
+
+BOOST_AUTO_TEST_CASE ( number_of_threads ) {
+
+    // A non-zero request should be honoured
+    BOOST_CHECK_EQUAL(libwint::threading::numberOfThreads(3), 3);
+
+    // A zero request should fall back to the environment variable
+    setenv("LIBWINT_NUM_THREADS", "5", 1);
+    BOOST_CHECK_EQUAL(libwint::threading::numberOfThreads(0), 5);
+
+    setenv("LIBWINT_NUM_THREADS", "five", 1);
+    BOOST_CHECK_THROW(libwint::threading::numberOfThreads(0), std::invalid_argument);
+
+    // ... or to the hardware, but we should always get at least one thread
+    unsetenv("LIBWINT_NUM_THREADS");
+    BOOST_CHECK(libwint::threading::numberOfThreads(0) >= 1);
+}
+
+
+BOOST_AUTO_TEST_CASE ( parallel_for ) {
+
+    // Every thread should run exactly once
+    size_t number_of_threads = 4;
+    std::vector<size_t> runs (number_of_threads, 0);
+    std::atomic<size_t> total (0);
+
+    libwint::threading::parallelFor(number_of_threads, [&runs, &total] (size_t thread_id) {
+        runs[thread_id]++;
+        total++;
+    });
+
+    BOOST_CHECK_EQUAL(total, number_of_threads);
+    for (const auto& run : runs) {
+        BOOST_CHECK_EQUAL(run, 1);
+    }
+
+
+    // Exceptions should be propagated to the calling thread
+    BOOST_CHECK_THROW(libwint::threading::parallelFor(number_of_threads, [] (size_t thread_id) {
+        if (thread_id == 2) {
+            throw std::runtime_error("thread 2 failed");
+        }
+    }), std::runtime_error);
+}
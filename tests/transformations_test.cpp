@@ -12,6 +12,53 @@
 
 
 
+namespace {
+
+/**
+ *  Transform the two-electron integrals @param: g with the transformation matrix @param: T (as in transformTwoElectronIntegrals) by chaining four Eigen tensor contractions
+ *
+ *  This is the reference implementation to test transformTwoElectronIntegrals against
+ */
+Eigen::Tensor<double, 4> transformTwoElectronIntegralsByContractions(const Eigen::Tensor<double, 4>& g, const Eigen::MatrixXd& T) {
+
+    // Since we're only getting T as a matrix, we should make the appropriate tensor to perform contractions
+    // For the const Eigen::MatrixXd& argument, we need the const double in the template
+    //      For more info, see: https://stackoverflow.com/questions/45283468/eigen-const-tensormap
+    Eigen::TensorMap<Eigen::Tensor<const double, 2>> T_tensor (T.data(), T.rows(), T.cols());
+
+
+    // We will have to do four single contractions, so we specify the contraction indices
+    // Eigen3 does not document its tensor contraction clearly, so see the accepted answer on stackoverflow (https://stackoverflow.com/a/47558349/7930415):
+    //      Eigen3 does not accept a way to specify the output axes: instead, it retains the order from left to right of the axes that survive the contraction.
+    //      This means that, in order to get the right ordering of the axes, we will have to swap axes
+
+    // g(T U V W)  T^*(V R) -> a(T U R W) but we get a(T U W R)
+    Eigen::array<Eigen::IndexPair<int>, 1> contraction_pair1 = {Eigen::IndexPair<int>(2, 0)};
+    Eigen::array<int, 4> shuffle_1 {0, 1, 3, 2};
+
+    // a(T U R W)  T(W S) -> b(T U R S) and we get b(T U R S), so no shuffle is needed
+    Eigen::array<Eigen::IndexPair<int>, 1> contraction_pair2 = {Eigen::IndexPair<int>(3, 0)};
+
+    // T(U Q)  b(T U R S) -> c(T Q R S) but we get c(Q T R S)
+    Eigen::array<Eigen::IndexPair<int>, 1> contraction_pair3 = {Eigen::IndexPair<int>(0, 1)};
+    Eigen::array<int, 4> shuffle_3 {1, 0, 2, 3};
+
+    // T^*(T P)  c(T Q R S) -> g'(P Q R S) and we get g_SO(p q r s), so no shuffle is needed
+    Eigen::array<Eigen::IndexPair<int>, 1> contraction_pair4 = {Eigen::IndexPair<int>(0, 0)};
+
+
+    // Calculate the contractions. We write this as one large contraction to
+    //  1) avoid storing intermediate contractions
+    //  2) let Eigen3 figure out some optimizations
+    Eigen::Tensor<double, 4> g_transformed = T_tensor.conjugate().contract(T_tensor.contract(g.contract(T_tensor.conjugate(), contraction_pair1).shuffle(shuffle_1).contract(T_tensor, contraction_pair2), contraction_pair3).shuffle(shuffle_3), contraction_pair4);
+
+    return g_transformed;
+}
+
+}  // anonymous namespace
+
+
+
 BOOST_AUTO_TEST_CASE ( transform_one_electron_trivial ) {
 
     // Let's test a trivial transformation: i.e. with C being a unit matrix
@@ -175,3 +222,140 @@ BOOST_AUTO_TEST_CASE ( lih_jacobi_transformations ) {
     cpputil::io::readArrayFromFile("../tests/ref_data/lih_hf_sto6g_twoint_rotated.data", g_SO_rotated_olsens);
     BOOST_CHECK(cpputil::linalg::areEqual(g_SO_rotated, g_SO_rotated_olsens, 1.0e-06));
 }
+
+
+BOOST_AUTO_TEST_CASE ( jacobi_rotation_in_place ) {
+
+    // An in-place Jacobi rotation should give the same integrals as a transformation with the Jacobi rotation matrix
+    size_t K = 7;
+    Eigen::MatrixXd h = Eigen::MatrixXd::Random(K, K);
+    h = h + h.transpose().eval();
+    Eigen::Tensor<double, 4> g (K, K, K, K);
+    g.setRandom();
+
+    for (size_t p = 0; p < K; p++) {
+        for (size_t q = p + 1; q < K; q++) {
+            double theta = 0.1 * static_cast<double>(p + 1) - 0.37 * static_cast<double>(q);
+            Eigen::MatrixXd J = libwint::transformations::jacobiRotationMatrix(p, q, theta, K);
+
+            Eigen::MatrixXd h_rotated = h;
+            libwint::transformations::rotateOneElectronIntegralsJacobiInPlace(h_rotated, p, q, theta);
+            BOOST_CHECK(h_rotated.isApprox(libwint::transformations::transformOneElectronIntegrals(h, J), 1.0e-12));
+
+            Eigen::Tensor<double, 4> g_rotated = g;
+            libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(g_rotated, p, q, theta);
+            BOOST_CHECK(cpputil::linalg::areEqual(g_rotated, libwint::transformations::transformTwoElectronIntegrals(g, J), 1.0e-12));
+        }
+    }
+
+
+    // The Jacobi parameters are checked
+    BOOST_CHECK_THROW(libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(g, 3, 2, 0.5), std::invalid_argument);
+    BOOST_CHECK_THROW(libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(g, 2, K, 0.5), std::invalid_argument);
+}
+
+
+BOOST_AUTO_TEST_CASE ( jacobi_rotation_sequence ) {
+
+    size_t K = 9;
+    Eigen::MatrixXd h = Eigen::MatrixXd::Random(K, K);
+    h = h + h.transpose().eval();
+    Eigen::Tensor<double, 4> g (K, K, K, K);
+    g.setRandom();
+
+    // A sweep over all the pairs (p,q), with some overlapping rotations
+    std::vector<libwint::transformations::JacobiRotationParameters> rotations;
+    for (size_t p = 0; p < K; p++) {
+        for (size_t q = p + 1; q < K; q++) {
+            rotations.push_back({p, q, 0.05 * static_cast<double>(p) - 0.13 * static_cast<double>(q) + 0.4});
+        }
+    }
+
+
+    // Applying the sequence at once should be the same as applying the rotations one by one
+    Eigen::MatrixXd h_sequential = h;
+    Eigen::Tensor<double, 4> g_sequential = g;
+    for (const auto& rotation : rotations) {
+        libwint::transformations::rotateOneElectronIntegralsJacobiInPlace(h_sequential, rotation.p, rotation.q, rotation.angle);
+        libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(g_sequential, rotation.p, rotation.q, rotation.angle);
+    }
+
+    Eigen::MatrixXd h_rotated = h;
+    Eigen::Tensor<double, 4> g_rotated = g;
+    libwint::transformations::rotateOneElectronIntegralsJacobiInPlace(h_rotated, rotations);
+    libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(g_rotated, rotations);
+
+    BOOST_CHECK(h_rotated.isApprox(h_sequential, 1.0e-12));
+    BOOST_CHECK(cpputil::linalg::areEqual(g_rotated, g_sequential, 1.0e-12));
+
+
+    // ... and the same as a transformation with the product of the Jacobi rotation matrices
+    Eigen::MatrixXd U = libwint::transformations::jacobiRotationMatrix(rotations, K);
+    BOOST_CHECK((U.transpose() * U).isApprox(Eigen::MatrixXd::Identity(K, K), 1.0e-12));
+    BOOST_CHECK(cpputil::linalg::areEqual(libwint::transformations::transformTwoElectronIntegrals(g, U), g_sequential, 1.0e-12));
+
+
+    // The rotations are checked before anything is rotated
+    rotations.push_back({3, 3, 0.1});
+    BOOST_CHECK_THROW(libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(g_rotated, rotations), std::invalid_argument);
+    BOOST_CHECK(cpputil::linalg::areEqual(g_rotated, g_sequential, 1.0e-12));
+
+
+    // An empty sequence leaves the integrals as they are, also for an empty tensor
+    Eigen::Tensor<double, 4> g_unrotated = g_rotated;
+    libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(g_rotated, {});
+    BOOST_CHECK(cpputil::linalg::areEqual(g_rotated, g_unrotated, 1.0e-15));
+
+    Eigen::Tensor<double, 4> g_empty (0, 0, 0, 0);
+    BOOST_CHECK_NO_THROW(libwint::transformations::rotateTwoElectronIntegralsJacobiInPlace(g_empty, {}));
+}
+
+
+BOOST_AUTO_TEST_CASE ( quarter_transformations ) {
+
+    // The quarter transformations should give the same integrals as the tensor contractions, for square and rectangular transformation matrices
+    Eigen::Tensor<double, 4> g_h2o (7, 7, 7, 7);
+    cpputil::io::readArrayFromFile("../tests/ref_data/h2o_sto-3g_two_electron.data", g_h2o);
+    Eigen::Tensor<double, 4> g_lih (6, 6, 6, 6);
+    cpputil::io::readArrayFromFile("../tests/ref_data/lih_hf_sto6g_twoint.data", g_lih);
+
+    for (const auto* g : {&g_h2o, &g_lih}) {
+        const auto K = g->dimension(0);
+
+        for (auto M : {K, K / 2}) {
+            Eigen::MatrixXd T = Eigen::MatrixXd::Random(K, M);
+
+            Eigen::Tensor<double, 4> g_quarters = libwint::transformations::transformTwoElectronIntegrals(*g, T);
+            BOOST_CHECK_EQUAL(g_quarters.dimension(0), M);
+            BOOST_CHECK(cpputil::linalg::areEqual(g_quarters, transformTwoElectronIntegralsByContractions(*g, T), 1.0e-10));
+        }
+    }
+
+
+    // The dimensions should match
+    BOOST_CHECK_THROW(libwint::transformations::transformTwoElectronIntegrals(g_h2o, Eigen::MatrixXd::Identity(6, 6)), std::invalid_argument);
+}
+
+
+BOOST_AUTO_TEST_CASE ( packed_transformation ) {
+
+    // Transforming only the unique integrals should give the unique elements of the full transformation, for square and rectangular transformation matrices and any number of threads
+    Eigen::Tensor<double, 4> g_h2o (7, 7, 7, 7);
+    cpputil::io::readArrayFromFile("../tests/ref_data/h2o_sto-3g_two_electron.data", g_h2o);
+
+    for (Eigen::Index M : {7, 4}) {
+        Eigen::MatrixXd T = Eigen::MatrixXd::Random(7, M);
+        libwint::PackedERITensor g_reference (libwint::transformations::transformTwoElectronIntegrals(g_h2o, T));
+
+        for (size_t number_of_threads : {1, 3}) {
+            libwint::PackedERITensor g_packed = libwint::transformations::transformTwoElectronIntegralsPacked(g_h2o, T, number_of_threads);
+
+            BOOST_CHECK_EQUAL(g_packed.get_K(), M);
+            BOOST_CHECK(g_packed.isApprox(g_reference, 1.0e-10));
+        }
+    }
+
+
+    // The dimensions should match
+    BOOST_CHECK_THROW(libwint::transformations::transformTwoElectronIntegralsPacked(g_h2o, Eigen::MatrixXd::Identity(6, 6)), std::invalid_argument);
+}